@@ -122,8 +122,9 @@ syntax keyword vifmOption contained aproposprg autochpos caseoptions cdpath cd
 		\ chaselinks classify columns co confirm cf cpoptions cpo cvoptions
 		\ deleteprg dotdirs dotfiles dirsize fastrun fillchars fcs findprg
 		\ followlinks fusehome gdefault grepprg history hi hlsearch hls iec
-		\ ignorecase ic iooptions incsearch is laststatus lines locateprg ls lsview
-		\ mintimeoutlen number nu numberwidth nuw relativenumber rnu rulerformat ruf
+		\ ignorecase ic iooptions iothreads incsearch is laststatus lines locateprg
+		\ ls lsview mintimeoutlen number nu numberwidth nuw relativenumber rnu
+		\ rulerformat ruf
 		\ runexec scrollbind scb scrolloff so sort sortgroups sortorder sortnumbers
 		\ shell sh shortmess shm sizefmt slowfs smartcase scs statusline stl
 		\ suggestoptions syscalls tabstop timefmt timeoutlen title tm trash trashdir
@@ -24,8 +24,8 @@
 #endif
 
 #include <fcntl.h> /* open() */
-#include <sys/stat.h> /* O_RDONLY */
-#include <sys/types.h> /* pid_t ssize_t */
+#include <sys/stat.h> /* O_RDONLY stat */
+#include <sys/types.h> /* dev_t pid_t ssize_t */
 #ifndef _WIN32
 #include <sys/select.h> /* FD_* select */
 #include <sys/time.h> /* timeval */
@@ -41,7 +41,9 @@
 #include <string.h> /* memcpy() */
 
 #include "cfg/config.h"
+#include "compat/os.h"
 #include "compat/pthread.h"
+#include "compat/reallocarray.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "ui/statusline.h"
 #include "utils/cancellation.h"
@@ -64,6 +66,16 @@
  *
  * All jobs can be viewed via :jobs menu.
  *
+ * Operations that work with the same device are run one after another to
+ * avoid competing for it.  Such operations are put into a queue and when an
+ * operation finishes, its thread picks queued operation for the same device
+ * with the highest priority (the first one among equals) and runs it.
+ *
+ * Tasks and operations can be paused.  Paused queued operations are skipped
+ * when picking the next one and are started on resuming if their device is
+ * free at that moment.  Running jobs stop inside bg_op_cancelled() called by
+ * themselves, which is where they check for cancellation.
+ *
  * Tasks and operations can provide progress information for displaying it in
  * UI.
  *
@@ -100,11 +112,17 @@
 
 /* Structure with passed to background_task_bootstrap() so it can perform
  * correct initialization/cleanup. */
-typedef struct
+typedef struct background_task_args
 {
 	bg_task_func func; /* Function to execute in a background thread. */
 	void *args;        /* Argument to pass. */
 	bg_job_t *job;     /* Job identifier that corresponds to the task. */
+
+	char *op_descr; /* Description to set on starting queued task or NULL. */
+	int has_dev;    /* Whether the task occupies the device specified below. */
+	dev_t dev;      /* Device used by the task. */
+
+	struct background_task_args *next; /* Next task in the queue. */
 }
 background_task_args;
 
@@ -121,10 +139,18 @@ static bg_job_t * add_background_job(pid_t pid, const char cmd[], int fd,
 static bg_job_t * add_background_job(pid_t pid, const char cmd[],
 		HANDLE hprocess, BgJobType type);
 #endif
+static int start_task(background_task_args *task_args);
+static int occupy_device(dev_t dev);
+static background_task_args * next_device_task(dev_t dev);
+static void start_resumed_task(bg_job_t *job);
 static void * background_task_bootstrap(void *arg);
+static void free_task_args(background_task_args *task_args);
+static void start_cancelled_task(bg_job_t *job);
 static void set_current_job(bg_job_t *job);
+static bg_job_t * get_current_job(void);
 static void make_current_job_key(void);
 static int bg_op_cancel(bg_op_t *bg_op);
+static void wait_while_paused(bg_op_t *bg_op);
 
 bg_job_t *bg_jobs = NULL;
 
@@ -139,6 +165,20 @@ static pthread_cond_t new_err_jobs_cond = PTHREAD_COND_INITIALIZER;
 
 /* Thread local storage for bg_job_t associated with active thread. */
 static pthread_key_t current_job;
+/* Guards initialization of current_job. */
+static pthread_once_t current_job_once = PTHREAD_ONCE_INIT;
+
+/* Protects queued_tasks, busy_devs, nbusy_devs as well as paused and priority
+ * fields of jobs. */
+static pthread_mutex_t sched_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Signals resuming of jobs (used along with sched_lock). */
+static pthread_cond_t resume_cond = PTHREAD_COND_INITIALIZER;
+/* Head of queue of operations waiting for their devices to become free. */
+static background_task_args *queued_tasks;
+/* Devices on which operations are running. */
+static dev_t *busy_devs;
+/* Number of elements in busy_devs array. */
+static int nbusy_devs;
 
 void
 bg_init(void)
@@ -922,10 +962,10 @@ bg_run_external(const char cmd[], int skip_errors)
 
 int
 bg_execute(const char descr[], const char op_descr[], int total, int important,
-		bg_task_func task_func, void *args)
+		const char path[], bg_task_func task_func, void *args)
 {
-	pthread_t id;
-	int ret;
+	struct stat st;
+	int queued;
 
 	background_task_args *const task_args = malloc(sizeof(*task_args));
 	if(task_args == NULL)
@@ -937,6 +977,10 @@ bg_execute(const char descr[], const char op_descr[], int total, int important,
 	task_args->args = args;
 	task_args->job = add_background_job(WRONG_PID, descr, NO_JOB_ID,
 			important ? BJT_OPERATION : BJT_TASK);
+	task_args->op_descr = NULL;
+	task_args->has_dev = (important && path != NULL && os_stat(path, &st) == 0);
+	task_args->dev = task_args->has_dev ? st.st_dev : 0;
+	task_args->next = NULL;
 
 	if(task_args->job == NULL)
 	{
@@ -952,20 +996,148 @@ bg_execute(const char descr[], const char op_descr[], int total, int important,
 		ui_stat_job_bar_add(&task_args->job->bg_op);
 	}
 
-	ret = 0;
-	if(pthread_create(&id, NULL, &background_task_bootstrap, task_args) != 0)
+	queued = 0;
+	if(task_args->has_dev)
 	{
-		/* Mark job as finished with error. */
-		pthread_spin_lock(&task_args->job->status_lock);
-		task_args->job->running = 0;
-		task_args->job->exit_code = 1;
-		pthread_spin_unlock(&task_args->job->status_lock);
+		pthread_mutex_lock(&sched_lock);
+		if(occupy_device(task_args->dev) != 0)
+		{
+			background_task_args **tail = &queued_tasks;
+			while(*tail != NULL)
+			{
+				tail = &(*tail)->next;
+			}
 
-		free(task_args);
-		ret = 1;
+			task_args->op_descr = strdup(op_descr);
+			replace_string(&task_args->job->bg_op.descr, "queued");
+			task_args->job->queued = 1;
+			*tail = task_args;
+			queued = 1;
+		}
+		pthread_mutex_unlock(&sched_lock);
+	}
+
+	return queued ? 0 : start_task(task_args);
+}
+
+/* Runs the task in a new thread.  Returns zero on success, otherwise non-zero
+ * is returned. */
+static int
+start_task(background_task_args *task_args)
+{
+	pthread_t id;
+
+	if(pthread_create(&id, NULL, &background_task_bootstrap, task_args) == 0)
+	{
+		return 0;
+	}
+
+	/* Mark job as finished with error. */
+	pthread_spin_lock(&task_args->job->status_lock);
+	task_args->job->running = 0;
+	task_args->job->queued = 0;
+	task_args->job->exit_code = 1;
+	pthread_spin_unlock(&task_args->job->status_lock);
+
+	if(task_args->has_dev)
+	{
+		/* Let operations queued for the device proceed. */
+		background_task_args *const next = next_device_task(task_args->dev);
+		if(next != NULL)
+		{
+			(void)start_task(next);
+		}
+	}
+
+	free_task_args(task_args);
+	return 1;
+}
+
+/* Marks the device as being used by an operation.  Must be called with
+ * sched_lock held.  Returns zero on success and non-zero if the device is
+ * already busy. */
+static int
+occupy_device(dev_t dev)
+{
+	int i;
+	dev_t *new_devs;
+
+	for(i = 0; i < nbusy_devs; ++i)
+	{
+		if(busy_devs[i] == dev)
+		{
+			return 1;
+		}
+	}
+
+	new_devs = reallocarray(busy_devs, nbusy_devs + 1, sizeof(*busy_devs));
+	if(new_devs != NULL)
+	{
+		busy_devs = new_devs;
+		busy_devs[nbusy_devs++] = dev;
+	}
+	/* Not being able to remember the device just disables queueing. */
+	return 0;
+}
+
+/* Picks next queued operation for the device, which keeps the device busy, or
+ * frees the device if there are no such operations.  Returns the operation or
+ * NULL. */
+static background_task_args *
+next_device_task(dev_t dev)
+{
+	int i;
+	background_task_args **task_args;
+	background_task_args **best = NULL;
+	background_task_args *next = NULL;
+
+	pthread_mutex_lock(&sched_lock);
+
+	for(task_args = &queued_tasks; *task_args != NULL;
+			task_args = &(*task_args)->next)
+	{
+		const bg_job_t *const job = (*task_args)->job;
+		if(!(*task_args)->has_dev || (*task_args)->dev != dev || job->paused)
+		{
+			continue;
+		}
+
+		if(best == NULL || job->priority > (*best)->job->priority)
+		{
+			best = task_args;
+		}
+	}
+
+	if(best != NULL)
+	{
+		next = *best;
+		*best = next->next;
+		next->next = NULL;
+	}
+	else
+	{
+		for(i = 0; i < nbusy_devs; ++i)
+		{
+			if(busy_devs[i] == dev)
+			{
+				busy_devs[i] = busy_devs[--nbusy_devs];
+				break;
+			}
+		}
 	}
 
-	return ret;
+	pthread_mutex_unlock(&sched_lock);
+
+	if(next != NULL)
+	{
+		pthread_spin_lock(&next->job->status_lock);
+		next->job->queued = 0;
+		pthread_spin_unlock(&next->job->status_lock);
+
+		bg_op_set_descr(&next->job->bg_op, next->op_descr);
+	}
+
+	return next;
 }
 
 /* Creates structure that describes background job and registers it in the list
@@ -998,8 +1170,11 @@ add_background_job(pid_t pid, const char cmd[], HANDLE hprocess, BgJobType type)
 	pthread_spin_init(&new->errors_lock, PTHREAD_PROCESS_PRIVATE);
 	pthread_spin_init(&new->status_lock, PTHREAD_PROCESS_PRIVATE);
 	new->running = 1;
+	new->queued = 0;
 	new->in_use = (type == BJT_COMMAND);
 	new->exit_code = -1;
+	new->paused = 0;
+	new->priority = 0;
 
 #ifndef _WIN32
 	new->fd = fd;
@@ -1030,40 +1205,64 @@ add_background_job(pid_t pid, const char cmd[], HANDLE hprocess, BgJobType type)
 }
 
 /* pthreads entry point for a new background task.  Performs correct
- * startup/exit with related updates of internal data structures.  Returns
- * result for this thread. */
+ * startup/exit with related updates of internal data structures.  Also runs
+ * operations queued for the same device after the task.  Returns result for
+ * this thread. */
 static void *
 background_task_bootstrap(void *arg)
 {
-	background_task_args *const task_args = arg;
+	background_task_args *task_args = arg;
 
 	(void)pthread_detach(pthread_self());
 	block_all_thread_signals();
-	set_current_job(task_args->job);
 
-	task_args->func(&task_args->job->bg_op, task_args->args);
+	while(task_args != NULL)
+	{
+		background_task_args *next;
 
-	/* Mark task as finished normally. */
-	pthread_spin_lock(&task_args->job->status_lock);
-	task_args->job->running = 0;
-	task_args->job->exit_code = 0;
-	pthread_spin_unlock(&task_args->job->status_lock);
+		set_current_job(task_args->job);
 
-	free(task_args);
+		task_args->func(&task_args->job->bg_op, task_args->args);
+
+		/* Mark task as finished normally. */
+		pthread_spin_lock(&task_args->job->status_lock);
+		task_args->job->running = 0;
+		task_args->job->exit_code = 0;
+		pthread_spin_unlock(&task_args->job->status_lock);
+
+		next = task_args->has_dev ? next_device_task(task_args->dev) : NULL;
+		free_task_args(task_args);
+		task_args = next;
+	}
 
 	return NULL;
 }
 
+/* Frees structure describing a task. */
+static void
+free_task_args(background_task_args *task_args)
+{
+	free(task_args->op_descr);
+	free(task_args);
+}
+
 /* Stores pointer to the job in a thread-local storage. */
 static void
 set_current_job(bg_job_t *job)
 {
-	static pthread_once_t once = PTHREAD_ONCE_INIT;
-	pthread_once(&once, &make_current_job_key);
-
+	pthread_once(&current_job_once, &make_current_job_key);
 	(void)pthread_setspecific(current_job, job);
 }
 
+/* Retrieves pointer to the job from a thread-local storage.  Returns the
+ * pointer, which is NULL for threads that don't run jobs. */
+static bg_job_t *
+get_current_job(void)
+{
+	pthread_once(&current_job_once, &make_current_job_key);
+	return pthread_getspecific(current_job);
+}
+
 /* current_job initializer for pthread_once(). */
 static void
 make_current_job_key(void)
@@ -1122,7 +1321,16 @@ bg_job_cancel(bg_job_t *job)
 
 	if(job->type != BJT_COMMAND)
 	{
-		return !bg_op_cancel(&job->bg_op);
+		was_cancelled = bg_op_cancel(&job->bg_op);
+
+		/* Paused job can't react to cancellation. */
+		pthread_mutex_lock(&sched_lock);
+		job->paused = 0;
+		pthread_cond_broadcast(&resume_cond);
+		pthread_mutex_unlock(&sched_lock);
+
+		start_cancelled_task(job);
+		return !was_cancelled;
 	}
 
 	was_cancelled = job->cancelled;
@@ -1170,6 +1378,158 @@ bg_job_is_running(bg_job_t *job)
 	return running;
 }
 
+int
+bg_job_is_queued(bg_job_t *job)
+{
+	int queued;
+	pthread_spin_lock(&job->status_lock);
+	queued = job->queued;
+	pthread_spin_unlock(&job->status_lock);
+	return queued;
+}
+
+int
+bg_job_pause(bg_job_t *job)
+{
+	int was_paused;
+
+	if(job->type == BJT_COMMAND || bg_op_cancelled(&job->bg_op))
+	{
+		return 0;
+	}
+
+	pthread_mutex_lock(&sched_lock);
+	was_paused = job->paused;
+	job->paused = 1;
+	pthread_mutex_unlock(&sched_lock);
+
+	bg_op_changed(&job->bg_op);
+	return !was_paused;
+}
+
+int
+bg_job_resume(bg_job_t *job)
+{
+	int was_paused;
+
+	pthread_mutex_lock(&sched_lock);
+	was_paused = job->paused;
+	job->paused = 0;
+	pthread_cond_broadcast(&resume_cond);
+	pthread_mutex_unlock(&sched_lock);
+
+	if(was_paused)
+	{
+		start_resumed_task(job);
+		bg_op_changed(&job->bg_op);
+	}
+	return was_paused;
+}
+
+int
+bg_job_is_paused(bg_job_t *job)
+{
+	int paused;
+	pthread_mutex_lock(&sched_lock);
+	paused = job->paused;
+	pthread_mutex_unlock(&sched_lock);
+	return paused;
+}
+
+void
+bg_job_set_priority(bg_job_t *job, int priority)
+{
+	pthread_mutex_lock(&sched_lock);
+	job->priority = priority;
+	pthread_mutex_unlock(&sched_lock);
+}
+
+int
+bg_job_get_priority(bg_job_t *job)
+{
+	int priority;
+	pthread_mutex_lock(&sched_lock);
+	priority = job->priority;
+	pthread_mutex_unlock(&sched_lock);
+	return priority;
+}
+
+/* Starts resumed job if it's queued and its device is free, which can happen if
+ * it was skipped while being paused. */
+static void
+start_resumed_task(bg_job_t *job)
+{
+	background_task_args **task_args;
+	background_task_args *found = NULL;
+
+	pthread_mutex_lock(&sched_lock);
+	for(task_args = &queued_tasks; *task_args != NULL;
+			task_args = &(*task_args)->next)
+	{
+		if((*task_args)->job == job)
+		{
+			if(occupy_device((*task_args)->dev) == 0)
+			{
+				found = *task_args;
+				*task_args = found->next;
+				found->next = NULL;
+			}
+			break;
+		}
+	}
+	pthread_mutex_unlock(&sched_lock);
+
+	if(found == NULL)
+	{
+		return;
+	}
+
+	pthread_spin_lock(&job->status_lock);
+	job->queued = 0;
+	pthread_spin_unlock(&job->status_lock);
+
+	bg_op_set_descr(&job->bg_op, found->op_descr);
+	(void)start_task(found);
+}
+
+/* Removes the job from the queue if it's there and starts it right away to let
+ * it finish, it's expected to quit early as it's cancelled. */
+static void
+start_cancelled_task(bg_job_t *job)
+{
+	background_task_args **task_args;
+	background_task_args *found = NULL;
+
+	pthread_mutex_lock(&sched_lock);
+	for(task_args = &queued_tasks; *task_args != NULL;
+			task_args = &(*task_args)->next)
+	{
+		if((*task_args)->job == job)
+		{
+			found = *task_args;
+			*task_args = found->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&sched_lock);
+
+	if(found == NULL)
+	{
+		return;
+	}
+
+	/* The task doesn't occupy the device, which is used by another operation. */
+	found->has_dev = 0;
+	found->next = NULL;
+
+	pthread_spin_lock(&job->status_lock);
+	job->queued = 0;
+	pthread_spin_unlock(&job->status_lock);
+
+	bg_op_set_descr(&job->bg_op, found->op_descr);
+	(void)start_task(found);
+}
+
 void
 bg_op_lock(bg_op_t *bg_op)
 {
@@ -1221,6 +1581,8 @@ bg_op_cancelled(bg_op_t *bg_op)
 {
 	int cancelled;
 
+	wait_while_paused(bg_op);
+
 	bg_op_lock(bg_op);
 	cancelled = bg_op->cancelled;
 	bg_op_unlock(bg_op);
@@ -1228,5 +1590,24 @@ bg_op_cancelled(bg_op_t *bg_op)
 	return cancelled;
 }
 
+/* Blocks while job of the operation is paused, but only if it's called by the
+ * job itself. */
+static void
+wait_while_paused(bg_op_t *bg_op)
+{
+	bg_job_t *const job = STRUCT_FROM_FIELD(bg_job_t, bg_op, bg_op);
+	if(get_current_job() != job)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&sched_lock);
+	while(job->paused)
+	{
+		pthread_cond_wait(&resume_cond, &sched_lock);
+	}
+	pthread_mutex_unlock(&sched_lock);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -77,10 +77,16 @@ typedef struct bg_job_t
 	/* The lock is meant to guard state-related fields. */
 	pthread_spinlock_t status_lock;
 	int running;   /* Whether this job is still running. */
+	int queued;    /* Whether this job waits for its turn to start. */
 	int in_use;    /* Whether this job description is in use by someone. */
 	/* TODO: use or remove this (set to correct value, but not used). */
 	int exit_code; /* Exit code of external command. */
 
+	/* These are guarded by internal lock of the scheduler, use bg_job_*()
+	 * functions to access them. */
+	int paused;   /* Whether this job shouldn't make any progress. */
+	int priority; /* Higher priority moves job closer to the head of queue. */
+
 	/* For background operations and tasks. */
 	pthread_spinlock_t bg_op_lock;
 	bg_op_t bg_op;
@@ -138,10 +144,12 @@ void bg_process_finished_cb(pid_t pid, int exit_code);
  * needed. */
 void bg_check(void);
 
-/* Starts new background task, which is run in a separate thread.  Returns zero
- * on success, otherwise non-zero is returned. */
+/* Starts new background task, which is run in a separate thread.  Important
+ * operations that specify path (can be NULL) are queued and run one at a time
+ * per device on which the path resides in order of their priority and
+ * submission.  Returns zero on success, otherwise non-zero is returned. */
 int bg_execute(const char descr[], const char op_descr[], int total,
-		int important, bg_task_func task_func, void *args);
+		int important, const char path[], bg_task_func task_func, void *args);
 
 /* Checks whether there are any internal jobs (not external applications tracked
  * by vifm) running in background. */
@@ -167,6 +175,32 @@ int bg_job_cancelled(bg_job_t *job);
  * zero is returned. */
 int bg_job_is_running(bg_job_t *job);
 
+/* Checks whether the job waits for other operations to finish before starting.
+ * Returns non-zero if so, otherwise zero is returned. */
+int bg_job_is_queued(bg_job_t *job);
+
+/* Pauses operation or task (external commands can't be paused).  Running job
+ * stops at its next check for cancellation and waits there until it's resumed
+ * or cancelled, its device stays occupied meanwhile.  Queued job isn't started
+ * until it's resumed.  Returns non-zero if the job was paused by this call,
+ * otherwise zero is returned. */
+int bg_job_pause(bg_job_t *job);
+
+/* Resumes paused job.  Returns non-zero if the job was paused, otherwise zero
+ * is returned. */
+int bg_job_resume(bg_job_t *job);
+
+/* Checks whether the job is paused.  Returns non-zero if so, otherwise zero is
+ * returned. */
+int bg_job_is_paused(bg_job_t *job);
+
+/* Sets priority of the job, which defines order in which queued operations are
+ * started: higher priority goes first, then the one that was queued first. */
+void bg_job_set_priority(bg_job_t *job, int priority);
+
+/* Retrieves priority of the job.  Returns the priority. */
+int bg_job_get_priority(bg_job_t *job);
+
 /* Temporary locks bg_op_t structure to ensure that it's not modified by
  * anyone during reading/updating its fields.  The structure must be part of
  * bg_job_t. */
@@ -185,8 +219,9 @@ void bg_op_changed(bg_op_t *bg_op);
 void bg_op_set_descr(bg_op_t *bg_op, const char descr[]);
 
 /* Convenience method to check for background job cancellation, use
- * lock -> <check> -> unlock -> changed sequence for more generic cases.
- * Returns non-zero if cancellation requested, otherwise zero is returned. */
+ * lock -> <check> -> unlock -> changed sequence for more generic cases.  When
+ * called by the job itself, blocks while the job is paused.  Returns non-zero
+ * if cancellation requested, otherwise zero is returned. */
 int bg_op_cancelled(bg_op_t *bg_op);
 
 #endif /* VIFM__BACKGROUND_H__ */
@@ -255,6 +255,9 @@ typedef struct config_t
 	/* Controls use of fast file cloning for file systems that support it. */
 	int fast_file_cloning;
 
+	/* Number of threads for reading files in parallel, zero means automatic. */
+	int io_threads;
+
 	/* Whether various things should be reset on entering/leaving custom views. */
 	int cvoptions;
 
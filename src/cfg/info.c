@@ -1080,6 +1080,8 @@ write_options(FILE *const fp)
 		fprintf(fp, "%s", "fastfilecloning,");
 	fprintf(fp, "\n");
 
+	fprintf(fp, "=iothreads=%d\n", cfg.io_threads);
+
 	fprintf(fp, "=dirsize=%s", cfg.view_dir_size == VDS_SIZE ? "size" : "nitems");
 
 	str = classify_to_str();
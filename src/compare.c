@@ -20,13 +20,16 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* size_t */
-#include <stdint.h> /* INTPTR_MAX INT64_MAX */
-#include <stdio.h> /* FILE fclose() feof() fopen() fread() */
-#include <stdlib.h> /* free() malloc() qsort() */
+#include <stdint.h> /* INTPTR_MAX INT64_MAX intptr_t */
+#include <stdio.h> /* FILE SEEK_END fclose() feof() ferror() fopen() fread()
+                      fseek() snprintf() */
+#include <stdlib.h> /* calloc() free() malloc() qsort() */
 #include <string.h> /* memcmp() */
 
+#include "cfg/config.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
+#include "compat/pthread.h"
 #include "compat/reallocarray.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "ui/cancellation.h"
@@ -35,7 +38,10 @@
 #include "utils/dynarray.h"
 #include "utils/fs.h"
 #include "utils/fsdata.h"
+#include "utils/hcache.h"
+#include "utils/log.h"
 #include "utils/macros.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
@@ -52,18 +58,67 @@
 /* Amount of data to read at once. */
 #define BLOCK_SIZE (32*1024)
 
-/* Amount of data to hash for coarse comparison. */
-#define PREFIX_SIZE (256*1024)
+/* Amount of data at the beginning and at the end of a file to hash for coarse
+ * comparison. */
+#define SAMPLE_SIZE (4*1024)
+
+#if INTPTR_MAX == INT64_MAX
+#define XX_BITS 64
+#else
+#define XX_BITS 32
+#endif
+#define XX__(name, bits) XXH ## bits ## _ ## name
+#define XX_(name, bits) XX__(name, bits)
+#define XX(name) XX_(name, XX_BITS)
+
+/* Describes how digests are computed for the persistent cache. */
+#define CACHE_TAG ((XX_BITS << 24) | SAMPLE_SIZE)
+
+/* Lazily computed digests of contents of a file.  States are zero for fields
+ * that weren't computed yet, positive for valid ones and negative on error. */
+typedef struct
+{
+	unsigned long long sample; /* Digest of the beginning and end of a file. */
+	unsigned long long full;   /* Digest of the whole file. */
+	int sample_state;          /* State of the sample field. */
+	int full_state;            /* State of the full field. */
+	hcache_key_t key;          /* Identifies the file in the cache. */
+	int key_state;             /* State of the key field. */
+}
+digests_t;
 
 /* Entry in singly-bounded list of files that have matched fingerprints. */
 typedef struct compare_record_t
 {
 	char *path;                    /* Full path to file with sample content. */
 	int id;                        /* Chosen id. */
+	digests_t digests;             /* Digests of the file computed so far. */
 	struct compare_record_t *next; /* Next entry in the list. */
 }
 compare_record_t;
 
+/* File whose digests are computed by a hashing thread. */
+typedef struct
+{
+	const char *path;        /* Full path to the file. */
+	digests_t *digests;      /* Where to store the result. */
+	unsigned long long size; /* Size of the file. */
+}
+hash_job_t;
+
+/* State of computing digests of a set of files on several threads. */
+typedef struct
+{
+	hash_job_t *jobs;     /* List of files to process. */
+	int njobs;            /* Number of elements in the jobs array. */
+	int full;             /* Whether digests of whole files are computed. */
+	pthread_mutex_t lock; /* Protects ndone field. */
+	int ndone;            /* Number of processed jobs. */
+}
+hashing_t;
+
+static void open_digest_cache(CompareType ct);
+static void close_digest_cache(void);
 static void make_unique_lists(entries_t curr, entries_t other);
 static void leave_only_dups(entries_t *curr, entries_t *other);
 static int is_not_duplicate(FileView *view, const dir_entry_t *entry,
@@ -73,6 +128,15 @@ static int id_sorter(const void *first, const void *second);
 static void put_or_free(FileView *view, dir_entry_t *entry, int id, int take);
 static entries_t make_diff_list(trie_t *trie, FileView *view, int *next_id,
 		CompareType ct, int skip_empty, int dups_only);
+static int precompute_digests(trie_t *trie, const entries_t *list,
+		char *fingerprints[], digests_t digests[], char *paths[]);
+static int add_hash_job(hash_job_t **jobs, int *njobs, const char path[],
+		digests_t *digests, unsigned long long size);
+static int count_key(trie_t *counts, const char key[]);
+static int get_key_count(trie_t *counts, const char key[]);
+static int hash_files(hash_job_t jobs[], int njobs, int full);
+static void hash_file_task(par_queue_t *queue, void *task, void *arg);
+static int report_hashing_progress(void *arg);
 static void list_view_entries(const FileView *view, strlist_t *list);
 static void append_valid_nodes(const char name[], int valid,
 		const void *parent_data, void *data, void *arg);
@@ -80,15 +144,26 @@ static void list_files_recursively(const char path[], int skip_dot_files,
 		strlist_t *list);
 static char * get_file_fingerprint(const char path[], const dir_entry_t *entry,
 		CompareType ct);
-static char * get_contents_fingerprint(const char path[],
-		const dir_entry_t *entry);
 static int get_file_id(trie_t *trie, const char path[],
-		const char fingerprint[], int *id, CompareType ct);
+		const char fingerprint[], unsigned long long size, digests_t *digests,
+		int *id, CompareType ct);
+static int contents_match(const char a[], digests_t *a_digests,
+		const char b[], digests_t *b_digests, unsigned long long size);
+static int get_sample_digest(const char path[], digests_t *digests,
+		unsigned long long size);
+static int get_full_digest(const char path[], digests_t *digests);
+static void load_cached_digests(const char path[], digests_t *digests);
+static void store_cached_digests(const digests_t *digests);
+static int hash_file(FILE *in, size_t to_read, XX(state_t) *st);
 static int files_are_identical(const char a[], const char b[]);
 static void put_file_id(trie_t *trie, const char path[],
-		const char fingerprint[], int id, CompareType ct);
+		const char fingerprint[], const digests_t *digests, int id,
+		CompareType ct);
 static void free_compare_records(void *ptr);
 
+/* Persistent cache of digests that is used during comparison by contents. */
+static hcache_t *digest_cache;
+
 int
 compare_two_panes(CompareType ct, ListType lt, int group_paths, int skip_empty)
 {
@@ -99,9 +174,11 @@ compare_two_panes(CompareType ct, ListType lt, int group_paths, int skip_empty)
 	ui_cancellation_reset();
 	ui_cancellation_enable();
 
+	open_digest_cache(ct);
 	curr = make_diff_list(trie, curr_view, &next_id, ct, skip_empty, 0);
 	other = make_diff_list(trie, other_view, &next_id, ct, skip_empty,
 			lt == LT_DUPS);
+	close_digest_cache();
 
 	ui_cancellation_disable();
 	trie_free_with_data(trie, &free_compare_records);
@@ -166,6 +243,32 @@ compare_two_panes(CompareType ct, ListType lt, int group_paths, int skip_empty)
 	return 0;
 }
 
+/* Loads persistent cache of digests if it's going to be used. */
+static void
+open_digest_cache(CompareType ct)
+{
+	char path[PATH_MAX + 16];
+
+	if(ct != CT_CONTENTS || cfg.config_dir[0] == '\0')
+	{
+		return;
+	}
+
+	snprintf(path, sizeof(path), "%s/hashcache", cfg.config_dir);
+	digest_cache = hcache_open(path, CACHE_TAG);
+}
+
+/* Saves and unloads persistent cache of digests. */
+static void
+close_digest_cache(void)
+{
+	if(hcache_close(digest_cache) != 0)
+	{
+		LOG_ERROR_MSG("Failed to save cache of digests");
+	}
+	digest_cache = NULL;
+}
+
 /* Composes two views containing only files that are unique to each of them.
  * Assumes that both lists are sorted by id. */
 static void
@@ -380,7 +483,9 @@ compare_one_pane(FileView *view, CompareType ct, ListType lt, int skip_empty)
 	ui_cancellation_reset();
 	ui_cancellation_enable();
 
+	open_digest_cache(ct);
 	curr = make_diff_list(trie, view, &next_id, ct, skip_empty, 0);
+	close_digest_cache();
 
 	ui_cancellation_disable();
 	trie_free_with_data(trie, &free_compare_records);
@@ -490,6 +595,8 @@ make_diff_list(trie_t *trie, FileView *view, int *next_id, CompareType ct,
 	strlist_t files = {};
 	entries_t r = {};
 	int last_progress = 0;
+	char **fingerprints;
+	digests_t *digests;
 
 	show_progress("Listing...", 0);
 	if(flist_custom_active(view) &&
@@ -502,12 +609,21 @@ make_diff_list(trie_t *trie, FileView *view, int *next_id, CompareType ct,
 		list_files_recursively(flist_get_dir(view), view->hide_dot, &files);
 	}
 
+	fingerprints = reallocarray(NULL, files.nitems, sizeof(*fingerprints));
+	digests = calloc(files.nitems, sizeof(*digests));
+	if((fingerprints == NULL || digests == NULL) && files.nitems != 0)
+	{
+		free(fingerprints);
+		free(digests);
+		free_string_array(files.items, files.nitems);
+		return r;
+	}
+
 	show_progress("Querying...", 0);
 	for(i = 0; i < files.nitems && !ui_cancellation_requested(); ++i)
 	{
 		char progress_msg[128];
 		int progress;
-		int existing_id;
 		char *fingerprint;
 		const char *const path = files.items[i];
 		dir_entry_t *const entry = entry_list_add(view, &r.entries, &r.nentries,
@@ -532,7 +648,34 @@ make_diff_list(trie_t *trie, FileView *view, int *next_id, CompareType ct,
 		}
 
 		entry->tag = i;
-		if(get_file_id(trie, path, fingerprint, &existing_id, ct))
+		fingerprints[r.nentries - 1] = fingerprint;
+
+		progress = (i*100)/files.nitems;
+		if(progress != last_progress)
+		{
+			last_progress = progress;
+			snprintf(progress_msg, sizeof(progress_msg), "Querying... %d (% 2d%%)", i,
+					progress);
+			show_progress(progress_msg, -1);
+		}
+	}
+
+	/* Reading files one by one doesn't utilize fast storage, so compute digests
+	 * that are going to be needed in advance and on several threads. */
+	if(ct == CT_CONTENTS && !ui_cancellation_requested())
+	{
+		(void)precompute_digests(trie, &r, fingerprints, digests, files.items);
+	}
+
+	/* Ids are assigned in order to keep results stable. */
+	for(i = 0; i < r.nentries && !ui_cancellation_requested(); ++i)
+	{
+		int existing_id;
+		dir_entry_t *const entry = &r.entries[i];
+		const char *const path = files.items[entry->tag];
+
+		if(get_file_id(trie, path, fingerprints[i], entry->size, &digests[i],
+					&existing_id, ct))
 		{
 			entry->id = existing_id;
 		}
@@ -544,23 +687,230 @@ make_diff_list(trie_t *trie, FileView *view, int *next_id, CompareType ct,
 		{
 			entry->id = *next_id;
 			++*next_id;
-			put_file_id(trie, path, fingerprint, entry->id, ct);
+			put_file_id(trie, path, fingerprints[i], &digests[i], entry->id, ct);
 		}
+	}
 
-		free(fingerprint);
+	free_string_array(fingerprints, r.nentries);
+	free(digests);
+	free_string_array(files.items, files.nitems);
+	return r;
+}
 
-		progress = (i*100)/files.nitems;
-		if(progress != last_progress)
+/* Computes on several threads digests of files of the list that are going to
+ * be compared either to each other or to files that are already in the trie.
+ * Elements of fingerprints and digests arrays correspond to entries of the
+ * list, paths are indexed by tags of entries.  Returns non-zero if the process
+ * was cancelled, otherwise zero is returned. */
+static int
+precompute_digests(trie_t *trie, const entries_t *list, char *fingerprints[],
+		digests_t digests[], char *paths[])
+{
+	int i;
+	int cancelled;
+	int nfull;
+	hash_job_t *jobs = NULL;
+	int njobs = 0;
+	trie_t *counts = trie_create();
+	trie_t *const seen = trie_create();
+
+	for(i = 0; i < list->nentries; ++i)
+	{
+		(void)count_key(counts, fingerprints[i]);
+	}
+
+	/* Files of unique size are never read, so don't hash them. */
+	for(i = 0; i < list->nentries; ++i)
+	{
+		void *data;
+		const dir_entry_t *const entry = &list->entries[i];
+		const int in_trie = (trie_get(trie, fingerprints[i], &data) == 0);
+		compare_record_t *record;
+
+		if(!in_trie && get_key_count(counts, fingerprints[i]) < 2)
 		{
-			last_progress = progress;
-			snprintf(progress_msg, sizeof(progress_msg), "Querying... %d (% 2d%%)", i,
-					progress);
-			show_progress(progress_msg, -1);
+			continue;
+		}
+
+		(void)add_hash_job(&jobs, &njobs, paths[entry->tag], &digests[i],
+				entry->size);
+
+		/* Files that are already in the trie are added only once. */
+		if(in_trie && count_key(seen, fingerprints[i]) == 1)
+		{
+			for(record = data; record != NULL; record = record->next)
+			{
+				(void)add_hash_job(&jobs, &njobs, record->path, &record->digests,
+						entry->size);
+			}
 		}
 	}
+	trie_free(seen);
+	trie_free(counts);
 
-	free_string_array(files.items, files.nitems);
-	return r;
+	cancelled = hash_files(jobs, njobs, 0);
+
+	/* Whole files are hashed only if their samples aren't unique. */
+	counts = trie_create();
+	for(i = 0; i < njobs && !cancelled; ++i)
+	{
+		char key[64];
+		if(jobs[i].digests->sample_state > 0 && jobs[i].size > 2U*SAMPLE_SIZE)
+		{
+			snprintf(key, sizeof(key), "%llu:%llx", jobs[i].size,
+					jobs[i].digests->sample);
+			(void)count_key(counts, key);
+		}
+	}
+	nfull = 0;
+	for(i = 0; i < njobs && !cancelled; ++i)
+	{
+		char key[64];
+		snprintf(key, sizeof(key), "%llu:%llx", jobs[i].size,
+				jobs[i].digests->sample);
+		if(jobs[i].digests->sample_state > 0 && jobs[i].size > 2U*SAMPLE_SIZE &&
+				get_key_count(counts, key) > 1)
+		{
+			jobs[nfull++] = jobs[i];
+		}
+	}
+	trie_free(counts);
+
+	if(!cancelled)
+	{
+		cancelled = hash_files(jobs, nfull, 1);
+	}
+
+	free(jobs);
+	return cancelled;
+}
+
+/* Appends a job to the list.  Returns zero on success, otherwise non-zero is
+ * returned, which isn't fatal as digests are also computed on demand. */
+static int
+add_hash_job(hash_job_t **jobs, int *njobs, const char path[],
+		digests_t *digests, unsigned long long size)
+{
+	hash_job_t *job;
+	hash_job_t *const new_jobs = reallocarray(*jobs, *njobs + 1, sizeof(**jobs));
+	if(new_jobs == NULL)
+	{
+		return 1;
+	}
+	*jobs = new_jobs;
+
+	job = &new_jobs[(*njobs)++];
+	job->path = path;
+	job->digests = digests;
+	job->size = size;
+	return 0;
+}
+
+/* Increments counter associated with the key.  Returns new value of the
+ * counter. */
+static int
+count_key(trie_t *counts, const char key[])
+{
+	void *data;
+	if(trie_get(counts, key, &data) != 0)
+	{
+		data = NULL;
+	}
+
+	data = (void *)((intptr_t)data + 1);
+	(void)trie_set(counts, key, data);
+	return (intptr_t)data;
+}
+
+/* Retrieves value of the counter associated with the key.  Returns the
+ * value. */
+static int
+get_key_count(trie_t *counts, const char key[])
+{
+	void *data;
+	return (trie_get(counts, key, &data) == 0 ? (int)(intptr_t)data : 0);
+}
+
+/* Computes sample or full digests of files using number of threads configured
+ * via 'iothreads'.  Returns non-zero if the process was cancelled, otherwise
+ * zero is returned. */
+static int
+hash_files(hash_job_t jobs[], int njobs, int full)
+{
+	int cancelled;
+	hashing_t hashing = {
+		.jobs = jobs,
+		.njobs = njobs,
+		.full = full,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.ndone = 0,
+	};
+
+	if(njobs == 0)
+	{
+		return 0;
+	}
+
+	cancelled = par_run(&hashing, cfg.io_threads, &hash_file_task,
+			&report_hashing_progress, &hashing);
+	pthread_mutex_destroy(&hashing.lock);
+	return cancelled;
+}
+
+/* par_run() callback that computes digest of a single file.  The initial task
+ * is the hashing state itself, which just queues all the files. */
+static void
+hash_file_task(par_queue_t *queue, void *task, void *arg)
+{
+	hashing_t *const hashing = arg;
+	hash_job_t *const job = task;
+
+	if(task == hashing)
+	{
+		int i;
+		/* Files that didn't make it into the queue are hashed on demand. */
+		for(i = 0; i < hashing->njobs; ++i)
+		{
+			if(par_push(queue, &hashing->jobs[i]) != 0)
+			{
+				break;
+			}
+		}
+		return;
+	}
+
+	if(hashing->full)
+	{
+		(void)get_full_digest(job->path, job->digests);
+	}
+	else
+	{
+		(void)get_sample_digest(job->path, job->digests, job->size);
+	}
+
+	pthread_mutex_lock(&hashing->lock);
+	++hashing->ndone;
+	pthread_mutex_unlock(&hashing->lock);
+}
+
+/* par_run() callback that displays progress of hashing files.  Returns non-zero
+ * if hashing should be cancelled. */
+static int
+report_hashing_progress(void *arg)
+{
+	char msg[64];
+	int ndone;
+	hashing_t *const hashing = arg;
+
+	pthread_mutex_lock(&hashing->lock);
+	ndone = hashing->ndone;
+	pthread_mutex_unlock(&hashing->lock);
+
+	snprintf(msg, sizeof(msg), "Hashing %s... %d of %d",
+			hashing->full ? "files" : "samples", ndone, hashing->njobs);
+	show_progress(msg, 1);
+
+	return ui_cancellation_requested();
 }
 
 /* Fills the list with entries of the view in hierarchical order (pre-order tree
@@ -682,64 +1032,24 @@ get_file_fingerprint(const char path[], const dir_entry_t *entry,
 		case CT_SIZE:
 			return format_str("%" PRINTF_ULL, (unsigned long long)entry->size);
 		case CT_CONTENTS:
-			return get_contents_fingerprint(path, entry);
+			/* Files of different size can't be identical, so size is a good first
+			 * approximation that doesn't require reading any data.  Conflicts are
+			 * resolved by get_file_id(). */
+			if(os_access(path, R_OK) != 0)
+			{
+				return strdup("");
+			}
+			return format_str("%" PRINTF_ULL, (unsigned long long)entry->size);
 	}
 	assert(0 && "Unexpected diffing type.");
 	return strdup("");
 }
 
-/* Makes fingerprint of file contents (all or part of it of fixed size).
- * Returns the fingerprint as a string, which is empty or NULL on error. */
-static char *
-get_contents_fingerprint(const char path[], const dir_entry_t *entry)
-{
-#if INTPTR_MAX == INT64_MAX
-#define XX_BITS 64
-#else
-#define XX_BITS 32
-#endif
-#define XX__(name, bits) XXH ## bits ## _ ## name
-#define XX_(name, bits) XX__(name, bits)
-#define XX(name) XX_(name, XX_BITS)
-
-	XX(state_t) st;
-	char block[BLOCK_SIZE];
-	size_t to_read = PREFIX_SIZE;
-	FILE *in = os_fopen(path, "rb");
-	if(in == NULL)
-	{
-		return strdup("");
-	}
-
-	XX(reset)(&st, 0U);
-	while(to_read != 0U)
-	{
-		const size_t portion = MIN(sizeof(block), to_read);
-		const size_t nread = fread(&block, 1, portion, in);
-		if(nread == 0U)
-		{
-			break;
-		}
-
-		XX(update)(&st, block, nread);
-		to_read -= nread;
-	}
-	fclose(in);
-
-	return format_str("%" PRINTF_ULL "|%" PRINTF_ULL,
-			(unsigned long long)entry->size, (unsigned long long)XX(digest)(&st));
-
-#undef XX_BITS
-#undef XX__
-#undef XX_
-#undef XX
-}
-
 /* Retrieves file from the trie by its fingerprint.  Returns non-zero if it was
  * in the trie and sets *id, otherwise zero is returned. */
 static int
-get_file_id(trie_t *trie, const char path[], const char fingerprint[], int *id,
-		CompareType ct)
+get_file_id(trie_t *trie, const char path[], const char fingerprint[],
+		unsigned long long size, digests_t *digests, int *id, CompareType ct)
 {
 	void *data;
 	compare_record_t *record;
@@ -761,7 +1071,7 @@ get_file_id(trie_t *trie, const char path[], const char fingerprint[], int *id,
 	 * identical content. */
 	do
 	{
-		if(files_are_identical(path, record->path))
+		if(contents_match(path, digests, record->path, &record->digests, size))
 		{
 			*id = record->id;
 			return 1;
@@ -773,6 +1083,188 @@ get_file_id(trie_t *trie, const char path[], const char fingerprint[], int *id,
 	return 0;
 }
 
+/* Checks whether two files of the same size have identical contents by first
+ * comparing digests of their samples, then digests of whole files and only
+ * then the files themselves.  Digests are computed on demand and cached.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+contents_match(const char a[], digests_t *a_digests, const char b[],
+		digests_t *b_digests, unsigned long long size)
+{
+	if(get_sample_digest(a, a_digests, size) != 0 ||
+			get_sample_digest(b, b_digests, size) != 0 ||
+			a_digests->sample != b_digests->sample)
+	{
+		return 0;
+	}
+
+	/* Sample covers whole file, no point in hashing it once again. */
+	if(size > 2U*SAMPLE_SIZE)
+	{
+		if(get_full_digest(a, a_digests) != 0 ||
+				get_full_digest(b, b_digests) != 0 ||
+				a_digests->full != b_digests->full)
+		{
+			return 0;
+		}
+	}
+
+	/* Equal digests don't guarantee equal contents, collisions are possible
+	 * (especially for 32-bit digests). */
+	return files_are_identical(a, b);
+}
+
+/* Computes digest of the beginning and the end of the file unless it's already
+ * known.  Returns zero on success, otherwise non-zero is returned. */
+static int
+get_sample_digest(const char path[], digests_t *digests,
+		unsigned long long size)
+{
+	XX(state_t) st;
+	FILE *in;
+	int failed;
+
+	if(digests->sample_state == 0)
+	{
+		load_cached_digests(path, digests);
+	}
+
+	if(digests->sample_state == 0)
+	{
+		in = os_fopen(path, "rb");
+		if(in == NULL)
+		{
+			digests->sample_state = -1;
+			return 1;
+		}
+
+		XX(reset)(&st, 0U);
+		if(size <= 2U*SAMPLE_SIZE)
+		{
+			failed = (hash_file(in, (size_t)size, &st) != 0);
+		}
+		else
+		{
+			failed = (hash_file(in, SAMPLE_SIZE, &st) != 0 ||
+			          fseek(in, -SAMPLE_SIZE, SEEK_END) != 0 ||
+			          hash_file(in, SAMPLE_SIZE, &st) != 0);
+		}
+		fclose(in);
+
+		digests->sample = XX(digest)(&st);
+		digests->sample_state = (failed ? -1 : 1);
+		store_cached_digests(digests);
+	}
+
+	return (digests->sample_state < 0);
+}
+
+/* Computes digest of the whole file unless it's already known.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+get_full_digest(const char path[], digests_t *digests)
+{
+	XX(state_t) st;
+	FILE *in;
+	int failed;
+
+	if(digests->full_state == 0)
+	{
+		load_cached_digests(path, digests);
+	}
+
+	if(digests->full_state == 0)
+	{
+		in = os_fopen(path, "rb");
+		if(in == NULL)
+		{
+			digests->full_state = -1;
+			return 1;
+		}
+
+		XX(reset)(&st, 0U);
+		failed = (hash_file(in, (size_t)-1, &st) != 0 || !feof(in));
+		fclose(in);
+
+		digests->full = XX(digest)(&st);
+		digests->full_state = (failed ? -1 : 1);
+		store_cached_digests(digests);
+	}
+
+	return (digests->full_state < 0);
+}
+
+/* Fills digests that weren't computed yet from the persistent cache.  Does
+ * nothing after the first call for the same file. */
+static void
+load_cached_digests(const char path[], digests_t *digests)
+{
+	hcache_value_t value;
+
+	if(digests->key_state != 0)
+	{
+		return;
+	}
+
+	digests->key_state = (digest_cache != NULL &&
+	                      hcache_key_from_file(path, &digests->key) == 0)
+	                   ? 1 : -1;
+	if(digests->key_state < 0 ||
+			hcache_get(digest_cache, &digests->key, &value) != 0)
+	{
+		return;
+	}
+
+	if(value.has_sample && digests->sample_state == 0)
+	{
+		digests->sample = value.sample;
+		digests->sample_state = 1;
+	}
+	if(value.has_full && digests->full_state == 0)
+	{
+		digests->full = value.full;
+		digests->full_state = 1;
+	}
+}
+
+/* Puts valid digests of a file into the persistent cache. */
+static void
+store_cached_digests(const digests_t *digests)
+{
+	const hcache_value_t value = {
+		.sample = digests->sample,
+		.full = digests->full,
+		.has_sample = (digests->sample_state > 0),
+		.has_full = (digests->full_state > 0),
+	};
+
+	if(digests->key_state > 0)
+	{
+		hcache_put(digest_cache, &digests->key, &value);
+	}
+}
+
+/* Feeds up to to_read bytes of the file to the hash state.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+hash_file(FILE *in, size_t to_read, XX(state_t) *st)
+{
+	char block[BLOCK_SIZE];
+	while(to_read != 0U)
+	{
+		const size_t portion = MIN(sizeof(block), to_read);
+		const size_t nread = fread(&block, 1, portion, in);
+		if(nread == 0U)
+		{
+			break;
+		}
+
+		XX(update)(st, block, nread);
+		to_read -= nread;
+	}
+	return ferror(in);
+}
+
 /* Checks whether two files specified by their names hold identical content.
  * Returns non-zero if so, otherwise zero is returned. */
 static int
@@ -821,14 +1313,15 @@ files_are_identical(const char a[], const char b[])
 
 /* Stores id of a file with given fingerprint in the trie. */
 static void
-put_file_id(trie_t *trie, const char path[], const char fingerprint[], int id,
-		CompareType ct)
+put_file_id(trie_t *trie, const char path[], const char fingerprint[],
+		const digests_t *digests, int id, CompareType ct)
 {
 	compare_record_t *const record = malloc(sizeof(*record));
 	void *data = NULL;
 	(void)trie_get(trie, fingerprint, &data);
 
 	record->id = id;
+	record->digests = *digests;
 	record->next = data;
 
 	/* Comparison by contents is the only one when we need to resolve fingerprint
@@ -911,8 +1404,8 @@ compare_move(FileView *from, FileView *to)
 
 		/* Update the other entry to not be fake. */
 		remove_last_path_component(canonical);
-		replace_string(&other->name, curr->name);
-		replace_string(&other->origin, canonical);
+		(void)fentry_set_name(other, curr->name);
+		(void)fentry_set_origin(to, other, canonical);
 	}
 	else
 	{
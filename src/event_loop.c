@@ -629,6 +629,7 @@ prepare_suggestion_box(int *height)
 	{
 		win = other_view->win;
 		*height = MIN(count, getmaxy(win));
+		fview_invalidate(other_view);
 	}
 	else
 	{
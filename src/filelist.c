@@ -32,15 +32,18 @@
 
 #include <assert.h> /* assert() */
 #include <errno.h> /* errno */
+#include <limits.h> /* INT_MAX INT_MIN */
 #include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* intptr_t uint64_t */
 #include <stdio.h> /* snprintf() */
-#include <stdlib.h> /* calloc() free() */
+#include <stdlib.h> /* calloc() free() qsort() */
 #include <string.h> /* memcmp() memcpy() memset() strcat() strcmp() strcpy()
                        strdup() strlen() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
+#include "compat/pthread.h"
+#include "compat/reallocarray.h"
 #include "compat/os.h"
 #include "engine/autocmds.h"
 #include "engine/mode.h"
@@ -52,6 +55,7 @@
 #include "ui/statusbar.h"
 #include "ui/statusline.h"
 #include "ui/ui.h"
+#include "utils/arena.h"
 #include "utils/dynarray.h"
 #include "utils/env.h"
 #include "utils/fs.h"
@@ -59,6 +63,7 @@
 #include "utils/fswatch.h"
 #include "utils/log.h"
 #include "utils/macros.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
@@ -79,6 +84,73 @@
 #include "status.h"
 #include "types.h"
 
+/* Lists of files shorter than this are processed on a single thread. */
+#define PARALLEL_THRESHOLD 256
+
+/* Number of entries that are processed by a thread at a time. */
+#define PARALLEL_CHUNK 64
+
+/* Reloads that change more than 1/N part of directory are handled by sorting
+ * the list anew. */
+#define MAX_CHANGED_PART 4
+
+/* State of reading directory into a view. */
+typedef struct
+{
+	FileView *view;  /* View that's being populated. */
+	int interactive; /* Whether progress is displayed and cancellation enabled. */
+	arena_t *names;  /* Storage for names of files (can be NULL). */
+}
+dir_reading_t;
+
+/* Entry that's being inserted into sorted list. */
+typedef struct
+{
+	int pos;   /* Number of retained entries that precede this one. */
+	int index; /* Index of the entry in the list that was read. */
+}
+insertion_t;
+
+/* Directory of a tree that's being built. */
+typedef struct tree_dir_t tree_dir_t;
+
+/* File of a directory of a tree that's being built. */
+typedef struct
+{
+	char *name;        /* Name of the file. */
+	char *path;        /* Canonic path to the file. */
+	int visible;       /* Whether the file passes all filters. */
+	int failed;        /* Whether querying information about the file failed. */
+	dir_entry_t entry; /* Entry of visible file. */
+	tree_dir_t *dir;   /* Contents of a directory to be traversed or NULL. */
+}
+tree_file_t;
+
+struct tree_dir_t
+{
+	char *path;         /* Path to the directory. */
+	tree_file_t *files; /* Files of the directory. */
+	int nfiles;         /* Number of files or -1 if listing failed. */
+	int fresh;          /* Whether directory was listed after the last update of
+	                       watcher of the tree. */
+};
+
+/* State of scanning file system for a tree. */
+typedef struct
+{
+	FileView *view;          /* View for which the tree is built. */
+	trie_t *excluded_paths;  /* Paths that are excluded from the tree. */
+	pthread_mutex_t lock;    /* Protects nfiles field. */
+	int nfiles;              /* Number of files scanned so far. */
+
+	tree_dir_t *relisted;    /* Directory of existing tree that's being listed
+	                            anew or NULL. */
+	tree_file_t *prev_files; /* Previous files of the relisted directory. */
+	int prev_nfiles;         /* Number of elements in prev_files. */
+	int prev_pos;            /* Where to start next lookup in prev_files. */
+}
+tree_scan_t;
+
 static void init_view(FileView *view);
 static void init_flist(FileView *view);
 static void reset_view(FileView *view);
@@ -88,7 +160,11 @@ static int navigate_to_file_in_custom_view(FileView *view, const char dir[],
 static int fill_dir_entry_by_path(dir_entry_t *entry, const char path[]);
 #ifndef _WIN32
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
-		const struct dirent *d);
+		FileType type_hint);
+static void fill_dir_entries(FileView *view);
+static void fill_dir_entries_range(size_t from, size_t to, void *arg);
+static void fill_unknown_entries_range(size_t from, size_t to, void *arg);
+static void load_meta_range(size_t from, size_t to, void *arg);
 static int data_is_dir_entry(const struct dirent *d);
 #else
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
@@ -109,18 +185,21 @@ static void uncompress_traverser(const char name[], int valid,
 static void load_dir_list_internal(FileView *view, int reload, int draw_only);
 static int populate_dir_list_internal(FileView *view, int reload);
 static int populate_custom_view(FileView *view, int reload);
+static int reload_tree(FileView *view, int reload, int rescan);
 static int entry_exists(FileView *view, const dir_entry_t *entry, void *arg);
 static void zap_compare_view(FileView *view, FileView *other, zap_filter filter,
 		void *arg);
 static int find_separator(FileView *view, int idx);
 static int update_dir_watcher(FileView *view);
+static void update_tree_watcher(FileView *view, int recreate);
+static int watch_tree_dirs(fswatch_t *watch, tree_dir_t *dir, int all);
 static int custom_list_is_incomplete(const FileView *view);
 static int is_dead_or_filtered(FileView *view, const dir_entry_t *entry,
 		void *arg);
 static void update_entries_data(FileView *view);
 static int is_dir_big(const char path[]);
 static void free_view_entries(FileView *view);
-static int update_dir_list(FileView *view, int reload);
+static int update_dir_list(FileView *view, int reload, int *interrupted);
 static void start_dir_list_change(FileView *view, dir_entry_t **entries,
 		int *len, int reload);
 static void finish_dir_list_change(FileView *view, dir_entry_t *entries,
@@ -128,7 +207,23 @@ static void finish_dir_list_change(FileView *view, dir_entry_t *entries,
 static int add_file_entry_to_view(const char name[], const void *data,
 		void *param);
 static void sort_dir_list(int msg, FileView *view);
+static int update_sorted_list(FileView *view, dir_entry_t *prev, int prev_len);
+static dir_entry_t ** index_by_name(dir_entry_t *entries, int len);
+static int name_ptr_cmp(const void *a, const void *b);
+static int entry_was_changed(const dir_entry_t *prev, const dir_entry_t *curr,
+		int meta);
+static FileType normalize_type(FileType type);
+static int find_insert_pos(const FileView *view, const dir_entry_t *entry,
+		const dir_entry_t *kept[], int nkept);
+static int insertion_cmp(const void *a, const void *b);
+static void order_insertions(const FileView *view, insertion_t added[],
+		int nadded);
 static void merge_lists(FileView *view, dir_entry_t *entries, int len);
+static int apply_file_events(FileView *view);
+static int apply_tree_events(FileView *view);
+static int apply_file_event(FileView *view, const fswatch_event_t *event);
+static void take_entry_out(FileView *view, int pos, dir_entry_t *entry);
+static int put_entry_in(FileView *view, const dir_entry_t *entry);
 static void add_to_trie(trie_t *trie, FileView *view, dir_entry_t *entry);
 static int is_in_trie(trie_t *trie, FileView *view, dir_entry_t *entry,
 		void **data);
@@ -136,8 +231,10 @@ static void merge_entries(dir_entry_t *new, const dir_entry_t *prev);
 static int correct_pos(FileView *view, int pos, int dist, int closest);
 static int rescue_from_empty_filelist(FileView *view);
 static void init_dir_entry(FileView *view, dir_entry_t *entry,
-		const char name[]);
+		const char name[], arena_t *arena);
 static dir_entry_t * alloc_dir_entry(dir_entry_t **list, int list_size);
+static char * copy_entry_str(char str[], int in_arena);
+static void free_entry_str(char str[], int in_arena);
 static int tree_has_changed(const dir_entry_t *entries, size_t nchildren);
 TSTATIC void pick_cd_path(FileView *view, const char base_dir[],
 		const char path[], int *updir, char buf[], size_t buf_size);
@@ -153,8 +250,26 @@ static int flist_load_tree_internal(FileView *view, const char path[],
 		int reload);
 static int make_tree(FileView *view, const char path[], int reload,
 		trie_t *excluded_paths);
-static int add_files_recursively(FileView *view, const char path[],
-		trie_t *excluded_paths, int parent_pos, int no_direct_parent);
+static int build_tree(FileView *view, const char path[], int reload);
+static tree_dir_t * scan_tree(FileView *view, const char path[],
+		trie_t *excluded_paths);
+static void relist_tree_dir(FileView *view, tree_dir_t *dir);
+static void refilter_tree(FileView *view, tree_dir_t *dir);
+static tree_dir_t * find_tree_dir(tree_dir_t *root, const char path[],
+		tree_file_t **file);
+static int path_len_cmp(const void *a, const void *b);
+static void scan_tree_dir(par_queue_t *queue, void *task, void *arg);
+static tree_dir_t * reuse_tree_dir(tree_scan_t *scan, const tree_dir_t *dir,
+		const tree_file_t *file);
+static tree_dir_t * alloc_tree_dir(const char path[]);
+static int report_scan_progress(void *arg);
+static void free_tree(FileView *view);
+static void free_tree_dir(FileView *view, tree_dir_t *dir);
+static void free_tree_files(FileView *view, tree_file_t files[], int nfiles);
+static int add_files_recursively(FileView *view, tree_dir_t *dir,
+		arena_t *arena, int parent_pos, int no_direct_parent);
+static dir_entry_t * add_tree_entry(FileView *view, tree_file_t *file,
+		arena_t *arena, char **origin);
 static int file_is_visible(FileView *view, const char filename[], int is_dir,
 		const void *data, int apply_local_filter);
 static int add_directory_leaf(FileView *view, const char path[],
@@ -279,12 +394,17 @@ load_initial_directory(FileView *view, const char dir[])
 dir_entry_t *
 get_current_entry(const FileView *view)
 {
+	dir_entry_t *entry;
+
 	if(view->list_pos < 0 || view->list_pos >= view->list_rows)
 	{
 		return NULL;
 	}
 
-	return &view->dir_entry[view->list_pos];
+	/* Current entry is the one that is most likely to be inspected in detail. */
+	entry = &view->dir_entry[view->list_pos];
+	fentry_load_meta(entry);
+	return entry;
 }
 
 char *
@@ -663,7 +783,7 @@ fill_with_shared(FileView *view)
 
 				utf8_name = utf8_from_utf16((wchar_t *)p->shi0_netname);
 
-				init_dir_entry(view, dir_entry, utf8_name);
+				init_dir_entry(view, dir_entry, utf8_name, NULL);
 				dir_entry->type = FT_DIR;
 
 				free(utf8_name);
@@ -754,7 +874,7 @@ flist_custom_add_separator(FileView *view, int id)
 			view->custom.entry_count);
 	if(dir_entry != NULL)
 	{
-		init_dir_entry(view, dir_entry, "");
+		init_dir_entry(view, dir_entry, "", NULL);
 		dir_entry->origin = strdup(flist_get_dir(view));
 		dir_entry->id = id;
 		++view->custom.entry_count;
@@ -768,14 +888,14 @@ flist_custom_add_separator(FileView *view, int id)
 static int
 fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
 {
-	return fill_dir_entry(entry, path, NULL);
+	return fill_dir_entry(entry, path, FT_UNK);
 }
 
 /* Fills fields of the entry from stat information of the file specified by its
- * path.  d is optional source of file type.  Returns zero on success, otherwise
- * non-zero is returned. */
+ * path.  type_hint is used if type can't be determined from file mode (FT_UNK
+ * means no hint).  Returns zero on success, otherwise non-zero is returned. */
 static int
-fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
+fill_dir_entry(dir_entry_t *entry, const char path[], FileType type_hint)
 {
 	struct stat s;
 
@@ -789,7 +909,7 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 	entry->type = get_type_from_mode(s.st_mode);
 	if(entry->type == FT_UNK)
 	{
-		entry->type = (d == NULL) ? FT_UNK : type_from_dir_entry(d);
+		entry->type = type_hint;
 	}
 	if(entry->type == FT_UNK)
 	{
@@ -805,6 +925,7 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 	entry->atime = s.st_atime;
 	entry->ctime = s.st_ctime;
 	entry->nlinks = s.st_nlink;
+	entry->no_meta = 0;
 
 	if(entry->type == FT_LINK)
 	{
@@ -812,8 +933,8 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 
 		struct stat s;
 
-		const SymLinkType symlink_type = get_symlink_type(entry->name);
-		if(symlink_type != SLT_SLOW && os_stat(entry->name, &s) == 0)
+		const SymLinkType symlink_type = get_symlink_type(path);
+		if(symlink_type != SLT_SLOW && os_stat(path, &s) == 0)
 		{
 			entry->mode = s.st_mode;
 		}
@@ -822,6 +943,77 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 	return 0;
 }
 
+/* Fills entries of the view, which were just read from current directory and
+ * have only name and type hint set.  On slow file systems only entries of
+ * unknown type are filled and meta-data of other entries is loaded on demand.
+ * Entries for which querying information fails are removed from the list.
+ * Queries are performed on several threads to not wait for each of them
+ * sequentially, which matters a lot for network file systems. */
+static void
+fill_dir_entries(FileView *view)
+{
+	int i, j;
+	const size_t count = view->list_rows;
+
+	par_for(count, PARALLEL_CHUNK, count >= PARALLEL_THRESHOLD ? 0 : 1,
+			view->on_slow_fs ? &fill_unknown_entries_range : &fill_dir_entries_range,
+			view->dir_entry);
+
+	/* Drop entries that failed to be filled. */
+	j = 0;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		if(view->dir_entry[i].type == FT_UNK)
+		{
+			fentry_free(view, &view->dir_entry[i]);
+			continue;
+		}
+
+		if(i != j)
+		{
+			view->dir_entry[j] = view->dir_entry[i];
+		}
+		++j;
+	}
+	view->list_rows = j;
+}
+
+/* par_for() callback that fills part of array of entries.  Type of entries
+ * that can't be filled is set to FT_UNK. */
+static void
+fill_dir_entries_range(size_t from, size_t to, void *arg)
+{
+	dir_entry_t *const entries = arg;
+
+	size_t i;
+	for(i = from; i < to; ++i)
+	{
+		dir_entry_t *const entry = &entries[i];
+		if(fill_dir_entry(entry, entry->name, entry->type) != 0)
+		{
+			entry->type = FT_UNK;
+		}
+	}
+}
+
+/* par_for() callback that fills part of array of entries whose type is
+ * unknown.  Type of entries that can't be filled remains FT_UNK. */
+static void
+fill_unknown_entries_range(size_t from, size_t to, void *arg)
+{
+	dir_entry_t *const entries = arg;
+
+	size_t i;
+	for(i = from; i < to; ++i)
+	{
+		dir_entry_t *const entry = &entries[i];
+		if(entry->type == FT_UNK)
+		{
+			(void)fill_dir_entry(entry, entry->name, FT_UNK);
+		}
+	}
+}
+
 /* Checks whether file is a directory.  Returns non-zero if so, otherwise zero
  * is returned. */
 static int
@@ -942,7 +1134,7 @@ flist_custom_finish_internal(FileView *view, CVType type, int reload,
 				view->custom.entry_count);
 		if(dir_entry != NULL)
 		{
-			init_dir_entry(view, dir_entry, "..");
+			init_dir_entry(view, dir_entry, "..", NULL);
 			dir_entry->type = FT_DIR;
 			dir_entry->origin = strdup(dir);
 			++view->custom.entry_count;
@@ -979,6 +1171,10 @@ flist_custom_finish_internal(FileView *view, CVType type, int reload,
 	/* Kind of custom view must be set to correct value before option loading and
 	 * sorting. */
 	view->custom.type = type;
+	if(type != CV_TREE)
+	{
+		free_tree(view);
+	}
 
 	if(cv_unsorted(type))
 	{
@@ -1071,6 +1267,8 @@ flist_custom_exclude(FileView *view, int selection_only)
 			char full_path[PATH_MAX];
 			get_full_path_of(entry, sizeof(full_path), full_path);
 			(void)trie_put(view->custom.excluded_paths, full_path);
+			/* Results of the last scan include excluded files. */
+			free_tree(view);
 		}
 	}
 
@@ -1187,6 +1385,7 @@ flist_custom_clone(FileView *to, const FileView *from)
 	to->custom.type = (ui_view_unsorted(from) || from_tree)
 	                ? CV_VERY
 	                : CV_REGULAR;
+	free_tree(to);
 
 	if(custom_list_is_incomplete(from))
 	{
@@ -1211,14 +1410,14 @@ flist_custom_clone(FileView *to, const FileView *from)
 		}
 
 		dst[j] = src[i];
-		dst[j].name = strdup(dst[j].name);
+		dst[j].name = copy_entry_str(dst[j].name, dst[j].arena_name);
 		if(dst[j].origin == from->curr_dir)
 		{
 			dst[j].origin = to->curr_dir;
 		}
 		else
 		{
-			dst[j].origin = strdup(dst[j].origin);
+			dst[j].origin = copy_entry_str(dst[j].origin, dst[j].arena_origin);
 		}
 
 		/* As destination pane won't be a tree, erase tree-specific data, because
@@ -1296,7 +1495,7 @@ uncompress_traverser(const char name[], int valid, const void *parent_data,
 	{
 		char full_path[PATH_MAX];
 
-		init_dir_entry(view, dir_entry, name);
+		init_dir_entry(view, dir_entry, name, NULL);
 		if(parent_data == NULL)
 		{
 			dir_entry->origin = strdup(flist_get_dir(view));
@@ -1485,6 +1684,9 @@ load_dir_list_internal(FileView *view, int reload, int draw_only)
 static int
 populate_dir_list_internal(FileView *view, int reload)
 {
+	int big_dir;
+	int interrupted = 0;
+
 	view->filtered = 0;
 
 	if(flist_custom_active(view))
@@ -1492,7 +1694,10 @@ populate_dir_list_internal(FileView *view, int reload)
 		return populate_custom_view(view, reload);
 	}
 
-	if(!reload && is_dir_big(view->curr_dir))
+	free_tree(view);
+
+	big_dir = (!reload && is_dir_big(view->curr_dir));
+	if(big_dir)
 	{
 		if(!vle_mode_is(CMDLINE_MODE))
 		{
@@ -1512,7 +1717,7 @@ populate_dir_list_internal(FileView *view, int reload)
 		return 1;
 	}
 
-	if(update_dir_list(view, reload) != 0)
+	if(update_dir_list(view, reload, big_dir ? &interrupted : NULL) != 0)
 	{
 		/* We don't have read access, only execute, or there were other problems. */
 		free_view_entries(view);
@@ -1524,6 +1729,13 @@ populate_dir_list_internal(FileView *view, int reload)
 		ui_sb_clear();
 	}
 
+	if(interrupted)
+	{
+		status_bar_message("Reading of directory was interrupted, the list is "
+				"incomplete");
+		curr_stats.save_msg = 1;
+	}
+
 	view->column_count = calculate_columns_count(view);
 
 	/* If reloading the same directory don't jump to history position.  Stay at
@@ -1562,22 +1774,7 @@ populate_custom_view(FileView *view, int reload)
 {
 	if(view->custom.type == CV_TREE)
 	{
-		dir_entry_t *prev_dir_entries;
-		int prev_list_rows, result;
-
-		start_dir_list_change(view, &prev_dir_entries, &prev_list_rows, reload);
-		result = flist_load_tree_internal(view, flist_get_dir(view), 1);
-
-		if(view->dir_entry == NULL)
-		{
-			/* Restore original list in case of failure. */
-			view->dir_entry = prev_dir_entries;
-			view->list_rows = result;
-		}
-		else
-		{
-			finish_dir_list_change(view, prev_dir_entries, prev_list_rows);
-		}
+		const int result = reload_tree(view, reload, 1);
 
 		if(result != 0)
 		{
@@ -1613,6 +1810,35 @@ populate_custom_view(FileView *view, int reload)
 	return 0;
 }
 
+/* Reloads tree-view either by scanning file system anew or by rebuilding list
+ * from already scanned tree.  The reload parameter has the same meaning as for
+ * start_dir_list_change().  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+reload_tree(FileView *view, int reload, int rescan)
+{
+	dir_entry_t *prev_dir_entries;
+	int prev_list_rows, result;
+
+	start_dir_list_change(view, &prev_dir_entries, &prev_list_rows, reload);
+	result = rescan
+	       ? flist_load_tree_internal(view, flist_get_dir(view), 1)
+	       : build_tree(view, flist_get_dir(view), 1);
+
+	if(view->dir_entry == NULL)
+	{
+		/* Restore original list in case of failure. */
+		view->dir_entry = prev_dir_entries;
+		view->list_rows = prev_list_rows;
+	}
+	else
+	{
+		finish_dir_list_change(view, prev_dir_entries, prev_list_rows);
+	}
+
+	return result;
+}
+
 int
 filter_in_compare(FileView *view, void *arg, zap_filter filter)
 {
@@ -1670,7 +1896,7 @@ zap_compare_view(FileView *view, FileView *other, zap_filter filter, void *arg)
 				}
 				continue;
 			}
-			replace_string(&entry->name, "");
+			(void)fentry_set_name(entry, "");
 			entry->type = FT_UNK;
 			entry->id = other->dir_entry[i].id;
 		}
@@ -1719,9 +1945,11 @@ update_dir_watcher(FileView *view)
 	int error;
 	const char *const curr_dir = flist_get_dir(view);
 
-	if(view->watch == NULL || stroscmp(view->watched_dir, curr_dir) != 0)
+	if(view->watch == NULL || view->watch_tree ||
+			stroscmp(view->watched_dir, curr_dir) != 0)
 	{
 		fswatch_free(view->watch);
+		view->watch_tree = 0;
 
 		view->watch = fswatch_create(curr_dir);
 		if(view->watch == NULL)
@@ -1739,6 +1967,244 @@ update_dir_watcher(FileView *view)
 	return error;
 }
 
+/* Makes watcher of the view monitor all directories of its tree.  Either
+ * replaces the watcher or extends it with directories that were listed since
+ * its last update.  On failure to watch some of them, tree_has_changed() is
+ * used to detect changes. */
+static void
+update_tree_watcher(FileView *view, int recreate)
+{
+	int error;
+	const char *const root = flist_get_dir(view);
+
+	if(!recreate && view->watch != NULL && view->watch_tree)
+	{
+		view->watch_tree = (watch_tree_dirs(view->watch, view->custom.tree, 0)
+		                 == 0);
+		return;
+	}
+
+	fswatch_free(view->watch);
+	view->watch_tree = 0;
+
+	view->watch = fswatch_create(root);
+	if(view->watch == NULL)
+	{
+		return;
+	}
+	copy_str(view->watched_dir, sizeof(view->watched_dir), root);
+
+	view->watch_tree = (view->custom.tree != NULL)
+	                && watch_tree_dirs(view->watch, view->custom.tree, 1) == 0;
+
+	(void)fswatch_changed(view->watch, &error);
+}
+
+/* Adds directories of a tree to the watcher, either all of them or only fresh
+ * ones.  Returns zero on success, otherwise non-zero is returned. */
+static int
+watch_tree_dirs(fswatch_t *watch, tree_dir_t *dir, int all)
+{
+	int i;
+
+	if(all || dir->fresh)
+	{
+		if(fswatch_add(watch, dir->path) != 0)
+		{
+			return 1;
+		}
+		dir->fresh = 0;
+	}
+
+	for(i = 0; i < dir->nfiles; ++i)
+	{
+		tree_dir_t *const subdir = dir->files[i].dir;
+		if(subdir != NULL && watch_tree_dirs(watch, subdir, all) != 0)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Updates file list of the view according to changes of individual files
+ * reported by its watcher, which is much cheaper than rereading whole
+ * directory.  Returns zero on success, otherwise non-zero is returned and the
+ * view should be reloaded. */
+static int
+apply_file_events(FileView *view)
+{
+	int i, count;
+	const fswatch_event_t *events;
+	int existence_changed = 0;
+
+	if(flist_custom_active(view) || !sort_is_incremental(view))
+	{
+		return 1;
+	}
+
+	/* List of a single entry might be ".." that's added to an empty list. */
+	events = fswatch_get_events(view->watch, &count);
+	if(events == NULL || view->list_rows <= 1 ||
+			count*MAX_CHANGED_PART > view->list_rows)
+	{
+		return 1;
+	}
+
+	for(i = 0; i < count; ++i)
+	{
+		if(apply_file_event(view, &events[i]) != 0)
+		{
+			return 1;
+		}
+		existence_changed |= (events[i].kind != FSWE_CHANGED);
+	}
+
+	if(view->list_rows == 0)
+	{
+		return 1;
+	}
+
+	/* Appeared or disappeared files could be targets of symbolic links that
+	 * point into this directory. */
+	if(existence_changed)
+	{
+		for(i = 0; i < view->list_rows; ++i)
+		{
+			if(view->dir_entry[i].local_link)
+			{
+				view->dir_entry[i].link_checked = 0;
+			}
+		}
+	}
+
+	fview_list_updated(view);
+	return 0;
+}
+
+/* Brings entry of a single file in sync with its state on file system.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+apply_file_event(FileView *view, const fswatch_event_t *event)
+{
+	char full_path[PATH_MAX];
+	dir_entry_t prev, entry;
+	int exists, visible, new_pos;
+	const int pos = flist_find_entry(view, event->name, NULL);
+	const int was_current = (pos >= 0 && pos == view->list_pos);
+
+	if(pos >= 0)
+	{
+		take_entry_out(view, pos, &prev);
+	}
+	else if(event->kind != FSWE_CREATED && view->filtered > 0)
+	{
+		/* The file existed, but wasn't in the list, so it was filtered out. */
+		--view->filtered;
+	}
+
+	init_dir_entry(view, &entry, event->name, NULL);
+	if(entry.name == NULL)
+	{
+		if(pos >= 0)
+		{
+			fentry_free(view, &prev);
+		}
+		return 1;
+	}
+
+	get_full_path_of(&entry, sizeof(full_path), full_path);
+	exists = (fill_dir_entry_by_path(&entry, full_path) == 0);
+	visible = exists
+	       && file_is_visible(view, entry.name, fentry_is_dir(&entry), NULL, 1);
+
+	if(pos >= 0)
+	{
+		merge_entries(&entry, &prev);
+		fentry_free(view, &prev);
+	}
+
+	if(!visible)
+	{
+		view->filtered += exists;
+		fentry_free(view, &entry);
+		return 0;
+	}
+
+	new_pos = put_entry_in(view, &entry);
+	if(new_pos < 0)
+	{
+		fentry_free(view, &entry);
+		return 1;
+	}
+
+	if(was_current)
+	{
+		/* Keep cursor on the file. */
+		view->list_pos = new_pos;
+	}
+	return 0;
+}
+
+/* Removes entry at specified position from the list of the view moving it to
+ * *entry. */
+static void
+take_entry_out(FileView *view, int pos, dir_entry_t *entry)
+{
+	*entry = view->dir_entry[pos];
+
+	memmove(&view->dir_entry[pos], &view->dir_entry[pos + 1],
+			sizeof(*view->dir_entry)*(view->list_rows - pos - 1));
+	--view->list_rows;
+
+	view->selected_files -= (entry->selected != 0);
+	if(view->list_pos > pos ||
+			(view->list_pos == pos && pos == view->list_rows && pos != 0))
+	{
+		--view->list_pos;
+	}
+}
+
+/* Inserts entry into sorted list of the view at its position.  Returns the
+ * position on success, otherwise -1 is returned. */
+static int
+put_entry_in(FileView *view, const dir_entry_t *entry)
+{
+	int lo = 0, hi = view->list_rows;
+
+	if(alloc_dir_entry(&view->dir_entry, view->list_rows) == NULL)
+	{
+		return -1;
+	}
+
+	while(lo < hi)
+	{
+		const int mid = lo + (hi - lo)/2;
+		if(sort_compare_entries(view, &view->dir_entry[mid], entry) <= 0)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	if(view->list_rows != 0 && view->list_pos >= lo)
+	{
+		++view->list_pos;
+	}
+
+	memmove(&view->dir_entry[lo + 1], &view->dir_entry[lo],
+			sizeof(*view->dir_entry)*(view->list_rows - lo));
+	view->dir_entry[lo] = *entry;
+	++view->list_rows;
+
+	view->selected_files += (entry->selected != 0);
+	return lo;
+}
+
 /* Checks whether currently loaded custom list of files is missing some files
  * compared to the original custom list.  Returns non-zero if so, otherwise zero
  * is returned. */
@@ -1952,13 +2418,20 @@ free_view_entries(FileView *view)
 	free_dir_entries(view, &view->dir_entry, &view->list_rows);
 }
 
-/* Updates file list with files from current directory.  Returns zero on
- * success, otherwise non-zero is returned. */
+/* Updates file list with files from current directory.  Non-NULL interrupted
+ * enables progress reporting and cancellation of reading, in which case it's
+ * set to non-zero if the list was left incomplete on user request.  Returns
+ * zero on success, otherwise non-zero is returned. */
 static int
-update_dir_list(FileView *view, int reload)
+update_dir_list(FileView *view, int reload, int *interrupted)
 {
 	dir_entry_t *prev_dir_entries;
 	int prev_list_rows;
+	int failed;
+	dir_reading_t reading = {
+		.view = view,
+		.interactive = (interrupted != NULL),
+	};
 
 	start_dir_list_change(view, &prev_dir_entries, &prev_list_rows, reload);
 
@@ -1971,19 +2444,50 @@ update_dir_list(FileView *view, int reload)
 	}
 #endif
 
-	if(enum_dir_content(view->curr_dir, &add_file_entry_to_view, view) != 0)
+	if(reading.interactive)
+	{
+		show_progress(NULL, 0);
+		ui_cancellation_reset();
+		ui_cancellation_enable();
+	}
+
+	/* Names are released together with the list they end up in, so allocating
+	 * them in bulk saves a lot of time and memory for large directories. */
+	reading.names = arena_create();
+	failed = (enum_dir_content(view->curr_dir, &add_file_entry_to_view,
+				&reading) != 0);
+	arena_free(reading.names);
+
+	if(reading.interactive)
+	{
+		ui_cancellation_disable();
+		/* Incomplete list is still better than nothing, so just keep it. */
+		*interrupted = ui_cancellation_requested();
+	}
+
+	if(failed)
 	{
 		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", view->curr_dir);
 		free_dir_entries(view, &prev_dir_entries, &prev_list_rows);
 		return 1;
 	}
 
+#ifndef _WIN32
+	fill_dir_entries(view);
+#endif
+
 	if(cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)) ||
 			view->list_rows == 0)
 	{
 		add_parent_dir(view);
 	}
 
+	if(prev_dir_entries != NULL &&
+			update_sorted_list(view, prev_dir_entries, prev_list_rows))
+	{
+		return 0;
+	}
+
 	sort_dir_list(!reload, view);
 
 	/* Merging must be performed after sorting so that list position remains fixed
@@ -1993,15 +2497,325 @@ update_dir_list(FileView *view, int reload)
 	return 0;
 }
 
-/* Starts file list update, saving previous list for future reference if
- * necessary. */
-static void
-start_dir_list_change(FileView *view, dir_entry_t **entries, int *len,
-		int reload)
+/* Replaces list of entries that was just reread with previous sorted list
+ * without entries that disappeared and with new or changed entries inserted at
+ * their positions.  Entries with the same names inherit state of their
+ * previous versions.  This is way cheaper than sorting when few files change in
+ * a large directory.  Returns non-zero if the list was updated (previous list
+ * is consumed in this case) and zero if it should be sorted as usual. */
+static int
+update_sorted_list(FileView *view, dir_entry_t *prev, int prev_len)
 {
-	if(reload)
+	dir_entry_t *const entries = view->dir_entry;
+	const int len = view->list_rows;
+	const int prev_pos = view->list_pos;
+	int meta;
+	dir_entry_t **prev_names, **names;
+	int *prev_to_new, *new_to_prev, *origins;
+	char *retained;
+	const dir_entry_t **kept;
+	insertion_t *added;
+	dir_entry_t *list;
+	int nkept, npaired, nadded;
+	int i, j, k;
+	int closest_dist;
+
+	if(!sort_is_incremental(view) || len == 0 || prev_len == 0)
 	{
-		*entries = view->dir_entry;
+		return 0;
+	}
+
+	meta = sort_needs_meta(view);
+	if(meta)
+	{
+		flist_load_meta(view);
+	}
+
+	prev_names = index_by_name(prev, prev_len);
+	names = index_by_name(entries, len);
+	prev_to_new = reallocarray(NULL, prev_len, sizeof(*prev_to_new));
+	new_to_prev = reallocarray(NULL, len, sizeof(*new_to_prev));
+	if(prev_names == NULL || names == NULL || prev_to_new == NULL ||
+			new_to_prev == NULL)
+	{
+		free(prev_names);
+		free(names);
+		free(prev_to_new);
+		free(new_to_prev);
+		return 0;
+	}
+
+	/* Match entries of two lists by walking them in order of their names.  Only
+	 * unchanged entries keep their places, changed ones are inserted anew. */
+	for(i = 0; i < prev_len; ++i)
+	{
+		prev_to_new[i] = -1;
+	}
+	for(j = 0; j < len; ++j)
+	{
+		new_to_prev[j] = -1;
+	}
+	nkept = 0;
+	npaired = 0;
+	i = 0;
+	j = 0;
+	while(i < prev_len && j < len)
+	{
+		const int cmp = strcmp(prev_names[i]->name, names[j]->name);
+		if(cmp == 0)
+		{
+			new_to_prev[names[j] - entries] = prev_names[i] - prev;
+			++npaired;
+			if(!entry_was_changed(prev_names[i], names[j], meta))
+			{
+				prev_to_new[prev_names[i] - prev] = names[j] - entries;
+				++nkept;
+			}
+		}
+		i += (cmp <= 0);
+		j += (cmp >= 0);
+	}
+	free(prev_names);
+	free(names);
+
+	nadded = len - nkept;
+	if((nadded + (prev_len - npaired))*MAX_CHANGED_PART > len)
+	{
+		free(prev_to_new);
+		free(new_to_prev);
+		return 0;
+	}
+
+	retained = calloc(len, 1);
+	kept = reallocarray(NULL, nkept, sizeof(*kept));
+	added = reallocarray(NULL, nadded + 1, sizeof(*added));
+	origins = reallocarray(NULL, len, sizeof(*origins));
+	list = dynarray_extend(NULL, len*sizeof(*list));
+	if(retained == NULL || kept == NULL || added == NULL || origins == NULL ||
+			list == NULL)
+	{
+		free(prev_to_new);
+		free(new_to_prev);
+		free(retained);
+		free(kept);
+		free(added);
+		free(origins);
+		dynarray_free(list);
+		return 0;
+	}
+
+	/* Retained entries preserve their order. */
+	for(i = 0, k = 0; i < prev_len; ++i)
+	{
+		if(prev_to_new[i] >= 0)
+		{
+			kept[k++] = &entries[prev_to_new[i]];
+			retained[prev_to_new[i]] = 1;
+		}
+	}
+
+	for(i = 0, k = 0; i < len; ++i)
+	{
+		if(!retained[i])
+		{
+			added[k].pos = find_insert_pos(view, &entries[i], kept, nkept);
+			added[k].index = i;
+			++k;
+		}
+	}
+	order_insertions(view, added, nadded);
+	/* Sentinel that simplifies the loop below. */
+	added[nadded].pos = INT_MAX;
+
+	for(i = 0, j = 0, k = 0; i < prev_len; ++i)
+	{
+		if(prev_to_new[i] < 0)
+		{
+			continue;
+		}
+
+		/* k - j is number of retained entries that are already in the list. */
+		while(added[j].pos == k - j)
+		{
+			origins[k] = new_to_prev[added[j].index];
+			list[k++] = entries[added[j++].index];
+		}
+
+		origins[k] = i;
+		list[k++] = entries[prev_to_new[i]];
+	}
+	while(j < nadded)
+	{
+		origins[k] = new_to_prev[added[j].index];
+		list[k++] = entries[added[j++].index];
+	}
+
+	/* Transfer state of files that were in the list before in the same order
+	 * merge_lists() does it. */
+	closest_dist = INT_MIN;
+	for(k = 0; k < len; ++k)
+	{
+		if(origins[k] >= 0)
+		{
+			merge_entries(&list[k], &prev[origins[k]]);
+			view->selected_files += (list[k].selected != 0);
+			closest_dist = correct_pos(view, k, origins[k] - prev_pos, closest_dist);
+		}
+	}
+
+	free(prev_to_new);
+	free(new_to_prev);
+	free(retained);
+	free(kept);
+	free(added);
+	free(origins);
+
+	/* Entries were moved to the new list, so free only the array. */
+	dynarray_free(view->dir_entry);
+	view->dir_entry = list;
+	free_dir_entries(view, &prev, &prev_len);
+	return 1;
+}
+
+/* Makes array of pointers to entries ordered by names of entries.  Returns the
+ * array or NULL on memory allocation error. */
+static dir_entry_t **
+index_by_name(dir_entry_t *entries, int len)
+{
+	int i;
+	dir_entry_t **const index = reallocarray(NULL, len, sizeof(*index));
+	if(index == NULL)
+	{
+		return NULL;
+	}
+
+	for(i = 0; i < len; ++i)
+	{
+		index[i] = &entries[i];
+	}
+	qsort(index, len, sizeof(*index), &name_ptr_cmp);
+	return index;
+}
+
+/* qsort() comparer of pointers to entries by their names.  Returns standard
+ * -1, 0, 1 for comparisons. */
+static int
+name_ptr_cmp(const void *a, const void *b)
+{
+	const dir_entry_t *const *const x = a;
+	const dir_entry_t *const *const y = b;
+	return strcmp((*x)->name, (*y)->name);
+}
+
+/* Checks whether file changed in a way that can affect its position in sorted
+ * list.  Returns non-zero if so, otherwise zero is returned. */
+static int
+entry_was_changed(const dir_entry_t *prev, const dir_entry_t *curr, int meta)
+{
+	/* Executables are distinguished only after loading meta-data, which might
+	 * not be loaded for the new entry yet, while change of permissions is
+	 * checked below. */
+	if(normalize_type(prev->type) != normalize_type(curr->type))
+	{
+		return 1;
+	}
+
+	if(!meta)
+	{
+		return 0;
+	}
+
+	return prev->size != curr->size
+#ifndef _WIN32
+	    || prev->uid != curr->uid
+	    || prev->gid != curr->gid
+	    || prev->mode != curr->mode
+#endif
+	    || prev->mtime != curr->mtime
+	    || prev->atime != curr->atime
+	    || prev->ctime != curr->ctime
+	    || prev->nlinks != curr->nlinks;
+}
+
+/* Maps types of files that are told apart only by their meta-data to a common
+ * type.  Returns the type. */
+static FileType
+normalize_type(FileType type)
+{
+	return (type == FT_EXEC) ? FT_REG : type;
+}
+
+/* Finds position of an entry in sorted list of retained entries after all
+ * entries that are equivalent to it.  Returns the position. */
+static int
+find_insert_pos(const FileView *view, const dir_entry_t *entry,
+		const dir_entry_t *kept[], int nkept)
+{
+	int lo = 0, hi = nkept;
+	while(lo < hi)
+	{
+		const int mid = lo + (hi - lo)/2;
+		if(sort_compare_entries(view, kept[mid], entry) <= 0)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/* qsort() comparer of insertions by their position.  Returns standard -1, 0, 1
+ * for comparisons. */
+static int
+insertion_cmp(const void *a, const void *b)
+{
+	const insertion_t *const x = a;
+	const insertion_t *const y = b;
+	if(x->pos != y->pos)
+	{
+		return (x->pos < y->pos) ? -1 : 1;
+	}
+	return (x->index < y->index) ? -1 : (x->index > y->index);
+}
+
+/* Orders insertions by their positions and sorts entries that are inserted at
+ * the same position. */
+static void
+order_insertions(const FileView *view, insertion_t added[], int nadded)
+{
+	int i;
+
+	qsort(added, nadded, sizeof(*added), &insertion_cmp);
+
+	/* Entries are usually inserted at different places, so insertion sort of
+	 * each group is fine. */
+	for(i = 1; i < nadded; ++i)
+	{
+		const insertion_t item = added[i];
+		int j = i;
+		while(j > 0 && added[j - 1].pos == item.pos &&
+				sort_compare_entries(view, &view->dir_entry[added[j - 1].index],
+					&view->dir_entry[item.index]) > 0)
+		{
+			added[j] = added[j - 1];
+			--j;
+		}
+		added[j] = item;
+	}
+}
+
+/* Starts file list update, saving previous list for future reference if
+ * necessary. */
+static void
+start_dir_list_change(FileView *view, dir_entry_t **entries, int *len,
+		int reload)
+{
+	if(reload)
+	{
+		*entries = view->dir_entry;
 		*len = view->list_rows;
 		view->dir_entry = NULL;
 		view->list_rows = 0;
@@ -2036,9 +2850,19 @@ finish_dir_list_change(FileView *view, dir_entry_t *entries, int len)
 static int
 add_file_entry_to_view(const char name[], const void *data, void *param)
 {
-	FileView *const view = param;
+	dir_reading_t *const reading = param;
+	FileView *const view = reading->view;
 	dir_entry_t *entry;
 
+	if(reading->interactive)
+	{
+		if(ui_cancellation_requested())
+		{
+			return 1;
+		}
+		show_progress("Reading directory...", 1000);
+	}
+
 	/* Always ignore the "." and ".." directories. */
 	if(strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
 	{
@@ -2058,8 +2882,16 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 		return 1;
 	}
 
-	init_dir_entry(view, entry, name);
+	init_dir_entry(view, entry, name, reading->names);
 
+#ifndef _WIN32
+	/* The entry is filled later either by fill_dir_entries() or on demand by
+	 * fentry_load_meta(), reading meta-data of every file can be slow and often
+	 * isn't needed on slow file systems. */
+	entry->type = type_from_dir_entry(data);
+	entry->no_meta = 1;
+	++view->list_rows;
+#else
 	if(fill_dir_entry(entry, entry->name, data) == 0)
 	{
 		++view->list_rows;
@@ -2068,6 +2900,7 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 	{
 		fentry_free(view, entry);
 	}
+#endif
 
 	return 0;
 }
@@ -2123,7 +2956,9 @@ merge_lists(FileView *view, dir_entry_t *entries, int len)
 		add_to_trie(prev_names, view, &entries[i]);
 
 		/* We won't use the name later, so free some memory. */
-		update_string(&entries[i].name, NULL);
+		free_entry_str(entries[i].name, entries[i].arena_name);
+		entries[i].name = NULL;
+		entries[i].arena_name = 0;
 	}
 
 	closest_dist = INT_MIN;
@@ -2279,12 +3114,23 @@ add_parent_dir(FileView *view)
 }
 
 /* Initializes dir_entry_t with name and all other fields with default
- * values. */
+ * values.  Name is allocated from the arena if it's not NULL.  NULL name leaves
+ * name field unset. */
 static void
-init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
+init_dir_entry(FileView *view, dir_entry_t *entry, const char name[],
+		arena_t *arena)
 {
-	entry->name = strdup(name);
+	if(name == NULL)
+	{
+		entry->name = NULL;
+	}
+	else
+	{
+		entry->name = (arena == NULL) ? strdup(name) : arena_strdup(arena, name);
+	}
+	entry->arena_name = (arena != NULL);
 	entry->origin = &view->curr_dir[0];
+	entry->arena_origin = 0;
 
 	entry->size = 0ULL;
 #ifndef _WIN32
@@ -2312,6 +3158,9 @@ init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
 	entry->search_match = 0;
 	entry->marked = 0;
 	entry->temporary = 0;
+	entry->no_meta = 0;
+	entry->link_checked = 0;
+	entry->local_link = 0;
 
 	entry->tag = -1;
 	entry->id = -1;
@@ -2336,8 +3185,8 @@ replace_dir_entries(FileView *view, dir_entry_t **entries, int *count,
 	{
 		dir_entry_t *const entry = &new[i];
 
-		entry->name = strdup(entry->name);
-		entry->origin = strdup(entry->origin);
+		entry->name = copy_entry_str(entry->name, entry->arena_name);
+		entry->origin = copy_entry_str(entry->origin, entry->arena_origin);
 
 		if(entry->name == NULL || entry->origin == NULL)
 		{
@@ -2369,13 +3218,42 @@ free_dir_entries(FileView *view, dir_entry_t **entries, int *count)
 void
 fentry_free(const FileView *view, dir_entry_t *entry)
 {
-	free(entry->name);
+	free_entry_str(entry->name, entry->arena_name);
 	entry->name = NULL;
+	entry->arena_name = 0;
 
 	if(entry->origin != &view->curr_dir[0])
 	{
-		free(entry->origin);
+		free_entry_str(entry->origin, entry->arena_origin);
 		entry->origin = NULL;
+		entry->arena_origin = 0;
+	}
+}
+
+/* Makes a copy of a string of an entry, which might be allocated from arena.
+ * Returns the copy, which has the same allocation kind, or NULL on error. */
+static char *
+copy_entry_str(char str[], int in_arena)
+{
+	if(in_arena)
+	{
+		arena_ref(str);
+		return str;
+	}
+	return strdup(str);
+}
+
+/* Frees a string of an entry, which might be allocated from arena. */
+static void
+free_entry_str(char str[], int in_arena)
+{
+	if(in_arena)
+	{
+		arena_release(str);
+	}
+	else
+	{
+		free(str);
 	}
 }
 
@@ -2403,7 +3281,7 @@ entry_list_add(FileView *view, dir_entry_t **list, int *list_size,
 		return NULL;
 	}
 
-	init_dir_entry(view, dir_entry, get_last_path_component(path));
+	init_dir_entry(view, dir_entry, get_last_path_component(path), NULL);
 
 	dir_entry->origin = strdup(path);
 	remove_last_path_component(dir_entry->origin);
@@ -2478,10 +3356,19 @@ check_if_filelist_have_changed(FileView *view)
 
 	if(changed)
 	{
-		ui_view_schedule_reload(view);
+		if(apply_file_events(view) == 0 || apply_tree_events(view) == 0)
+		{
+			ui_view_schedule_redraw(view);
+		}
+		else
+		{
+			ui_view_schedule_reload(view);
+		}
 	}
-	else if(flist_custom_active(view) && view->custom.type == CV_TREE)
+	else if(flist_custom_active(view) && view->custom.type == CV_TREE &&
+			!view->watch_tree)
 	{
+		/* Fallback to polling of directories when they aren't all watched. */
 		if(tree_has_changed(view->dir_entry, view->list_rows))
 		{
 			ui_view_schedule_reload(view);
@@ -2897,7 +3784,9 @@ uint64_t
 get_file_size_by_entry(const FileView *view, size_t pos)
 {
 	uint64_t size = 0;
-	const dir_entry_t *const entry = &view->dir_entry[pos];
+	dir_entry_t *const entry = &view->dir_entry[pos];
+
+	fentry_load_meta(entry);
 
 	size = DCACHE_UNKNOWN;
 	if(fentry_is_dir(entry))
@@ -3215,6 +4104,7 @@ void
 fentry_rename(FileView *view, dir_entry_t *entry, const char to[])
 {
 	char *const old_name = entry->name;
+	const int old_in_arena = entry->arena_name;
 
 	/* Rename file in internal structures for correct positioning of cursor
 	 * after reloading, as cursor will be positioned on the file with the same
@@ -3225,11 +4115,13 @@ fentry_rename(FileView *view, dir_entry_t *entry, const char to[])
 		entry->name = old_name;
 		return;
 	}
+	entry->arena_name = 0;
 
 	/* Name change can affect name specific highlight and decorations, so reset
-	 * the caches. */
+	 * the caches.  Relative link might point somewhere else now. */
 	entry->hi_num = -1;
 	entry->name_dec_num = -1;
+	entry->link_checked = 0;
 
 	if(flist_custom_active(view) && fentry_is_dir(entry))
 	{
@@ -3247,16 +4139,51 @@ fentry_rename(FileView *view, dir_entry_t *entry, const char to[])
 				chosp(new_origin);
 				if(e->origin != view->curr_dir)
 				{
-					free(e->origin);
+					free_entry_str(e->origin, e->arena_origin);
 				}
 				e->origin = new_origin;
+				e->arena_origin = 0;
 			}
 		}
 
 		free(root);
 	}
 
-	free(old_name);
+	free_entry_str(old_name, old_in_arena);
+}
+
+int
+fentry_set_name(dir_entry_t *entry, const char name[])
+{
+	char *const copy = strdup(name);
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	free_entry_str(entry->name, entry->arena_name);
+	entry->name = copy;
+	entry->arena_name = 0;
+	return 0;
+}
+
+int
+fentry_set_origin(const FileView *view, dir_entry_t *entry,
+		const char origin[])
+{
+	char *const copy = strdup(origin);
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	if(entry->origin != &view->curr_dir[0])
+	{
+		free_entry_str(entry->origin, entry->arena_origin);
+	}
+	entry->origin = copy;
+	entry->arena_origin = 0;
+	return 0;
 }
 
 int
@@ -3290,6 +4217,50 @@ fentry_is_dir(const dir_entry_t *entry)
 	return 0;
 }
 
+void
+fentry_load_meta(dir_entry_t *entry)
+{
+#ifndef _WIN32
+	char full_path[PATH_MAX];
+	FileType type;
+
+	if(!entry->no_meta)
+	{
+		return;
+	}
+
+	type = entry->type;
+	get_full_path_of(entry, sizeof(full_path), full_path);
+	if(fill_dir_entry(entry, full_path, type) != 0)
+	{
+		/* Keep what we know, there is no point in querying file again. */
+		entry->type = type;
+		entry->no_meta = 0;
+	}
+#endif
+}
+
+void
+flist_load_meta(FileView *view)
+{
+	const size_t count = view->list_rows;
+	par_for(count, PARALLEL_CHUNK, count >= PARALLEL_THRESHOLD ? 0 : 1,
+			&load_meta_range, view->dir_entry);
+}
+
+/* par_for() callback that loads meta-data of part of array of entries. */
+static void
+load_meta_range(size_t from, size_t to, void *arg)
+{
+	dir_entry_t *const entries = arg;
+
+	size_t i;
+	for(i = from; i < to; ++i)
+	{
+		fentry_load_meta(&entries[i]);
+	}
+}
+
 int
 flist_load_tree(FileView *view, const char path[])
 {
@@ -3340,6 +4311,8 @@ flist_load_tree_internal(FileView *view, const char path[], int reload)
 		return 1;
 	}
 
+	update_tree_watcher(view, 1);
+
 	if(!reload)
 	{
 		trie_free(view->custom.excluded_paths);
@@ -3353,27 +4326,52 @@ flist_load_tree_internal(FileView *view, const char path[], int reload)
 static int
 make_tree(FileView *view, const char path[], int reload, trie_t *excluded_paths)
 {
-	char canonic_path[PATH_MAX];
-	int nfiltered;
-
-	flist_custom_start(view, "tree");
+	tree_dir_t *root;
 
 	show_progress("Building tree...", 0);
 
 	ui_cancellation_reset();
 	ui_cancellation_enable();
-	nfiltered = add_files_recursively(view, path, excluded_paths, -1, 0);
+	root = scan_tree(view, path, excluded_paths);
 	ui_cancellation_disable();
 
 	ui_sb_quick_msg_clear();
 
 	if(ui_cancellation_requested())
 	{
+		free_tree_dir(view, root);
 		return 1;
 	}
 
+	/* The tree is kept to be able to update the view by listing only changed
+	 * directories. */
+	free_tree(view);
+	view->custom.tree = root;
+
+	return build_tree(view, path, reload);
+}
+
+/* Fills the view with files of previously scanned tree.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+build_tree(FileView *view, const char path[], int reload)
+{
+	char canonic_path[PATH_MAX];
+	int nfiltered;
+	tree_dir_t *const root = view->custom.tree;
+	arena_t *arena;
+
+	flist_custom_start(view, "tree");
+
+	arena = arena_create();
+	nfiltered = (root == NULL || arena == NULL)
+	          ? -1
+	          : add_files_recursively(view, root, arena, -1, 0);
+	arena_free(arena);
+
 	if(nfiltered < 0)
 	{
+		free_tree(view);
 		show_error_msg("Tree View", "Failed to list directory");
 		return 1;
 	}
@@ -3392,60 +4390,482 @@ make_tree(FileView *view, const char path[], int reload, trie_t *excluded_paths)
 	return 0;
 }
 
-/* Adds custom view entries corresponding to file system tree.  parent_pos is
- * expected to be negative for the outermost invocation.  Returns number of
- * filtered out files on success or partial success and negative value on
- * serious error. */
+/* Reads file system tree at the path querying information about files.
+ * Directories are processed on several threads, while this one displays
+ * progress and checks for cancellation.  Returns root of the tree or NULL on
+ * error. */
+static tree_dir_t *
+scan_tree(FileView *view, const char path[], trie_t *excluded_paths)
+{
+	tree_scan_t scan = {
+		.view = view,
+		.excluded_paths = excluded_paths,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.nfiles = 0,
+	};
+
+	tree_dir_t *const root = alloc_tree_dir(path);
+	if(root == NULL)
+	{
+		return NULL;
+	}
+
+	(void)par_run(root, 0, &scan_tree_dir, &report_scan_progress, &scan);
+	pthread_mutex_destroy(&scan.lock);
+	return root;
+}
+
+/* Updates tree of the view by listing anew only directories in which its
+ * watcher has detected changes and rebuilds list of files from the tree.
+ * Returns zero on success, otherwise non-zero is returned and the view should
+ * be reloaded. */
 static int
-add_files_recursively(FileView *view, const char path[], trie_t *excluded_paths,
-		int parent_pos, int no_direct_parent)
+apply_tree_events(FileView *view)
+{
+	int i, count;
+	const char *const *dirs;
+	const char **order;
+	tree_file_t *file;
+	char full_path[PATH_MAX];
+	tree_dir_t *const root = view->custom.tree;
+
+	if(!flist_custom_active(view) || view->custom.type != CV_TREE ||
+			!view->watch_tree || root == NULL || view->local_filter.in_progress)
+	{
+		return 1;
+	}
+
+	dirs = fswatch_get_dirs(view->watch, &count);
+	if(dirs == NULL || count == 0)
+	{
+		return (dirs == NULL);
+	}
+
+	/* A directory that's not part of the tree is watched under a different path
+	 * (e.g., after being moved), there is no way to tell what has changed. */
+	for(i = 0; i < count; ++i)
+	{
+		if(find_tree_dir(root, dirs[i], &file) == NULL)
+		{
+			return 1;
+		}
+	}
+
+	order = reallocarray(NULL, count, sizeof(*order));
+	if(order == NULL)
+	{
+		return 1;
+	}
+
+	/* Parents are processed before their children, because listing parent can
+	 * remove children or list them as well. */
+	memcpy(order, dirs, sizeof(*order)*count);
+	qsort(order, count, sizeof(*order), &path_len_cmp);
+
+	for(i = 0; i < count; ++i)
+	{
+		tree_dir_t *const dir = find_tree_dir(root, order[i], &file);
+		if(dir == NULL || dir->fresh)
+		{
+			continue;
+		}
+
+		relist_tree_dir(view, dir);
+
+		/* Timestamps of the directory have changed as well. */
+		if(file != NULL && file->visible)
+		{
+			file->failed = (fill_dir_entry_by_path(&file->entry, file->path) != 0);
+		}
+	}
+
+	free(order);
+
+	refilter_tree(view, root);
+
+	get_current_full_path(view, sizeof(full_path), full_path);
+	if(reload_tree(view, 1, 0) != 0)
+	{
+		return 1;
+	}
+	flist_goto_by_path(view, full_path);
+
+	update_tree_watcher(view, 0);
+	return 0;
+}
+
+/* Lists directory of a tree anew reusing its unchanged subdirectories. */
+static void
+relist_tree_dir(FileView *view, tree_dir_t *dir)
+{
+	tree_scan_t scan = {
+		.view = view,
+		.excluded_paths = view->custom.excluded_paths,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.nfiles = 0,
+		.relisted = dir,
+		.prev_files = dir->files,
+		.prev_nfiles = dir->nfiles,
+		.prev_pos = 0,
+	};
+
+	dir->files = NULL;
+	dir->nfiles = -1;
+	/* The directory might have been replaced, so it needs to be watched anew. */
+	dir->fresh = 1;
+
+	(void)par_run(dir, 0, &scan_tree_dir, NULL, &scan);
+	pthread_mutex_destroy(&scan.lock);
+
+	free_tree_files(view, scan.prev_files, scan.prev_nfiles);
+}
+
+/* Applies filters to files of a tree, because they could have been changed
+ * after the tree was scanned without rescanning it (e.g., local filter). */
+static void
+refilter_tree(FileView *view, tree_dir_t *dir)
 {
 	int i;
-	const int prev_count = view->custom.entry_count;
-	int nfiltered = 0;
 
-	int len;
-	char **lst = list_all_files(path, &len);
+	for(i = 0; i < dir->nfiles; ++i)
+	{
+		tree_file_t *const file = &dir->files[i];
+
+		if(file->visible)
+		{
+			const int dir_like = (file->entry.type == FT_DIR)
+			                  || (file->entry.type == FT_LINK && is_dir(file->path));
+			if(!file_is_visible(view, file->name, dir_like, NULL, 1))
+			{
+				file->visible = 0;
+
+				/* Contents of directories that are filtered out not only by local
+				 * filter aren't part of the tree. */
+				if(file->dir != NULL &&
+						!file_is_visible(view, file->name, dir_like, NULL, 0))
+				{
+					free_tree_dir(view, file->dir);
+					file->dir = NULL;
+				}
+			}
+		}
+
+		if(file->dir != NULL)
+		{
+			refilter_tree(view, file->dir);
+		}
+	}
+}
+
+/* Looks up directory of a tree by its path.  Sets *file to the record of the
+ * directory in its parent or to NULL for the root.  Returns the directory or
+ * NULL if it's not part of the tree. */
+static tree_dir_t *
+find_tree_dir(tree_dir_t *root, const char path[], tree_file_t **file)
+{
+	tree_dir_t *dir = root;
+
+	*file = NULL;
+	while(strcmp(dir->path, path) != 0)
+	{
+		int i;
+
+		for(i = 0; i < dir->nfiles; ++i)
+		{
+			tree_dir_t *const subdir = dir->files[i].dir;
+			if(subdir != NULL && path_starts_with(path, subdir->path))
+			{
+				break;
+			}
+		}
+
+		if(i >= dir->nfiles)
+		{
+			return NULL;
+		}
+
+		*file = &dir->files[i];
+		dir = (*file)->dir;
+	}
+
+	return dir;
+}
+
+/* qsort() comparer that orders paths by their length.  Returns standard -1, 0,
+ * 1 for comparisons. */
+static int
+path_len_cmp(const void *a, const void *b)
+{
+	const size_t a_len = strlen(*(const char **)a);
+	const size_t b_len = strlen(*(const char **)b);
+	return (a_len > b_len) - (a_len < b_len);
+}
+
+/* par_run() callback that lists single directory of a tree and queues its
+ * subdirectories that need to be traversed. */
+static void
+scan_tree_dir(par_queue_t *queue, void *task, void *arg)
+{
+	tree_scan_t *const scan = arg;
+	FileView *const view = scan->view;
+	tree_dir_t *const dir = task;
+	int i, len;
+	char **lst;
+
+	lst = list_all_files(dir->path, &len);
 	if(len < 0)
 	{
-		return -1;
+		return;
 	}
 
-	for(i = 0; i < len && !ui_cancellation_requested(); ++i)
+	dir->files = reallocarray(NULL, len, sizeof(*dir->files));
+	if(dir->files == NULL && len != 0)
+	{
+		free_string_array(lst, len);
+		return;
+	}
+
+	dir->nfiles = 0;
+	for(i = 0; i < len; ++i)
 	{
-		int dir;
 		void *dummy;
-		dir_entry_t *entry;
-		char *const full_path = format_str("%s/%s", path, lst[i]);
+		char canonic_path[PATH_MAX];
+		tree_file_t *const file = &dir->files[dir->nfiles];
+		char *const full_path = format_str("%s/%s", dir->path, lst[i]);
+		const int dir_like = is_dir(full_path);
 
-		if(trie_get(excluded_paths, full_path, &dummy) == 0)
+		if(trie_get(scan->excluded_paths, full_path, &dummy) == 0)
 		{
 			free(full_path);
 			continue;
 		}
 
-		dir = is_dir(full_path);
-		if(!file_is_visible(view, lst[i], dir, NULL, 1))
+		to_canonic_path(full_path, flist_get_dir(view), canonic_path,
+				sizeof(canonic_path));
+
+		file->name = lst[i];
+		lst[i] = NULL;
+		file->path = strdup(canonic_path);
+		file->visible = file_is_visible(view, file->name, dir_like, NULL, 1);
+		file->failed = (file->path == NULL);
+		file->dir = NULL;
+		/* Name and origin are set when the entry is added to the list. */
+		init_dir_entry(view, &file->entry, NULL, NULL);
+
+		if(!file->visible)
 		{
 			/* Traverse directory (but not symlink to it) even if we're skipping it,
 			 * because we might need files that are inside of it. */
-			if(dir && !is_symlink(full_path) &&
-					file_is_visible(view, lst[i], dir, NULL, 0))
+			if(dir_like && !is_symlink(full_path) &&
+					file_is_visible(view, file->name, dir_like, NULL, 0))
 			{
-				nfiltered += add_files_recursively(view, full_path, excluded_paths,
-						parent_pos, 1);
+				file->dir = alloc_tree_dir(full_path);
+			}
+		}
+		else if(!file->failed)
+		{
+			file->failed = (fill_dir_entry_by_path(&file->entry, canonic_path) != 0);
+
+			/* Not using dir_like variable here, because it is set for symlinks to
+			 * directories as well. */
+			if(!file->failed && file->entry.type == FT_DIR)
+			{
+				file->dir = reuse_tree_dir(scan, dir, file);
+				if(file->dir != NULL)
+				{
+					/* Listing of the directory is up to date. */
+					free(full_path);
+					++dir->nfiles;
+					continue;
+				}
+
+				file->dir = alloc_tree_dir(full_path);
+			}
+		}
+
+		if(file->dir != NULL && par_push(queue, file->dir) != 0)
+		{
+			/* Leave the directory as failed to be listed. */
+		}
+
+		free(full_path);
+		++dir->nfiles;
+	}
+
+	free_string_array(lst, len);
+
+	pthread_mutex_lock(&scan->lock);
+	scan->nfiles += dir->nfiles;
+	pthread_mutex_unlock(&scan->lock);
+}
+
+/* Looks up subdirectory of previous listing of the directory that is being
+ * listed anew that's still valid for the file.  Returns the subdirectory, which
+ * is taken from the previous listing, or NULL. */
+static tree_dir_t *
+reuse_tree_dir(tree_scan_t *scan, const tree_dir_t *dir,
+		const tree_file_t *file)
+{
+	int i;
+
+	if(dir != scan->relisted)
+	{
+		return NULL;
+	}
+
+	/* Order of files rarely changes, so lookup continues from the last match. */
+	for(i = 0; i < scan->prev_nfiles; ++i)
+	{
+		const int pos = (scan->prev_pos + i)%scan->prev_nfiles;
+		tree_file_t *const prev = &scan->prev_files[pos];
+		tree_dir_t *const subdir = prev->dir;
+
+		if(strcmp(prev->name, file->name) != 0)
+		{
+			continue;
+		}
+
+		scan->prev_pos = pos + 1;
+
+		/* Listing of a directory changes its modification time and replacing the
+		 * directory changes its status change time. */
+		if(subdir == NULL || !prev->visible ||
+				prev->entry.mtime != file->entry.mtime ||
+				prev->entry.ctime != file->entry.ctime)
+		{
+			return NULL;
+		}
+
+		prev->dir = NULL;
+		return subdir;
+	}
+
+	return NULL;
+}
+
+/* Allocates directory of a tree that wasn't listed yet.  Returns the directory
+ * or NULL on error. */
+static tree_dir_t *
+alloc_tree_dir(const char path[])
+{
+	tree_dir_t *const dir = malloc(sizeof(*dir));
+	if(dir == NULL)
+	{
+		return NULL;
+	}
+
+	dir->path = strdup(path);
+	if(dir->path == NULL)
+	{
+		free(dir);
+		return NULL;
+	}
+
+	dir->files = NULL;
+	dir->nfiles = -1;
+	dir->fresh = 1;
+	return dir;
+}
+
+/* par_run() callback that displays progress of scanning a tree.  Returns
+ * non-zero if scanning should be cancelled. */
+static int
+report_scan_progress(void *arg)
+{
+	char msg[64];
+	int nfiles;
+	tree_scan_t *const scan = arg;
+
+	pthread_mutex_lock(&scan->lock);
+	nfiles = scan->nfiles;
+	pthread_mutex_unlock(&scan->lock);
+
+	snprintf(msg, sizeof(msg), "Building tree... %d", nfiles);
+	show_progress(msg, 1);
+
+	return ui_cancellation_requested();
+}
+
+/* Frees scanned tree of the view if there is one. */
+static void
+free_tree(FileView *view)
+{
+	free_tree_dir(view, view->custom.tree);
+	view->custom.tree = NULL;
+}
+
+/* Frees a tree and entries that weren't moved out of it.  dir can be NULL. */
+static void
+free_tree_dir(FileView *view, tree_dir_t *dir)
+{
+	if(dir == NULL)
+	{
+		return;
+	}
+
+	free_tree_files(view, dir->files, dir->nfiles);
+	free(dir->path);
+	free(dir);
+}
+
+/* Frees array of files of a tree along with their subdirectories.  nfiles can
+ * be negative. */
+static void
+free_tree_files(FileView *view, tree_file_t files[], int nfiles)
+{
+	int i;
+
+	for(i = 0; i < nfiles; ++i)
+	{
+		tree_file_t *const file = &files[i];
+		free_tree_dir(view, file->dir);
+		fentry_free(view, &file->entry);
+		free(file->name);
+		free(file->path);
+	}
+
+	free(files);
+}
+
+/* Adds custom view entries corresponding to scanned file system tree.
+ * parent_pos is expected to be negative for the outermost invocation.  Returns
+ * number of filtered out files on success or partial success and negative
+ * value on serious error. */
+static int
+add_files_recursively(FileView *view, tree_dir_t *dir, arena_t *arena,
+		int parent_pos, int no_direct_parent)
+{
+	int i;
+	const int prev_count = view->custom.entry_count;
+	int nfiltered = 0;
+	/* All entries of a directory share the same origin string. */
+	char *origin = NULL;
+
+	if(dir == NULL || dir->nfiles < 0)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < dir->nfiles; ++i)
+	{
+		tree_file_t *const file = &dir->files[i];
+		dir_entry_t *entry;
+
+		if(!file->visible)
+		{
+			if(file->dir != NULL)
+			{
+				nfiltered += add_files_recursively(view, file->dir, arena, parent_pos,
+						1);
 			}
 
-			free(full_path);
 			++nfiltered;
 			continue;
 		}
 
-		entry = flist_custom_add(view, full_path);
+		entry = add_tree_entry(view, file, arena, &origin);
 		if(entry == NULL)
 		{
-			free(full_path);
-			free_string_array(lst, len);
 			return -1;
 		}
 
@@ -3454,13 +4874,11 @@ add_files_recursively(FileView *view, const char path[], trie_t *excluded_paths,
 			entry->child_pos = (view->custom.entry_count - 1) - parent_pos;
 		}
 
-		/* Not using dir variable here, because it is set for symlinks to
-		 * directories as well. */
 		if(entry->type == FT_DIR)
 		{
 			const int idx = view->custom.entry_count - 1;
-			const int filtered = add_files_recursively(view, full_path,
-					excluded_paths, idx, 0);
+			const int filtered = add_files_recursively(view, file->dir, arena, idx,
+					0);
 			/* Keep going in case of error and load partial list. */
 			if(filtered >= 0)
 			{
@@ -3471,14 +4889,8 @@ add_files_recursively(FileView *view, const char path[], trie_t *excluded_paths,
 				nfiltered += filtered;
 			}
 		}
-
-		free(full_path);
-
-		show_progress("Building tree...", 1000);
 	}
 
-	free_string_array(lst, len);
-
 	/* The prev_count != 0 check is to make sure that we won't create leaf instead
 	 * of the whole tree (this is handled in flist_custom_finish()). */
 	if(!no_direct_parent && prev_count != 0 &&
@@ -3486,7 +4898,7 @@ add_files_recursively(FileView *view, const char path[], trie_t *excluded_paths,
 	{
 		/* To be able to perform operations inside directory (e.g., create files),
 		 * we need at least one element there. */
-		if(add_directory_leaf(view, path, parent_pos) != 0)
+		if(add_directory_leaf(view, dir->path, parent_pos) != 0)
 		{
 			return -1;
 		}
@@ -3495,6 +4907,56 @@ add_files_recursively(FileView *view, const char path[], trie_t *excluded_paths,
 	return nfiltered;
 }
 
+/* Moves entry of a scanned file to the list of custom entries.  *origin is
+ * either NULL or origin of previously added file of the same directory.
+ * Returns the entry or NULL on error. */
+static dir_entry_t *
+add_tree_entry(FileView *view, tree_file_t *file, arena_t *arena,
+		char **origin)
+{
+	dir_entry_t *entry;
+	size_t list_size = view->custom.entry_count;
+
+	/* Don't add duplicates. */
+	if(file->failed || trie_put(view->custom.paths_cache, file->path) != 0)
+	{
+		return NULL;
+	}
+
+	if(*origin == NULL)
+	{
+		char dir[PATH_MAX];
+		copy_str(dir, sizeof(dir), file->path);
+		remove_last_path_component(dir);
+		*origin = arena_strdup(arena, dir);
+	}
+	else
+	{
+		arena_ref(*origin);
+	}
+
+	file->entry.name = arena_strdup(arena, get_last_path_component(file->path));
+	file->entry.arena_name = 1;
+	file->entry.origin = *origin;
+	file->entry.arena_origin = 1;
+	if(file->entry.name == NULL || file->entry.origin == NULL)
+	{
+		return NULL;
+	}
+
+	entry = add_dir_entry(&view->custom.entries, &list_size, &file->entry);
+	view->custom.entry_count = list_size;
+	if(entry != NULL)
+	{
+		/* The entry is owned by the list now. */
+		file->entry.name = NULL;
+		file->entry.arena_name = 0;
+		file->entry.origin = NULL;
+		file->entry.arena_origin = 0;
+	}
+	return entry;
+}
+
 /* Checks whether file is visible according to dot and filename filters.  is_dir
  * is used when data is NULL, otherwise data_is_dir_entry() called (this is an
  * optimization).  Returns non-zero if so, otherwise zero is returned. */
@@ -3566,7 +5028,7 @@ init_parent_entry(FileView *view, dir_entry_t *entry, const char path[])
 {
 	struct stat s;
 
-	init_dir_entry(view, entry, get_last_path_component(path));
+	init_dir_entry(view, entry, get_last_path_component(path), NULL);
 	entry->type = FT_DIR;
 
 	/* Load the inode info or leave blank values in entry. */
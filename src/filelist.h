@@ -267,6 +267,13 @@ void fentry_free(const FileView *view, dir_entry_t *entry);
 void add_parent_dir(FileView *view);
 /* Changes name of a file entry, performing additional required updates. */
 void fentry_rename(FileView *view, dir_entry_t *entry, const char to[]);
+/* Replaces name of a file entry without any additional updates.  Returns zero
+ * on success, otherwise non-zero is returned. */
+int fentry_set_name(dir_entry_t *entry, const char name[]);
+/* Replaces origin of a file entry of the view.  Returns zero on success,
+ * otherwise non-zero is returned. */
+int fentry_set_origin(const FileView *view, dir_entry_t *entry,
+		const char origin[]);
 /* Checks whether this is fake entry for internal purposes, which should not be
  * processed as a file. */
 int fentry_is_fake(const dir_entry_t *entry);
@@ -277,6 +284,11 @@ int fentry_is_valid(const dir_entry_t *entry);
 /* Checks whether entry corresponds to a directory (including symbolic links to
  * directories).  Returns non-zero if so, otherwise zero is returned. */
 int fentry_is_dir(const dir_entry_t *entry);
+/* Loads meta-data (size, times, mode, etc.) of the entry if it was deferred
+ * during directory reading.  Data is left intact on failure. */
+void fentry_load_meta(dir_entry_t *entry);
+/* Loads meta-data of all entries of the view that don't have it yet. */
+void flist_load_meta(FileView *view);
 /* Loads directory tree specified by its path into the view.  Considers various
  * filters.  Returns zero on success, otherwise non-zero is returned. */
 int flist_load_tree(FileView *view, const char path[]);
@@ -36,6 +36,7 @@
 #include "utils/utils.h"
 #include "filelist.h"
 #include "filtering.h"
+#include "sort.h"
 #include "types.h"
 
 static void correct_list_pos_down(FileView *view, size_t pos_delta);
@@ -248,6 +249,7 @@ flist_find_group(const FileView *view, int next)
 
 	int pos = view->list_pos;
 	dir_entry_t *pentry = &view->dir_entry[pos];
+	const int need_meta = sort_needs_meta(view);
 	const char *ext = get_last_ext(pentry->name);
 	size_t char_width = utf8_chrw(pentry->name);
 	wchar_t ch = towupper(get_first_wchar(pentry->name));
@@ -256,10 +258,19 @@ flist_find_group(const FileView *view, int next)
 		? SK_BY_ID
 		: abs(view->sort[0]);
 	const int is_dir = fentry_is_dir(pentry);
-	const char *const type_str = get_type_str(pentry->type);
+	const char *type_str;
 	regmatch_t pmatch = { .rm_so = 0, .rm_eo = 0 };
 #ifndef _WIN32
 	char perms[16];
+#endif
+
+	/* Type and mode of the file might not be known yet. */
+	if(need_meta)
+	{
+		fentry_load_meta(pentry);
+	}
+	type_str = get_type_str(pentry->type);
+#ifndef _WIN32
 	get_perm_string(perms, sizeof(perms), pentry->mode);
 #endif
 	if(sorting_key == SK_BY_GROUPS)
@@ -271,6 +282,10 @@ flist_find_group(const FileView *view, int next)
 		dir_entry_t *nentry;
 		pos += inc;
 		nentry = &view->dir_entry[pos];
+		if(need_meta)
+		{
+			fentry_load_meta(nentry);
+		}
 		switch(sorting_key)
 		{
 			case SK_BY_FILEEXT:
@@ -356,8 +356,8 @@ fops_delete_bg(FileView *view, int use_trash)
 	args->ops = fops_get_bg_ops(use_trash ? OP_REMOVE : OP_REMOVESL,
 			use_trash ? "deleting" : "Deleting", args->path);
 
-	if(bg_execute(task_desc, "...", args->sel_list_len, 1, &delete_files_in_bg,
-				args) != 0)
+	if(bg_execute(task_desc, "...", args->sel_list_len, 1, args->path,
+				&delete_files_in_bg, args) != 0)
 	{
 		fops_free_bg_args(args);
 
@@ -1104,7 +1104,7 @@ start_dir_size_calc(const char path[], int force)
 
 	snprintf(task_desc, sizeof(task_desc), "Calculating size: %s", path);
 
-	if(bg_execute(task_desc, path, BG_UNDEFINED_TOTAL, 0, &dir_size_bg,
+	if(bg_execute(task_desc, path, BG_UNDEFINED_TOTAL, 0, NULL, &dir_size_bg,
 				args) != 0)
 	{
 		free(args->path);
@@ -1195,6 +1195,9 @@ fops_chown(int u, int g, uid_t uid, gid_t gid)
 		char full_path[PATH_MAX];
 		get_full_path_of(entry, sizeof(full_path), full_path);
 
+		/* Previous owner and group are needed for undo. */
+		fentry_load_meta(entry);
+
 		if(u && perform_operation(OP_CHOWN, ops, V(uid), full_path, NULL) == 0)
 		{
 			add_operation(OP_CHOWN, V(uid), V(entry->uid), full_path, "");
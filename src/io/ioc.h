@@ -124,6 +124,10 @@ struct io_args_t
 	/* Set to NULL to do not use estimates. */
 	struct ioeta_estim_t *estim;
 
+	/* Maximum number of threads copying files to the same device at the same
+	 * time.  Non-positive value means automatic choice. */
+	int max_threads;
+
 	/* Output of the operation after it finishes. */
 	io_result_t result;
 };
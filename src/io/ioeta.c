@@ -22,13 +22,44 @@
 #include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* uint64_t */
 #include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strdup() */
 
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
+#include "../utils/fs.h"
 #include "private/ioc.h"
 #include "private/ioeta.h"
 #include "private/traverser.h"
 
+/* State of estimation running on a separate thread. */
+typedef struct ioeta_scan_t
+{
+	pthread_t thread; /* Thread that traverses paths. */
+	int started;      /* Whether the thread needs to be joined. */
+
+	/* Totals of the estimation before traversing started. */
+	size_t base_items;
+	uint64_t base_bytes;
+
+	/* Copy of cancellation settings of the estimation. */
+	io_cancellation_t cancellation;
+
+	pthread_mutex_t lock; /* Protects fields below. */
+	char **paths;         /* Paths to traverse. */
+	size_t npaths;        /* Number of elements in paths. */
+	size_t next;          /* Index of next path to traverse. */
+	int running;          /* Whether the thread is processing paths. */
+	int stop;             /* Whether the thread should stop. */
+	size_t items;         /* Number of found items. */
+	uint64_t bytes;       /* Size of found items. */
+}
+ioeta_scan_t;
+
 static VisitResult eta_visitor(const char full_path[], VisitAction action,
 		void *param);
+static void * scan_thread(void *arg);
+static VisitResult scan_visitor(const char full_path[], VisitAction action,
+		void *param);
 
 ioeta_estim_t *
 ioeta_alloc(void *param, io_cancellation_t cancellation)
@@ -44,6 +75,29 @@ ioeta_free(ioeta_estim_t *estim)
 {
 	if(estim != NULL)
 	{
+		ioeta_scan_t *const scan = estim->scan;
+		if(scan != NULL)
+		{
+			size_t i;
+
+			pthread_mutex_lock(&scan->lock);
+			scan->stop = 1;
+			pthread_mutex_unlock(&scan->lock);
+
+			if(scan->started)
+			{
+				(void)pthread_join(scan->thread, NULL);
+			}
+
+			for(i = 0U; i < scan->npaths; ++i)
+			{
+				free(scan->paths[i]);
+			}
+			free(scan->paths);
+			pthread_mutex_destroy(&scan->lock);
+			free(scan);
+		}
+
 		free(estim->item);
 		free(estim->target);
 		free(estim);
@@ -63,6 +117,193 @@ ioeta_calculate(ioeta_estim_t *estim, const char path[], int shallow)
 	}
 }
 
+void
+ioeta_calculate_bg(ioeta_estim_t *estim, const char path[])
+{
+	int start;
+	char *path_copy;
+	char **paths;
+	ioeta_scan_t *scan = estim->scan;
+
+	if(scan == NULL)
+	{
+		scan = calloc(1U, sizeof(*scan));
+		if(scan == NULL)
+		{
+			ioeta_calculate(estim, path, 0);
+			return;
+		}
+
+		pthread_mutex_init(&scan->lock, NULL);
+		scan->base_items = estim->total_items;
+		scan->base_bytes = estim->total_bytes;
+		scan->cancellation = estim->cancellation;
+		estim->scan = scan;
+	}
+
+	path_copy = strdup(path);
+	if(path_copy == NULL)
+	{
+		ioeta_calculate(estim, path, 0);
+		return;
+	}
+
+	pthread_mutex_lock(&scan->lock);
+	paths = reallocarray(scan->paths, scan->npaths + 1U, sizeof(*paths));
+	if(paths != NULL)
+	{
+		scan->paths = paths;
+		scan->paths[scan->npaths++] = path_copy;
+	}
+	start = (paths != NULL && !scan->running);
+	if(start)
+	{
+		scan->running = 1;
+	}
+	pthread_mutex_unlock(&scan->lock);
+
+	if(paths == NULL)
+	{
+		free(path_copy);
+		ioeta_calculate(estim, path, 0);
+		return;
+	}
+
+	if(start)
+	{
+		/* Previous thread has processed all paths and is about to exit. */
+		if(scan->started)
+		{
+			(void)pthread_join(scan->thread, NULL);
+		}
+
+		scan->started =
+			(pthread_create(&scan->thread, NULL, &scan_thread, scan) == 0);
+		if(!scan->started)
+		{
+			(void)scan_thread(scan);
+		}
+	}
+}
+
+/* Waits for estimation started by ioeta_calculate_bg() to finish and updates
+ * totals.  Does nothing if there is no such estimation.  Operations don't need
+ * this as ioeta_free() stops the estimation which became useless. */
+TSTATIC void
+ioeta_wait(ioeta_estim_t *estim)
+{
+	if(estim->scan != NULL && estim->scan->started)
+	{
+		(void)pthread_join(estim->scan->thread, NULL);
+		estim->scan->started = 0;
+	}
+
+	ioeta_pull_bg(estim);
+}
+
+void
+ioeta_pull_bg(ioeta_estim_t *estim)
+{
+	size_t items;
+	uint64_t bytes;
+	ioeta_scan_t *const scan = estim->scan;
+
+	if(scan == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&scan->lock);
+	items = scan->base_items + scan->items;
+	bytes = scan->base_bytes + scan->bytes;
+	pthread_mutex_unlock(&scan->lock);
+
+	/* Totals could have been corrected by the operation, which got ahead of
+	 * the estimation. */
+	if(items > estim->total_items)
+	{
+		estim->total_items = items;
+	}
+	if(bytes > estim->total_bytes)
+	{
+		estim->total_bytes = bytes;
+	}
+}
+
+/* Entry point of a thread that traverses queued paths.  Returns NULL. */
+static void *
+scan_thread(void *arg)
+{
+	ioeta_scan_t *const scan = arg;
+
+	while(1)
+	{
+		const char *path = NULL;
+
+		pthread_mutex_lock(&scan->lock);
+		if(!scan->stop && scan->next < scan->npaths)
+		{
+			path = scan->paths[scan->next++];
+		}
+		else
+		{
+			scan->running = 0;
+		}
+		pthread_mutex_unlock(&scan->lock);
+
+		if(path == NULL)
+		{
+			break;
+		}
+
+		(void)traverse(path, &scan_visitor, scan);
+	}
+
+	return NULL;
+}
+
+/* Implementation of traverse() visitor for estimation on a separate thread.
+ * Unlike eta_visitor() doesn't notify about progress.  Returns 0 on success,
+ * otherwise non-zero is returned. */
+static VisitResult
+scan_visitor(const char full_path[], VisitAction action, void *param)
+{
+	ioeta_scan_t *const scan = param;
+	uint64_t size = 0U;
+	int stop;
+
+	pthread_mutex_lock(&scan->lock);
+	stop = scan->stop;
+	pthread_mutex_unlock(&scan->lock);
+
+	if(stop || cancelled(&scan->cancellation))
+	{
+		return VR_CANCELLED;
+	}
+
+	switch(action)
+	{
+		case VA_DIR_ENTER:
+			return VR_SKIP_DIR_LEAVE;
+		case VA_FILE:
+			if(!is_symlink(full_path))
+			{
+				size = get_file_data_size(full_path);
+			}
+
+			pthread_mutex_lock(&scan->lock);
+			++scan->items;
+			scan->bytes += size;
+			pthread_mutex_unlock(&scan->lock);
+			return VR_OK;
+		case VA_DIR_LEAVE:
+			assert(0 && "Can't get here because of VR_SKIP_DIR_LEAVE.");
+			return VR_OK;
+	}
+
+	return VR_OK;
+}
+
 /* Implementation of traverse() visitor for subtree copying.  Returns 0 on
  * success, otherwise non-zero is returned. */
 static VisitResult
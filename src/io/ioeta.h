@@ -22,6 +22,7 @@
 #include <stddef.h> /* size_t */
 #include <stdint.h> /* uint64_t */
 
+#include "../utils/test_helpers.h"
 #include "ioc.h"
 
 /* ioeta - Input/Output estimation */
@@ -68,6 +69,9 @@ typedef struct ioeta_estim_t
 
 	/* Provides means for cancellation checking. */
 	io_cancellation_t cancellation;
+
+	/* State of estimation that runs in parallel with the operation or NULL. */
+	struct ioeta_scan_t *scan;
 }
 ioeta_estim_t;
 
@@ -82,6 +86,16 @@ void ioeta_free(ioeta_estim_t *estim);
  * directories. */
 void ioeta_calculate(ioeta_estim_t *estim, const char path[], int shallow);
 
+/* Same as deep ioeta_calculate(), but traverses the subtree on a separate
+ * thread, so that the operation can start right away.  Totals grow as the
+ * subtree is traversed and are updated on progress reports.  Subsequent calls
+ * queue paths for the same thread. */
+void ioeta_calculate_bg(ioeta_estim_t *estim, const char path[]);
+
+TSTATIC_DEFS(
+	void ioeta_wait(ioeta_estim_t *estim);
+)
+
 #endif /* VIFM__IO__IOETA_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -27,16 +27,23 @@
 #ifndef _WIN32
 #include <sys/ioctl.h> /* ioctl() */
 #endif
+#ifdef __linux__
+#include <sys/sendfile.h> /* sendfile() */
+#include <sys/syscall.h> /* __NR_copy_file_range */
+#endif
 #include <sys/stat.h> /* stat */
-#include <sys/types.h> /* mode_t */
-#include <unistd.h> /* rmdir() symlink() unlink() */
+#include <sys/types.h> /* mode_t off_t ssize_t */
+#include <unistd.h> /* SEEK_DATA SEEK_HOLE ftruncate() lseek() read() rmdir()
+                       symlink() syscall() unlink() write() */
 
 #include <assert.h> /* assert() */
-#include <errno.h> /* EEXIST ENOENT EISDIR errno */
+#include <errno.h> /* EBADF EEXIST EINTR EINVAL EISDIR ENOENT ENOMEM ENOSYS
+                      ENXIO EOPNOTSUPP EXDEV errno */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE fpos_t fclose() fgetpos() fread() fseek() fsetpos()
-                      fwrite() snprintf() */
-#include <stdlib.h> /* free() */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fpos_t fclose() fgetpos() fileno() fseek() fsetpos()
+                      snprintf() */
+#include <stdlib.h> /* free() malloc() */
 #include <string.h> /* strchr() */
 
 #include "../compat/fs_limits.h"
@@ -46,6 +53,7 @@
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/test_helpers.h"
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
 #include "private/ioc.h"
@@ -53,10 +61,32 @@
 #include "private/ioeta.h"
 #include "ioc.h"
 
-/* Amount of data to transfer at once. */
-#define BLOCK_SIZE 32*1024
+/* Amount of data to transfer at once when data passes through user space. */
+#define BLOCK_SIZE (256*1024)
+
+/* Amount of data to transfer at once when data is copied by the kernel. */
+#define KERNEL_BLOCK_SIZE (8*1024*1024)
+
+#ifdef __linux__
+/* Maximum amount of data copied by a single copy_in_kernel() call, the rest
+ * is left for other ways of copying.  Can be changed by tests. */
+static uint64_t kernel_copy_limit = (uint64_t)-1;
+#endif
 
 static int clone_file(int dst_fd, int src_fd);
+static int copy_contents(io_args_t *const args, int dst_fd, int src_fd,
+		int append);
+#ifdef SEEK_HOLE
+static int copy_sparse(io_args_t *const args, int dst_fd, int src_fd);
+#endif
+static int copy_range(io_args_t *const args, int dst_fd, int src_fd,
+		uint64_t len);
+#ifdef __linux__
+static int copy_in_kernel(io_args_t *const args, int dst_fd, int src_fd,
+		uint64_t *len, int use_sendfile);
+static int is_unsupported_error(int error_code);
+#endif
+static int write_all(int fd, const char buf[], size_t len);
 #ifdef _WIN32
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 		LARGE_INTEGER transferred, LARGE_INTEGER stream_size,
@@ -284,10 +314,7 @@ iop_cp(io_args_t *const args)
 	const io_confirm confirm = args->confirm;
 	struct stat st;
 
-	char block[BLOCK_SIZE];
 	FILE *in, *out;
-	/* Suppress possible false-positive compiler warning. */
-	size_t nread = (size_t)-1;
 	int error;
 	int cloned;
 	struct stat src_st;
@@ -528,30 +555,12 @@ iop_cp(io_args_t *const args)
 		}
 	}
 
-	/* TODO: use sendfile() if platform supports it. */
-
-	while(!cloned && (nread = fread(&block, 1, sizeof(block), in)) != 0U)
+	if(!cloned && !error)
 	{
-		if(io_cancelled(args))
-		{
-			error = 1;
-			break;
-		}
-
-		if(fwrite(&block, 1, nread, out) != nread)
-		{
-			(void)ioe_errlst_append(&args->result.errors, dst, errno,
-					"Write to destination file failed");
-			error = 1;
-			break;
-		}
-
-		ioeta_update(args->estim, NULL, NULL, 0, nread);
-	}
-	if(!cloned && nread == 0U && !feof(in) && ferror(in))
-	{
-		(void)ioe_errlst_append(&args->result.errors, src, errno,
-				"Read from destination file failed");
+		/* Nothing was read or written via the streams, so their descriptors can be
+		 * used directly. */
+		error = copy_contents(args, fileno(out), fileno(in),
+				crs == IO_CRS_APPEND_TO_FILES);
 	}
 
 	if(fclose(in) != 0)
@@ -603,6 +612,294 @@ clone_file(int dst_fd, int src_fd)
 #endif
 }
 
+/* Copies the rest of the source file to the destination file starting at
+ * current offsets of descriptors.  Holes of sparse files are preserved unless
+ * appending.  Returns zero on success, otherwise non-zero is returned. */
+static int
+copy_contents(io_args_t *const args, int dst_fd, int src_fd, int append)
+{
+#ifdef SEEK_HOLE
+	if(!append)
+	{
+		const int error = copy_sparse(args, dst_fd, src_fd);
+		if(error >= 0)
+		{
+			return error;
+		}
+	}
+#endif
+
+	return copy_range(args, dst_fd, src_fd, (uint64_t)-1);
+}
+
+#ifdef SEEK_HOLE
+
+/* Copies only data regions of a sparse file and recreates holes by seeking
+ * past them and truncating destination at the end.  Expects both descriptors
+ * to be at the beginning of files.  Returns zero on success, positive number
+ * on error and negative number if the file isn't sparse or file system doesn't
+ * report holes, in which case nothing is changed. */
+static int
+copy_sparse(io_args_t *const args, int dst_fd, int src_fd)
+{
+	struct stat st;
+	off_t pos;
+
+	/* Files without holes have at least as many blocks as their size needs. */
+	if(fstat(src_fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+			(uint64_t)st.st_blocks*512U >= (uint64_t)st.st_size)
+	{
+		return -1;
+	}
+
+	/* Blocks might be missing for other reasons (e.g., compression), so check
+	 * for holes explicitly. */
+	pos = lseek(src_fd, 0, SEEK_HOLE);
+	if(pos < 0 || pos >= st.st_size || lseek(src_fd, 0, SEEK_SET) != 0)
+	{
+		(void)lseek(src_fd, 0, SEEK_SET);
+		return -1;
+	}
+
+	pos = 0;
+	while(pos < st.st_size)
+	{
+		off_t data, hole;
+
+		data = lseek(src_fd, pos, SEEK_DATA);
+		if(data < 0 && errno == ENXIO)
+		{
+			/* The rest of the file is a hole. */
+			break;
+		}
+
+		hole = (data < 0) ? -1 : lseek(src_fd, data, SEEK_HOLE);
+		if(hole < 0 || lseek(src_fd, data, SEEK_SET) < 0 ||
+				lseek(dst_fd, data, SEEK_SET) < 0)
+		{
+			(void)ioe_errlst_append(&args->result.errors, args->arg1.src, errno,
+					"Failed to seek in sparse file");
+			return 1;
+		}
+
+		if(copy_range(args, dst_fd, src_fd, hole - data) != 0)
+		{
+			return 1;
+		}
+		pos = hole;
+	}
+
+	/* Trailing hole isn't created by seeking. */
+	if(ftruncate(dst_fd, st.st_size) != 0)
+	{
+		(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+				"Failed to set size of destination file");
+		return 1;
+	}
+
+	return 0;
+}
+
+#endif
+
+/* Copies up to len bytes from the source file to the destination file starting
+ * at current offsets of descriptors.  Uses the fastest available way of copying
+ * data.  Returns zero on success, otherwise non-zero is returned. */
+static int
+copy_range(io_args_t *const args, int dst_fd, int src_fd, uint64_t len)
+{
+	char *block;
+	int error;
+
+#ifdef __linux__
+	/* Kernel might copy part of the data before giving up, so len is updated to
+	 * what remains. */
+	error = copy_in_kernel(args, dst_fd, src_fd, &len, 0);
+	if(error < 0)
+	{
+		error = copy_in_kernel(args, dst_fd, src_fd, &len, 1);
+	}
+	if(error >= 0)
+	{
+		return error;
+	}
+#endif
+
+	block = malloc(BLOCK_SIZE);
+	if(block == NULL)
+	{
+		(void)ioe_errlst_append(&args->result.errors, args->arg1.src, ENOMEM,
+				"Failed to allocate memory");
+		return 1;
+	}
+
+	error = 0;
+	while(len != 0U)
+	{
+		const ssize_t nread = read(src_fd, block, MIN(BLOCK_SIZE, len));
+		if(nread == 0)
+		{
+			break;
+		}
+		if(nread < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			(void)ioe_errlst_append(&args->result.errors, args->arg1.src, errno,
+					"Read from source file failed");
+			error = 1;
+			break;
+		}
+
+		if(io_cancelled(args))
+		{
+			error = 1;
+			break;
+		}
+
+		if(write_all(dst_fd, block, nread) != 0)
+		{
+			(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+					"Write to destination file failed");
+			error = 1;
+			break;
+		}
+
+		ioeta_update(args->estim, NULL, NULL, 0, nread);
+		len -= nread;
+	}
+
+	free(block);
+	return error;
+}
+
+#ifdef __linux__
+
+/* Copies up to *len bytes without passing them through user space by either
+ * copy_file_range() (in-kernel copy, server-side copy or reflink depending on
+ * file system) or sendfile().  *len is decreased by amount of copied data.
+ * Returns zero on success, positive number on error and negative number if
+ * this kind of copying isn't supported for these files, in which case some
+ * data might have been copied already and the rest should be copied by other
+ * means. */
+static int
+copy_in_kernel(io_args_t *const args, int dst_fd, int src_fd, uint64_t *len,
+		int use_sendfile)
+{
+	int copied_anything = 0;
+	uint64_t limit = kernel_copy_limit;
+
+	while(*len != 0U)
+	{
+		ssize_t ncopied;
+		const size_t portion = MIN(MIN(KERNEL_BLOCK_SIZE, *len), limit);
+
+		if(portion == 0U)
+		{
+			return -1;
+		}
+
+		if(io_cancelled(args))
+		{
+			return 1;
+		}
+
+		if(use_sendfile)
+		{
+			ncopied = sendfile(dst_fd, src_fd, NULL, portion);
+		}
+		else
+		{
+#ifdef __NR_copy_file_range
+			ncopied = syscall(__NR_copy_file_range, src_fd, NULL, dst_fd, NULL,
+					portion, 0U);
+#else
+			ncopied = -1;
+			errno = ENOSYS;
+#endif
+		}
+
+		if(ncopied == 0)
+		{
+			/* Some pseudo-files report zero size and appear empty to the kernel, so
+			 * let reading them decide where the end is. */
+			return copied_anything ? 0 : -1;
+		}
+
+		if(ncopied < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			if(is_unsupported_error(errno))
+			{
+				return -1;
+			}
+			(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+					"Failed to copy file contents");
+			return 1;
+		}
+
+		copied_anything = 1;
+		ioeta_update(args->estim, NULL, NULL, 0, ncopied);
+		*len -= ncopied;
+		limit -= ncopied;
+	}
+	return 0;
+}
+
+/* Checks whether error code of copy_file_range() or sendfile() means that the
+ * call isn't supported for a pair of files.  Returns non-zero if so, otherwise
+ * zero is returned. */
+static int
+is_unsupported_error(int error_code)
+{
+	/* EBADF is reported for destination opened for appending. */
+	return error_code == ENOSYS
+	    || error_code == EXDEV
+	    || error_code == EINVAL
+	    || error_code == EOPNOTSUPP
+	    || error_code == EBADF;
+}
+
+#endif
+
+TSTATIC void
+iop_set_kernel_copy_limit(uint64_t limit)
+{
+#ifdef __linux__
+	kernel_copy_limit = limit;
+#else
+	(void)limit;
+#endif
+}
+
+/* Writes whole buffer to a file descriptor.  Returns zero on success, otherwise
+ * non-zero is returned and errno is set. */
+static int
+write_all(int fd, const char buf[], size_t len)
+{
+	while(len != 0U)
+	{
+		const ssize_t nwritten = write(fd, buf, len);
+		if(nwritten < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return 1;
+		}
+
+		buf += nwritten;
+		len -= nwritten;
+	}
+	return 0;
+}
+
 #ifdef _WIN32
 
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
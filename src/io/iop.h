@@ -19,6 +19,9 @@
 #ifndef VIFM__IO__IOP_H__
 #define VIFM__IO__IOP_H__
 
+#include <stdint.h> /* uint64_t */
+
+#include "../utils/test_helpers.h"
 #include "ioc.h"
 
 /* iop - I/O primitive - Input/Output primitive */
@@ -58,6 +61,10 @@ int iop_chmod(io_args_t *const args);
  * link. */
 int iop_ln(io_args_t *const args);
 
+TSTATIC_DEFS(
+	void iop_set_kernel_copy_limit(uint64_t limit);
+)
+
 #endif /* VIFM__IO__IOP_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
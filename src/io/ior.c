@@ -18,19 +18,26 @@
 
 #include "ior.h"
 
-#include <sys/stat.h> /* stat */
-#include <unistd.h> /* unlink() */
+#include <sys/stat.h> /* S_ISDIR S_ISREG fstatat() stat */
+#include <sys/types.h> /* dev_t */
+#include <dirent.h> /* DIR closedir() fdopendir() readdir() */
+#include <fcntl.h> /* AT_FDCWD AT_REMOVEDIR O_* openat() */
+#include <unistd.h> /* close() dup() unlinkat() */
 
 #include <errno.h> /* EEXIST EISDIR ENOTEMPTY EXDEV errno */
-#include <stddef.h> /* NULL */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
 #include <stdio.h> /* remove() snprintf() */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strlen() */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* memset() strdup() strlen() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
 #include "../utils/fs.h"
 #include "../utils/log.h"
+#include "../utils/parallel.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/utils.h"
@@ -42,8 +49,96 @@
 #include "ioc.h"
 #include "iop.h"
 
+/* Number of entries after which removal progress is published. */
+#define RM_BATCH_SIZE 256
+
+/* Single file to be copied by a worker thread. */
+typedef struct
+{
+	char *src;      /* Source path. */
+	char *dst;      /* Destination path. */
+	uint64_t bytes; /* Amount of data copied, set after copying. */
+}
+cp_job_t;
+
+/* State of copying a subtree on several threads. */
+typedef struct
+{
+	io_args_t *args; /* Arguments of the whole operation. */
+
+	cp_job_t *jobs; /* Files to be copied. */
+	size_t njobs;   /* Number of elements in the jobs array. */
+
+	char **dirs;  /* Directories to finish after copying files (post-order). */
+	size_t ndirs; /* Number of elements in the dirs array. */
+
+	size_t nreported; /* Number of elements of done array reported as progress. */
+
+	pthread_mutex_t lock; /* Protects fields below. */
+	cp_job_t **done;      /* Processed jobs in order of completion. */
+	size_t ndone;         /* Number of processed jobs. */
+	int failed;           /* Whether copying of some file has failed. */
+}
+cp_tree_t;
+
+/* Directory being removed by rm_tree(). */
+typedef struct rm_dir_t
+{
+	char *path;              /* Full path to the directory for reporting. */
+	const char *name;        /* Name within parent or full path for the root. */
+	int fd;                  /* Descriptor of the directory or -1. */
+	struct rm_dir_t *parent; /* Parent directory or NULL for the root. */
+	int pending;             /* Own listing plus unfinished subdirectories. */
+}
+rm_dir_t;
+
+/* State of removing a subtree on several threads. */
+typedef struct
+{
+	io_args_t *args; /* Arguments of the whole operation. */
+
+	pthread_mutex_t lock; /* Protects fields below and pending of rm_dir_t. */
+	int failed;           /* Whether removal of something has failed. */
+	int stopped;          /* Whether removal was cancelled. */
+	size_t nitems;        /* Number of removed items not reported yet. */
+	uint64_t nbytes;      /* Size of removed items not reported yet. */
+	char *last_dir;       /* Last directory taken for processing. */
+}
+rm_tree_t;
+
+/* Number of copying threads working with a particular device. */
+typedef struct
+{
+	dev_t dev;    /* Device identifier. */
+	int nthreads; /* Number of threads. */
+}
+dev_load_t;
+
+#if IO_HAVE_AT_FUNCS
+static int rm_tree(io_args_t *args);
+static rm_dir_t * make_rm_dir(char *path, rm_dir_t *parent);
+static void rm_dir_task(par_queue_t *queue, void *task, void *arg);
+static void rm_dir_entries(par_queue_t *queue, rm_tree_t *rm_tree,
+		rm_dir_t *dir);
+static void finish_rm_dir(rm_tree_t *rm_tree, rm_dir_t *dir);
+static void count_removed(rm_tree_t *rm_tree, size_t *nitems,
+		uint64_t *nbytes);
+static void rm_failed(rm_tree_t *rm_tree, const char path[], int error_code,
+		const char msg[]);
+static int rm_stopped(rm_tree_t *rm_tree);
+static int report_rm_progress(void *arg);
+static void flush_rm_progress(rm_tree_t *rm_tree);
+#endif
 static VisitResult rm_visitor(const char full_path[], VisitAction action,
 		void *param);
+static int cp_tree(io_args_t *args);
+static int cp_tree_on_threads(cp_tree_t *cp_tree, int nthreads);
+static VisitResult cp_plan_visitor(const char full_path[], VisitAction action,
+		void *param);
+static void cp_file_task(par_queue_t *queue, void *task, void *arg);
+static int report_cp_progress(void *arg);
+static int reserve_threads(const char path[], int wanted, dev_t *dev);
+static void release_threads(dev_t dev, int nthreads);
 static VisitResult cp_visitor(const char full_path[], VisitAction action,
 		void *param);
 static int is_file(const char path[]);
@@ -52,13 +147,329 @@ static VisitResult mv_visitor(const char full_path[], VisitAction action,
 static VisitResult cp_mv_visitor(const char full_path[], VisitAction action,
 		void *param, int cp);
 
+/* Protects dev_loads and ndev_loads. */
+static pthread_mutex_t dev_loads_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Devices that are being written to by ior_cp() on several threads. */
+static dev_load_t *dev_loads;
+/* Number of elements in the dev_loads array. */
+static int ndev_loads;
+
 int
 ior_rm(io_args_t *const args)
 {
 	const char *const path = args->arg1.path;
+
+#if IO_HAVE_AT_FUNCS
+	/* Error callback can interact with the user and must be called
+	 * sequentially. */
+	if(args->result.errors_cb == NULL && !is_symlink(path) && is_dir(path))
+	{
+		return rm_tree(args);
+	}
+#endif
+
 	return traverse(path, &rm_visitor, args);
 }
 
+#if IO_HAVE_AT_FUNCS
+
+/* Removes directory with all its contents.  Files are unlinked relative to
+ * their directories, directories are processed on several threads and progress
+ * is reported in batches.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+rm_tree(io_args_t *args)
+{
+	dev_t dev;
+	int nthreads;
+	rm_dir_t *root;
+	char *const path = strdup(args->arg1.path);
+	rm_tree_t rm_tree = { .args = args };
+
+	root = (path == NULL) ? NULL : make_rm_dir(path, NULL);
+	if(root == NULL)
+	{
+		(void)ioe_errlst_append(&args->result.errors, args->arg1.path,
+				IO_ERR_UNKNOWN, "Not enough memory");
+		return 1;
+	}
+
+	pthread_mutex_init(&rm_tree.lock, NULL);
+
+	/* Processing isn't interrupted by par_run() on cancellation, because
+	 * directories must be freed and they are freed on finishing processing. */
+	nthreads = reserve_threads(args->arg1.path, args->max_threads, &dev);
+	(void)par_run(root, nthreads, &rm_dir_task, &report_rm_progress, &rm_tree);
+	release_threads(dev, nthreads);
+
+	pthread_mutex_destroy(&rm_tree.lock);
+
+	flush_rm_progress(&rm_tree);
+	free(rm_tree.last_dir);
+
+	return (rm_tree.failed || rm_tree.stopped);
+}
+
+/* Allocates description of a directory to be removed taking ownership of the
+ * path.  Returns the description or NULL on error. */
+static rm_dir_t *
+make_rm_dir(char *path, rm_dir_t *parent)
+{
+	rm_dir_t *const dir = malloc(sizeof(*dir));
+	if(dir == NULL)
+	{
+		free(path);
+		return NULL;
+	}
+
+	dir->path = path;
+	dir->name = (parent == NULL) ? path : path + strlen(parent->path) + 1U;
+	dir->fd = -1;
+	dir->parent = parent;
+	dir->pending = 1;
+	return dir;
+}
+
+/* par_run() callback that removes contents of a directory and the directory
+ * itself if it has no subdirectories being processed. */
+static void
+rm_dir_task(par_queue_t *queue, void *task, void *arg)
+{
+	rm_tree_t *const rm_tree = arg;
+	rm_dir_t *const dir = task;
+
+	if(!rm_stopped(rm_tree))
+	{
+		rm_dir_entries(queue, rm_tree, dir);
+	}
+	finish_rm_dir(rm_tree, dir);
+}
+
+/* Unlinks files of the directory and queues its subdirectories.  The directory
+ * is opened relative to its parent and stays open until it's removed, so that
+ * its subdirectories can be opened and removed relative to it. */
+static void
+rm_dir_entries(par_queue_t *queue, rm_tree_t *rm_tree, rm_dir_t *dir)
+{
+	DIR *d;
+	int fd;
+	struct dirent *entry;
+	size_t nitems = 0U;
+	uint64_t nbytes = 0U;
+	const int need_size = (rm_tree->args->estim != NULL);
+	const int parent_fd = (dir->parent == NULL) ? AT_FDCWD : dir->parent->fd;
+
+	dir->fd = openat(parent_fd, dir->name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+	/* Listing closes its descriptor, so give it a separate one. */
+	fd = (dir->fd == -1) ? -1 : dup(dir->fd);
+	d = (fd == -1) ? NULL : fdopendir(fd);
+	if(d == NULL)
+	{
+		const int error_code = errno;
+		if(fd != -1)
+		{
+			(void)close(fd);
+		}
+		rm_failed(rm_tree, dir->path, error_code, "Failed to open directory");
+		return;
+	}
+
+	pthread_mutex_lock(&rm_tree->lock);
+	replace_string(&rm_tree->last_dir, dir->path);
+	pthread_mutex_unlock(&rm_tree->lock);
+
+	while((entry = readdir(d)) != NULL)
+	{
+		struct stat st;
+		int is_dir;
+		uint64_t size = 0U;
+
+		if(is_builtin_dir(entry->d_name))
+		{
+			continue;
+		}
+
+		if(entry->d_type == DT_UNKNOWN || (need_size && entry->d_type == DT_REG))
+		{
+			if(fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+			{
+				char *const path = format_str("%s/%s", dir->path, entry->d_name);
+				rm_failed(rm_tree, path, errno, "Failed to stat() file");
+				free(path);
+				break;
+			}
+			is_dir = S_ISDIR(st.st_mode);
+			size = S_ISREG(st.st_mode) ? st.st_size : 0U;
+		}
+		else
+		{
+			is_dir = (entry->d_type == DT_DIR);
+		}
+
+		if(is_dir)
+		{
+			rm_dir_t *const subdir = make_rm_dir(
+					format_str("%s/%s", dir->path, entry->d_name), dir);
+			if(subdir == NULL)
+			{
+				rm_failed(rm_tree, dir->path, IO_ERR_UNKNOWN, "Not enough memory");
+				break;
+			}
+
+			pthread_mutex_lock(&rm_tree->lock);
+			++dir->pending;
+			pthread_mutex_unlock(&rm_tree->lock);
+
+			if(par_push(queue, subdir) != 0)
+			{
+				rm_dir_task(queue, subdir, rm_tree);
+			}
+			continue;
+		}
+
+		if(unlinkat(fd, entry->d_name, 0) != 0)
+		{
+			char *const path = format_str("%s/%s", dir->path, entry->d_name);
+			rm_failed(rm_tree, path, errno, "Failed to unlink file");
+			free(path);
+			break;
+		}
+
+		++nitems;
+		nbytes += size;
+		if(nitems == RM_BATCH_SIZE)
+		{
+			count_removed(rm_tree, &nitems, &nbytes);
+			if(rm_stopped(rm_tree))
+			{
+				break;
+			}
+		}
+	}
+
+	(void)closedir(d);
+	count_removed(rm_tree, &nitems, &nbytes);
+}
+
+/* Marks end of processing the directory or one of its subdirectories and
+ * removes the directory when nothing else remains.  The same is then done for
+ * its parent. */
+static void
+finish_rm_dir(rm_tree_t *rm_tree, rm_dir_t *dir)
+{
+	while(dir != NULL)
+	{
+		rm_dir_t *const parent = dir->parent;
+		int pending;
+		int skip;
+
+		pthread_mutex_lock(&rm_tree->lock);
+		pending = --dir->pending;
+		skip = (rm_tree->failed || rm_tree->stopped);
+		pthread_mutex_unlock(&rm_tree->lock);
+
+		if(pending != 0)
+		{
+			break;
+		}
+
+		if(dir->fd != -1)
+		{
+			(void)close(dir->fd);
+		}
+
+		if(!skip)
+		{
+			const int parent_fd = (parent == NULL) ? AT_FDCWD : parent->fd;
+			if(unlinkat(parent_fd, dir->name, AT_REMOVEDIR) == 0)
+			{
+				size_t nitems = 1U;
+				uint64_t nbytes = 0U;
+				count_removed(rm_tree, &nitems, &nbytes);
+			}
+			else
+			{
+				rm_failed(rm_tree, dir->path, errno, "Failed to remove directory");
+			}
+		}
+
+		free(dir->path);
+		free(dir);
+		dir = parent;
+	}
+}
+
+/* Moves counters of removed items to be reported and resets them. */
+static void
+count_removed(rm_tree_t *rm_tree, size_t *nitems, uint64_t *nbytes)
+{
+	pthread_mutex_lock(&rm_tree->lock);
+	rm_tree->nitems += *nitems;
+	rm_tree->nbytes += *nbytes;
+	pthread_mutex_unlock(&rm_tree->lock);
+
+	*nitems = 0U;
+	*nbytes = 0U;
+}
+
+/* Records an error and stops the removal. */
+static void
+rm_failed(rm_tree_t *rm_tree, const char path[], int error_code,
+		const char msg[])
+{
+	pthread_mutex_lock(&rm_tree->lock);
+	(void)ioe_errlst_append(&rm_tree->args->result.errors, path, error_code,
+			msg);
+	rm_tree->failed = 1;
+	pthread_mutex_unlock(&rm_tree->lock);
+}
+
+/* Checks whether removal should be stopped because of an error or
+ * cancellation.  Returns non-zero if so, otherwise zero is returned. */
+static int
+rm_stopped(rm_tree_t *rm_tree)
+{
+	int stopped;
+	const int cancelled = io_cancelled(rm_tree->args);
+
+	pthread_mutex_lock(&rm_tree->lock);
+	rm_tree->stopped |= cancelled;
+	stopped = (rm_tree->failed || rm_tree->stopped);
+	pthread_mutex_unlock(&rm_tree->lock);
+
+	return stopped;
+}
+
+/* par_run() callback that reports progress of removal.  Returns zero. */
+static int
+report_rm_progress(void *arg)
+{
+	flush_rm_progress(arg);
+	return 0;
+}
+
+/* Reports items removed since the last call as a single progress update. */
+static void
+flush_rm_progress(rm_tree_t *rm_tree)
+{
+	size_t nitems;
+	uint64_t nbytes;
+	char *path;
+
+	pthread_mutex_lock(&rm_tree->lock);
+	nitems = rm_tree->nitems;
+	nbytes = rm_tree->nbytes;
+	rm_tree->nitems = 0U;
+	rm_tree->nbytes = 0U;
+	path = (rm_tree->last_dir == NULL) ? NULL : strdup(rm_tree->last_dir);
+	pthread_mutex_unlock(&rm_tree->lock);
+
+	ioeta_update_bulk(rm_tree->args->estim, path, nitems, nbytes);
+	free(path);
+}
+
+#endif
+
 /* Implementation of traverse() visitor for subtree removal.  Returns 0 on
  * success, otherwise non-zero is returned. */
 static VisitResult
@@ -150,7 +561,322 @@ ior_cp(io_args_t *const args)
 		}
 	}
 
-	return traverse(src, &cp_visitor, args);
+	return cp_tree(args);
+}
+
+/* Copies subtree.  Files of a directory are copied on several threads when
+ * that's allowed and interaction with the user isn't required.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+cp_tree(io_args_t *args)
+{
+	size_t i;
+	dev_t dev;
+	int nthreads;
+	int result;
+	cp_tree_t cp_tree = { .args = args };
+
+	/* Callbacks can interact with the user and must be called sequentially. */
+	if(args->max_threads == 1 || args->confirm != NULL ||
+			args->result.errors_cb != NULL || is_symlink(args->arg1.src) ||
+			!is_dir(args->arg1.src))
+	{
+		return traverse(args->arg1.src, &cp_visitor, args);
+	}
+
+	/* Directories are created right away and in order, only files are
+	 * postponed. */
+	result = traverse(args->arg1.src, &cp_plan_visitor, &cp_tree);
+
+	if(result == 0 && cp_tree.njobs != 0U)
+	{
+		nthreads = reserve_threads(args->arg2.dst, args->max_threads, &dev);
+		result = cp_tree_on_threads(&cp_tree, nthreads);
+		release_threads(dev, nthreads);
+	}
+
+	/* Permissions and timestamps of directories are set after their files are
+	 * in place. */
+	for(i = 0U; i < cp_tree.ndirs && result == 0; ++i)
+	{
+		result = (cp_visitor(cp_tree.dirs[i], VA_DIR_LEAVE, args) != VR_OK);
+	}
+
+	for(i = 0U; i < cp_tree.njobs; ++i)
+	{
+		free(cp_tree.jobs[i].src);
+		free(cp_tree.jobs[i].dst);
+	}
+	free(cp_tree.jobs);
+	for(i = 0U; i < cp_tree.ndirs; ++i)
+	{
+		free(cp_tree.dirs[i]);
+	}
+	free(cp_tree.dirs);
+
+	return result;
+}
+
+/* Copies files collected in the cp_tree using up to nthreads threads.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+cp_tree_on_threads(cp_tree_t *cp_tree, int nthreads)
+{
+	int cancelled;
+
+	cp_tree->done = reallocarray(NULL, cp_tree->njobs, sizeof(*cp_tree->done));
+	if(cp_tree->done == NULL)
+	{
+		(void)ioe_errlst_append(&cp_tree->args->result.errors,
+				cp_tree->args->arg1.src, IO_ERR_UNKNOWN, "Not enough memory");
+		return 1;
+	}
+
+	pthread_mutex_init(&cp_tree->lock, NULL);
+	cancelled = par_run(cp_tree, nthreads, &cp_file_task, &report_cp_progress,
+			cp_tree);
+	pthread_mutex_destroy(&cp_tree->lock);
+
+	/* Report whatever was done after the last poll. */
+	(void)report_cp_progress(cp_tree);
+	free(cp_tree->done);
+
+	return (cancelled || cp_tree->failed || cp_tree->ndone != cp_tree->njobs);
+}
+
+/* Implementation of traverse() visitor that creates directories and collects
+ * files for copying them later.  Returns 0 on success, otherwise non-zero is
+ * returned. */
+static VisitResult
+cp_plan_visitor(const char full_path[], VisitAction action, void *param)
+{
+	cp_tree_t *const cp_tree = param;
+	io_args_t *const args = cp_tree->args;
+
+	if(io_cancelled(args))
+	{
+		return VR_CANCELLED;
+	}
+
+	switch(action)
+	{
+		case VA_DIR_ENTER:
+			return cp_visitor(full_path, action, args);
+		case VA_FILE:
+			{
+				const char *const rel_part = full_path + strlen(args->arg1.src);
+				cp_job_t *const jobs = reallocarray(cp_tree->jobs, cp_tree->njobs + 1U,
+						sizeof(*jobs));
+				if(jobs == NULL)
+				{
+					(void)ioe_errlst_append(&args->result.errors, full_path,
+							IO_ERR_UNKNOWN, "Not enough memory");
+					return VR_ERROR;
+				}
+				cp_tree->jobs = jobs;
+
+				jobs[cp_tree->njobs].src = strdup(full_path);
+				jobs[cp_tree->njobs].dst = format_str("%s/%s", args->arg2.dst,
+						rel_part);
+				jobs[cp_tree->njobs].bytes = 0U;
+				++cp_tree->njobs;
+				return VR_OK;
+			}
+		case VA_DIR_LEAVE:
+			{
+				char **const dirs = reallocarray(cp_tree->dirs, cp_tree->ndirs + 1U,
+						sizeof(*dirs));
+				if(dirs == NULL)
+				{
+					(void)ioe_errlst_append(&args->result.errors, full_path,
+							IO_ERR_UNKNOWN, "Not enough memory");
+					return VR_ERROR;
+				}
+				cp_tree->dirs = dirs;
+
+				dirs[cp_tree->ndirs++] = strdup(full_path);
+				return VR_OK;
+			}
+	}
+
+	return VR_ERROR;
+}
+
+/* par_run() callback that copies a single file.  The initial task is the
+ * cp_tree itself, which just queues all the files. */
+static void
+cp_file_task(par_queue_t *queue, void *task, void *arg)
+{
+	cp_tree_t *const cp_tree = arg;
+	io_args_t *const cp_args = cp_tree->args;
+	cp_job_t *const job = task;
+	io_args_t args;
+	int error;
+	int failed;
+	size_t i;
+
+	if(task == cp_tree)
+	{
+		for(i = 0U; i < cp_tree->njobs; ++i)
+		{
+			if(par_push(queue, &cp_tree->jobs[i]) != 0)
+			{
+				pthread_mutex_lock(&cp_tree->lock);
+				(void)ioe_errlst_append(&cp_args->result.errors, cp_tree->jobs[i].src,
+						IO_ERR_UNKNOWN, "Not enough memory");
+				cp_tree->failed = 1;
+				pthread_mutex_unlock(&cp_tree->lock);
+				break;
+			}
+		}
+		return;
+	}
+
+	pthread_mutex_lock(&cp_tree->lock);
+	failed = cp_tree->failed;
+	pthread_mutex_unlock(&cp_tree->lock);
+
+	/* Like sequential copying, stop after the first error. */
+	if(failed || io_cancelled(cp_args))
+	{
+		return;
+	}
+
+	memset(&args, 0, sizeof(args));
+	args.arg1.src = job->src;
+	args.arg2.dst = job->dst;
+	args.arg3.crs = cp_args->arg3.crs;
+	args.arg4.fast_file_cloning = cp_args->arg4.fast_file_cloning;
+	args.cancellation = cp_args->cancellation;
+	args.result.errors.active = cp_args->result.errors.active;
+
+	error = iop_cp(&args);
+	if(error == 0 && !is_symlink(job->src))
+	{
+		job->bytes = get_file_data_size(job->src);
+	}
+
+	pthread_mutex_lock(&cp_tree->lock);
+	for(i = 0U; i < args.result.errors.error_count; ++i)
+	{
+		const ioe_err_t *const err = &args.result.errors.errors[i];
+		(void)ioe_errlst_append(&cp_args->result.errors, err->path,
+				err->error_code, err->msg);
+	}
+	if(error != 0)
+	{
+		cp_tree->failed = 1;
+	}
+	cp_tree->done[cp_tree->ndone++] = job;
+	pthread_mutex_unlock(&cp_tree->lock);
+
+	ioe_errlst_free(&args.result.errors);
+}
+
+/* par_run() callback that reports progress of copied files.  Returns non-zero
+ * if copying should be cancelled. */
+static int
+report_cp_progress(void *arg)
+{
+	cp_tree_t *const cp_tree = arg;
+	size_t ndone;
+
+	pthread_mutex_lock(&cp_tree->lock);
+	ndone = cp_tree->ndone;
+	pthread_mutex_unlock(&cp_tree->lock);
+
+	while(cp_tree->nreported < ndone)
+	{
+		const cp_job_t *const job = cp_tree->done[cp_tree->nreported++];
+		ioeta_update(cp_tree->args->estim, job->src, job->dst, 1, job->bytes);
+	}
+
+	return io_cancelled(cp_tree->args);
+}
+
+/* Reserves threads for copying files into the path limiting their number per
+ * device by the wanted count (non-positive value means automatic choice), but
+ * always grants at least one.  Returns number of reserved threads, which should
+ * be passed to release_threads() along with the dev later. */
+static int
+reserve_threads(const char path[], int wanted, dev_t *dev)
+{
+	int i;
+	int nthreads;
+	struct stat st;
+	dev_load_t *new_loads;
+
+	if(wanted <= 0)
+	{
+		wanted = par_get_nthreads();
+	}
+
+	if(os_stat(path, &st) != 0)
+	{
+		/* Not being able to identify the device isn't fatal. */
+		*dev = (dev_t)-1;
+		return 1;
+	}
+	*dev = st.st_dev;
+
+	pthread_mutex_lock(&dev_loads_lock);
+
+	for(i = 0; i < ndev_loads; ++i)
+	{
+		if(dev_loads[i].dev == st.st_dev)
+		{
+			break;
+		}
+	}
+
+	if(i == ndev_loads)
+	{
+		new_loads = reallocarray(dev_loads, ndev_loads + 1, sizeof(*dev_loads));
+		if(new_loads == NULL)
+		{
+			pthread_mutex_unlock(&dev_loads_lock);
+			*dev = (dev_t)-1;
+			return 1;
+		}
+		dev_loads = new_loads;
+		dev_loads[ndev_loads].dev = st.st_dev;
+		dev_loads[ndev_loads].nthreads = 0;
+		++ndev_loads;
+	}
+
+	nthreads = wanted - dev_loads[i].nthreads;
+	if(nthreads < 1)
+	{
+		nthreads = 1;
+	}
+	dev_loads[i].nthreads += nthreads;
+
+	pthread_mutex_unlock(&dev_loads_lock);
+
+	return nthreads;
+}
+
+/* Releases threads reserved by reserve_threads(). */
+static void
+release_threads(dev_t dev, int nthreads)
+{
+	int i;
+
+	if(dev == (dev_t)-1)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&dev_loads_lock);
+	for(i = 0; i < ndev_loads; ++i)
+	{
+		if(dev_loads[i].dev == dev)
+		{
+			dev_loads[i].nthreads -= nthreads;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&dev_loads_lock);
 }
 
 /* Implementation of traverse() visitor for subtree copying.  Returns 0 on
@@ -19,8 +19,19 @@
 #ifndef VIFM__IO__PRIVATE__IOC_H__
 #define VIFM__IO__PRIVATE__IOC_H__
 
+#include <fcntl.h> /* AT_* O_* */
+
 #include "../ioc.h"
 
+/* Whether files can be opened, queried and removed relative to their parent
+ * directories, which saves resolving whole path on every system call. */
+#if !defined(_WIN32) && defined(AT_FDCWD) && defined(AT_REMOVEDIR) && \
+    defined(AT_SYMLINK_NOFOLLOW) && defined(O_DIRECTORY) && defined(O_NOFOLLOW)
+#define IO_HAVE_AT_FUNCS 1
+#else
+#define IO_HAVE_AT_FUNCS 0
+#endif
+
 /* Convenience function that checks whether given I/O operation was cancelled
  * (uses hook provided in operation arguments).  Returns non-zero if so,
  * otherwise zero is returned. */
@@ -18,7 +18,7 @@
 
 #include "ioeta.h"
 
-#include <stddef.h> /* NULL */
+#include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* uint64_t */
 
 #include "../../utils/fs.h"
@@ -41,7 +41,7 @@ ioeta_add_file(ioeta_estim_t *estim, const char path[])
 {
 	if(!is_symlink(path))
 	{
-		estim->total_bytes += get_file_size(path);
+		estim->total_bytes += get_file_data_size(path);
 	}
 
 	ioeta_add_item(estim, path);
@@ -69,6 +69,8 @@ ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 		return;
 	}
 
+	ioeta_pull_bg(estim);
+
 	estim->current_byte += bytes;
 	estim->current_file_byte += bytes;
 	if(estim->current_byte > estim->total_bytes)
@@ -91,7 +93,7 @@ ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 	else if(estim->inspected_items != estim->current_item + 1)
 	{
 		estim->inspected_items = estim->current_item + 1;
-		estim->total_file_bytes = get_file_size(path);
+		estim->total_file_bytes = get_file_data_size(path);
 	}
 
 	if(path != NULL)
@@ -107,6 +109,42 @@ ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 	ionotif_notify(IO_PS_IN_PROGRESS, estim);
 }
 
+void
+ioeta_update_bulk(ioeta_estim_t *estim, const char path[], size_t items,
+		uint64_t bytes)
+{
+	if(estim == NULL || estim->silent || (items == 0U && bytes == 0U))
+	{
+		return;
+	}
+
+	ioeta_pull_bg(estim);
+
+	estim->current_byte += bytes;
+	if(estim->current_byte > estim->total_bytes)
+	{
+		/* Estimations are out of date, update them. */
+		estim->total_bytes = estim->current_byte;
+	}
+
+	estim->current_item += items;
+	if(estim->current_item > estim->total_items)
+	{
+		/* Estimations are out of date, update them. */
+		estim->total_items = estim->current_item;
+	}
+	estim->current_file_byte = 0U;
+	estim->total_file_bytes = 0U;
+
+	if(path != NULL)
+	{
+		replace_string(&estim->item, path);
+		replace_string(&estim->target, path);
+	}
+
+	ionotif_notify(IO_PS_IN_PROGRESS, estim);
+}
+
 int
 ioeta_silent_on(ioeta_estim_t *estim)
 {
@@ -19,6 +19,7 @@
 #ifndef VIFM__IO__PRIVATE__IOETA_H__
 #define VIFM__IO__PRIVATE__IOETA_H__
 
+#include <stddef.h> /* size_t */
 #include <stdint.h> /* uint64_t */
 
 #include "../ioeta.h"
@@ -44,6 +45,17 @@ void ioeta_add_dir(ioeta_estim_t *estim, const char path[]);
 void ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 		int finished, uint64_t bytes);
 
+/* Reports that several items of the specified total size were processed
+ * at once, which results in a single notification.  When estim is NULL, the
+ * function just returns.  The path can be NULL to indicate that file name
+ * didn't change. */
+void ioeta_update_bulk(ioeta_estim_t *estim, const char path[], size_t items,
+		uint64_t bytes);
+
+/* Updates totals with results of estimation performed by ioeta_calculate_bg().
+ * Does nothing if there is no such estimation. */
+void ioeta_pull_bg(ioeta_estim_t *estim);
+
 /* Silence future progress reports.  Returns previous state to be passed to
  * ioeta_silent_set() later.  If estim is NULL, returns zero. */
 int ioeta_silent_on(ioeta_estim_t *estim);
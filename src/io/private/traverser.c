@@ -18,16 +18,36 @@
 
 #include "traverser.h"
 
-#include <stddef.h> /* NULL */
+#include <fcntl.h> /* AT_* O_* openat() */
+#include <sys/stat.h> /* S_ISDIR S_ISLNK fstatat() stat */
+#include <unistd.h> /* close() */
+
+#include <dirent.h> /* DIR dirfd() fdopendir() */
+#include <stddef.h> /* NULL size_t */
 #include <stdlib.h> /* free() */
+#include <string.h> /* strdup() strlen() */
 
 #include "../../compat/os.h"
 #include "../../utils/fs.h"
 #include "../../utils/path.h"
 #include "../../utils/str.h"
+#include "ioc.h"
+
+/* Path to currently visited entry, which is reused to avoid allocating a new
+ * string for each entry. */
+typedef struct
+{
+	char *path; /* Full path, always valid. */
+	size_t len; /* Length of the path. */
+}
+path_buf_t;
 
-static int traverse_subtree(const char path[], subtree_visitor visitor,
+static int traverse_subtree(DIR *dir, path_buf_t *buf, subtree_visitor visitor,
 		void *param);
+static int append_name(path_buf_t *buf, const char name[]);
+static DIR * open_subdir(DIR *parent, const char name[], const char path[]);
+static void classify_entry(DIR *dir, const struct dirent *d,
+		const char full_path[], int *is_link, int *is_dir);
 
 int
 traverse(const char path[], subtree_visitor visitor, void *param)
@@ -42,7 +62,25 @@ traverse(const char path[], subtree_visitor visitor, void *param)
 	}
 	else if(is_dir(path))
 	{
-		return traverse_subtree(path, visitor, param);
+		int result;
+		path_buf_t buf;
+		DIR *const dir = os_opendir(path);
+		if(dir == NULL)
+		{
+			return 1;
+		}
+
+		buf.path = strdup(path);
+		if(buf.path == NULL)
+		{
+			(void)os_closedir(dir);
+			return 1;
+		}
+		buf.len = strlen(path);
+
+		result = traverse_subtree(dir, &buf, visitor, param);
+		free(buf.path);
+		return result;
 	}
 	else
 	{
@@ -50,23 +88,19 @@ traverse(const char path[], subtree_visitor visitor, void *param)
 	}
 }
 
-/* A generic subtree traversing.  Returns zero on success, otherwise non-zero is
- * returned. */
+/* A generic subtree traversing.  The dir is the opened directory at buf->path,
+ * which is closed by this function.  Returns zero on success, otherwise
+ * non-zero is returned. */
 static int
-traverse_subtree(const char path[], subtree_visitor visitor, void *param)
+traverse_subtree(DIR *dir, path_buf_t *buf, subtree_visitor visitor,
+		void *param)
 {
-	DIR *dir;
 	struct dirent *d;
 	int result;
 	VisitResult enter_result;
+	const size_t len = buf->len;
 
-	dir = os_opendir(path);
-	if(dir == NULL)
-	{
-		return 1;
-	}
-
-	enter_result = visitor(path, VA_DIR_ENTER, param);
+	enter_result = visitor(buf->path, VA_DIR_ENTER, param);
 	if(enter_result == VR_ERROR)
 	{
 		(void)os_closedir(dir);
@@ -76,28 +110,35 @@ traverse_subtree(const char path[], subtree_visitor visitor, void *param)
 	result = 0;
 	while((d = os_readdir(dir)) != NULL)
 	{
-		char *full_path;
+		int is_link, is_dir;
 
 		if(is_builtin_dir(d->d_name))
 		{
 			continue;
 		}
 
-		full_path = format_str("%s/%s", path, d->d_name);
-		if(entry_is_link(full_path, d))
+		if(append_name(buf, d->d_name) != 0)
 		{
-			/* Treat symbolic links to directories as files as well. */
-			result = visitor(full_path, VA_FILE, param);
+			result = 1;
+			break;
 		}
-		else if(entry_is_dir(full_path, d))
+
+		classify_entry(dir, d, buf->path, &is_link, &is_dir);
+		if(is_link || !is_dir)
 		{
-			result = traverse_subtree(full_path, visitor, param);
+			/* Treat symbolic links to directories as files as well. */
+			result = visitor(buf->path, VA_FILE, param);
 		}
 		else
 		{
-			result = visitor(full_path, VA_FILE, param);
+			DIR *const subdir = open_subdir(dir, d->d_name, buf->path);
+			result = (subdir == NULL)
+			       ? 1
+			       : traverse_subtree(subdir, buf, visitor, param);
 		}
-		free(full_path);
+
+		buf->len = len;
+		buf->path[len] = '\0';
 
 		if(result != 0)
 		{
@@ -109,11 +150,84 @@ traverse_subtree(const char path[], subtree_visitor visitor, void *param)
 	if(result == 0 && enter_result != VR_SKIP_DIR_LEAVE &&
 			enter_result != VR_CANCELLED)
 	{
-		result = visitor(path, VA_DIR_LEAVE, param);
+		result = visitor(buf->path, VA_DIR_LEAVE, param);
 	}
 
 	return result;
 }
 
+/* Appends name of an entry to the path.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+append_name(path_buf_t *buf, const char name[])
+{
+	const size_t len = buf->len;
+	if(strappendch(&buf->path, &buf->len, '/') != 0 ||
+			strappend(&buf->path, &buf->len, name) != 0)
+	{
+		buf->len = len;
+		buf->path[len] = '\0';
+		return 1;
+	}
+	return 0;
+}
+
+/* Opens subdirectory of the parent directory.  Returns opened directory or
+ * NULL on error. */
+static DIR *
+open_subdir(DIR *parent, const char name[], const char path[])
+{
+#if IO_HAVE_AT_FUNCS
+	DIR *dir;
+	const int fd = openat(dirfd(parent), name,
+			O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+	if(fd == -1)
+	{
+		return NULL;
+	}
+
+	dir = fdopendir(fd);
+	if(dir == NULL)
+	{
+		(void)close(fd);
+	}
+	return dir;
+#else
+	return os_opendir(path);
+#endif
+}
+
+/* Determines type of the directory entry avoiding system calls when possible.
+ * Symbolic links are not resolved. */
+static void
+classify_entry(DIR *dir, const struct dirent *d, const char full_path[],
+		int *is_link, int *is_dir)
+{
+#if IO_HAVE_AT_FUNCS
+	struct stat st;
+
+	if(d->d_type != DT_UNKNOWN)
+	{
+		*is_link = (d->d_type == DT_LNK);
+		*is_dir = (d->d_type == DT_DIR);
+		return;
+	}
+
+	if(fstatat(dirfd(dir), d->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+	{
+		/* Let the visitor deal with the entry. */
+		*is_link = 0;
+		*is_dir = 0;
+		return;
+	}
+
+	*is_link = S_ISLNK(st.st_mode);
+	*is_dir = S_ISDIR(st.st_mode);
+#else
+	*is_link = entry_is_link(full_path, d);
+	*is_dir = !*is_link && entry_is_dir(full_path, d);
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -21,7 +21,8 @@
 
 #include <stddef.h> /* NULL */
 #include <stdio.h> /* snprintf() */
-#include <string.h> /* strlen() strdup() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
 
 #include "../compat/reallocarray.h"
 #include "../modes/dialogs/msg_dialog.h"
@@ -35,7 +36,9 @@
 static int execute_jobs_cb(FileView *view, menu_data_t *m);
 static KHandlerResponse jobs_khandler(FileView *view, menu_data_t *m,
 		const wchar_t keys[]);
+static char * format_job_item(bg_job_t *job);
 static int cancel_job(menu_data_t *m, bg_job_t *job);
+static int control_job(menu_data_t *m, bg_job_t *job, const wchar_t keys[]);
 static void show_job_errors(FileView *view, menu_data_t *m, bg_job_t *job);
 static KHandlerResponse errs_khandler(FileView *view, menu_data_t *m,
 		const wchar_t keys[]);
@@ -65,27 +68,9 @@ show_jobs_menu(FileView *view)
 	{
 		if(bg_job_is_running(p))
 		{
-			char info_buf[24];
-			char item_buf[sizeof(info_buf) + strlen(p->cmd) + 1024];
-
-			if(p->type == BJT_COMMAND)
-			{
-				snprintf(info_buf, sizeof(info_buf), "%" PRINTF_ULL,
-						(unsigned long long)p->pid);
-			}
-			else if(p->bg_op.total == BG_UNDEFINED_TOTAL)
-			{
-				snprintf(info_buf, sizeof(info_buf), "n/a");
-			}
-			else
-			{
-				snprintf(info_buf, sizeof(info_buf), "%d/%d", p->bg_op.done + 1,
-						p->bg_op.total);
-			}
-
-			snprintf(item_buf, sizeof(item_buf), "%-8s  %s%s", info_buf, p->cmd,
-					bg_job_cancelled(p) ? " (cancelling...)" : "");
-			i = add_to_string_array(&jobs_m.items, i, 1, item_buf);
+			char *const item = format_job_item(p);
+			i = add_to_string_array(&jobs_m.items, i, 1, item);
+			free(item);
 			jobs_m.void_data = reallocarray(jobs_m.void_data, i,
 					sizeof(*jobs_m.void_data));
 			jobs_m.void_data[i - 1] = p;
@@ -101,6 +86,41 @@ show_jobs_menu(FileView *view)
 	return display_menu(jobs_m.state, view);
 }
 
+/* Formats menu item that describes the job.  Returns newly allocated string. */
+static char *
+format_job_item(bg_job_t *job)
+{
+	char info_buf[24];
+	char prio_buf[32];
+
+	if(job->type == BJT_COMMAND)
+	{
+		snprintf(info_buf, sizeof(info_buf), "%" PRINTF_ULL,
+				(unsigned long long)job->pid);
+	}
+	else if(job->bg_op.total == BG_UNDEFINED_TOTAL)
+	{
+		snprintf(info_buf, sizeof(info_buf), "n/a");
+	}
+	else
+	{
+		snprintf(info_buf, sizeof(info_buf), "%d/%d", job->bg_op.done + 1,
+				job->bg_op.total);
+	}
+
+	prio_buf[0] = '\0';
+	if(job->type != BJT_COMMAND && bg_job_get_priority(job) != 0)
+	{
+		snprintf(prio_buf, sizeof(prio_buf), " (priority: %d)",
+				bg_job_get_priority(job));
+	}
+
+	return format_str("%-8s  %s%s%s%s", info_buf, job->cmd, prio_buf,
+			job->type != BJT_COMMAND && bg_job_is_paused(job) ? " (paused)" : "",
+			bg_job_cancelled(job) ? " (cancelling...)" :
+			bg_job_is_queued(job) ? " (queued)" : "");
+}
+
 /* Callback that is called when menu item is selected.  Should return non-zero
  * to stay in menu mode. */
 static int
@@ -131,6 +151,18 @@ jobs_khandler(FileView *view, menu_data_t *m, const wchar_t keys[])
 		show_job_errors(view, m, m->void_data[m->pos]);
 		return KHR_REFRESH_WINDOW;
 	}
+	else if(wcscmp(keys, L"p") == 0 || wcscmp(keys, L"+") == 0 ||
+			wcscmp(keys, L"-") == 0)
+	{
+		if(!control_job(m, m->void_data[m->pos], keys))
+		{
+			show_error_msg("Job control", "The job has already stopped");
+			return KHR_REFRESH_WINDOW;
+		}
+
+		draw_menu(m->state);
+		return KHR_REFRESH_WINDOW;
+	}
 	/* TODO: maybe use DD for forced termination? */
 	return KHR_UNHANDLED;
 }
@@ -163,6 +195,48 @@ cancel_job(menu_data_t *m, bg_job_t *job)
 	return (p != NULL);
 }
 
+/* Pauses/resumes the job ("p") or changes its priority ("+" and "-") if it's
+ * still running.  Returns non-zero if the job was found, otherwise it's already
+ * finished and zero is returned. */
+static int
+control_job(menu_data_t *m, bg_job_t *job, const wchar_t keys[])
+{
+	bg_job_t *p;
+
+	/* We have to make sure the job pointer is still valid and the job is
+	 * running. */
+	bg_jobs_freeze();
+	for(p = bg_jobs; p != NULL; p = p->next)
+	{
+		if(p == job && bg_job_is_running(job))
+		{
+			if(job->type == BJT_COMMAND)
+			{
+				/* External commands aren't controlled by us. */
+			}
+			else if(wcscmp(keys, L"p") == 0)
+			{
+				if(!bg_job_pause(job))
+				{
+					(void)bg_job_resume(job);
+				}
+			}
+			else
+			{
+				const int delta = (wcscmp(keys, L"+") == 0) ? 1 : -1;
+				bg_job_set_priority(job, bg_job_get_priority(job) + delta);
+			}
+
+			free(m->items[m->pos]);
+			m->items[m->pos] = format_job_item(job);
+			break;
+		}
+	}
+	bg_jobs_unfreeze();
+
+	return (p != NULL);
+}
+
 /* Shows job errors if there is something and the job is still running.
  * Switches to separate menu description. */
 static void
@@ -142,6 +142,8 @@ enter_attr_mode(FileView *active_view)
 	entry = NULL;
 	while(iter_selection_or_current(view, &entry))
 	{
+		fentry_load_meta(entry);
+
 		if(first)
 		{
 			fmode = entry->mode;
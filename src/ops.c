@@ -179,6 +179,7 @@ ops_alloc(OPS main_op, int bg, const char descr[], const char base_dir[],
 	update_string(&ops->delete_prg, cfg.delete_prg);
 	ops->use_system_calls = cfg.use_system_calls;
 	ops->fast_file_cloning = cfg.fast_file_cloning;
+	ops->io_threads = cfg.io_threads;
 	ops->base_dir = strdup(base_dir);
 	ops->target_dir = strdup(target_dir);
 	ops->bg = bg;
@@ -238,7 +239,15 @@ ops_enqueue(ops_t *ops, const char src[], const char dst[])
 		}
 	}
 
-	ioeta_calculate(ops->estim, src, ops->shallow_eta);
+	if(ops->bg && !ops->shallow_eta)
+	{
+		/* Let background operation start without waiting for the estimation. */
+		ioeta_calculate_bg(ops->estim, src);
+	}
+	else
+	{
+		ioeta_calculate(ops->estim, src, ops->shallow_eta);
+	}
 }
 
 void
@@ -938,6 +947,7 @@ exec_io_op(ops_t *ops, int (*func)(io_args_t *const), io_args_t *const args,
 	int result;
 
 	args->estim = (ops == NULL) ? NULL : ops->estim;
+	args->max_threads = (ops == NULL) ? cfg.io_threads : ops->io_threads;
 
 	if(ops != NULL)
 	{
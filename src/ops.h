@@ -95,6 +95,7 @@ typedef struct
 	char *delete_prg;      /* Copy of 'deleteprg' option value. */
 	int use_system_calls;  /* Copy of 'syscalls' option value. */
 	int fast_file_cloning; /* Copy of part of 'iooptions' option value. */
+	int io_threads;        /* Copy of 'iothreads' option value. */
 
 	char *base_dir;   /* Base directory in which operation is taking place. */
 	char *target_dir; /* Target directory of the operation (same as base_dir if
@@ -115,7 +116,8 @@ ops_t * ops_alloc(OPS main_op, int bg, const char descr[],
 const char * ops_describe(const ops_t *ops);
 
 /* Puts new item to the ops.  Destination argument is a hint to optimize
- * estimating performance, it can be NULL. */
+ * estimating performance, it can be NULL.  Background operations estimate
+ * items on a separate thread, which lets them start right away. */
 void ops_enqueue(ops_t *ops, const char src[], const char dst[]);
 
 /* Advances ops to the next item. */
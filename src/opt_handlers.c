@@ -43,6 +43,7 @@
 #include "utils/log.h"
 #include "utils/macros.h"
 #include "utils/matchers.h"
+#include "utils/parallel.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
@@ -135,6 +136,7 @@ static void iec_handler(OPT_OP op, optval_t val);
 static void ignorecase_handler(OPT_OP op, optval_t val);
 static void incsearch_handler(OPT_OP op, optval_t val);
 static void iooptions_handler(OPT_OP op, optval_t val);
+static void iothreads_handler(OPT_OP op, optval_t val);
 static void laststatus_handler(OPT_OP op, optval_t val);
 static void lines_handler(OPT_OP op, optval_t val);
 static void locateprg_handler(OPT_OP op, optval_t val);
@@ -580,6 +582,10 @@ options[] = {
 		NULL,
 	  { .init = &init_iooptions },
 	},
+	{ "iothreads", "", "number of threads for reading files",
+	  OPT_INT, 0, NULL, &iothreads_handler, NULL,
+	  { .ref.int_val = &cfg.io_threads },
+	},
 	{ "laststatus", "ls", "visibility of status bar",
 	  OPT_BOOL, 0, NULL, &laststatus_handler, NULL,
 	  { .ref.bool_val = &cfg.display_statusline },
@@ -1900,6 +1906,23 @@ iooptions_handler(OPT_OP op, optval_t val)
 	cfg.fast_file_cloning = ((val.set_items & 1) != 0);
 }
 
+/* Handles changes of 'iothreads'.  Validates and updates configuration. */
+static void
+iothreads_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val < 0 || val.int_val > PAR_MAX_THREADS)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be in [0; %d] range: %d",
+				PAR_MAX_THREADS, val.int_val);
+		error = 1;
+		val.int_val = cfg.io_threads;
+		set_option("iothreads", val, OPT_GLOBAL);
+		return;
+	}
+
+	cfg.io_threads = val.int_val;
+}
+
 static void
 laststatus_handler(OPT_OP op, optval_t val)
 {
@@ -23,15 +23,20 @@
 
 #include <assert.h> /* assert() */
 #include <ctype.h>
-#include <stdlib.h> /* abs() qsort() */
-#include <string.h> /* strcmp() strrchr() */
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* abs() free() */
+#include <string.h> /* memcpy() strcmp() strdup() strrchr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
+#include "compat/reallocarray.h"
 #include "ui/ui.h"
 #include "utils/dynarray.h"
 #include "utils/fs.h"
 #include "utils/fsdata.h"
+#include "utils/macros.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
@@ -43,50 +48,90 @@
 #include "status.h"
 #include "types.h"
 
-static void sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
-		size_t nchildren, int root);
-static void sort_sequence(dir_entry_t *entries, size_t nentries);
-static void sort_by_groups(dir_entry_t *entries, size_t nentries);
-static void sort_by_key(dir_entry_t *entries, size_t nentries, char key,
-		void *data);
-static int sort_dir_list(const void *one, const void *two);
+/* Minimal number of items to sort on several threads. */
+#define PAR_THRESHOLD 4096
+/* Number of items processed by a thread at a time on extracting keys. */
+#define PAR_CHUNK 256
+/* Length of runs sorted by insertion sort before merging them. */
+#define SORT_RUN 32
+
+/* Parameters of sorting, which are shared by all of its rounds. */
+typedef struct
+{
+	const FileView *view;    /* View whose entries are being sorted. */
+	const char *sort;        /* Picked sort array of the view. */
+	const char *sort_groups; /* Picked sort groups setting of the view. */
+	int custom_view;         /* Whether the view displays custom file list. */
+}
+sort_params_t;
+
+/* Element of array that is sorted in place of entries.  Carries key of current
+ * sorting round extracted beforehand, so that comparisons are cheap and don't
+ * query file system or allocate memory. */
+typedef struct
+{
+	const dir_entry_t *entry; /* Entry that corresponds to this item. */
+	const char *name;         /* Name of the entry or its short path. */
+	const char *str;          /* String key of the item or NULL. */
+	char *name_buf;           /* Storage of name, when it's not entry->name. */
+	char *str_buf;            /* Storage of string key, if it's allocated. */
+	uint64_t size;            /* Numerical unsigned key of the item. */
+	long long num;            /* Numerical signed key of the item. */
+	unsigned int is_dir : 1;    /* Whether entry is a directory. */
+	unsigned int is_parent : 1; /* Whether entry is a parent directory. */
+}
+sort_item_t;
+
+/* State of a single sorting round (sorting by one key). */
+typedef struct
+{
+	const sort_params_t *params; /* Parameters of the sorting. */
+	SortingKey key;              /* Key used to sort entries in this round. */
+	int descending;              /* Whether it's descending sort. */
+	const regex_t *regex;        /* Regular expression for SK_BY_GROUPS. */
+	sort_item_t *items;          /* Items that are being sorted. */
+	sort_item_t *src;            /* Source of current merge pass. */
+	sort_item_t *dst;            /* Destination of current merge pass. */
+	size_t nitems;               /* Number of items. */
+	size_t width;                /* Length of sorted runs in current pass. */
+}
+sort_round_t;
+
+static void sort_tree_slice(const sort_params_t *params, dir_entry_t *entries,
+		const dir_entry_t *children, size_t nchildren, int root);
+static void sort_sequence(const sort_params_t *params, dir_entry_t *entries,
+		size_t nentries);
+static void init_items(size_t from, size_t to, void *arg);
+static void sort_by_groups(const sort_params_t *params, sort_item_t items[],
+		size_t nitems);
+static void sort_by_key(const sort_params_t *params, sort_item_t items[],
+		size_t nitems, char key, const regex_t *regex);
+static int compare_by_key(const sort_params_t *params, sort_item_t items[2],
+		char key);
+static void extract_keys(size_t from, size_t to, void *arg);
+static void extract_key(const sort_round_t *round, sort_item_t *item);
+static void sort_runs(size_t from, size_t to, void *arg);
+static void merge_runs(size_t from, size_t to, void *arg);
+static int compare_items(const sort_round_t *round, const sort_item_t *a,
+		const sort_item_t *b);
 TSTATIC int strnumcmp(const char s[], const char t[]);
 #if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
 static int vercmp(const char s[], const char t[]);
 #else
 static char * skip_leading_zeros(const char str[]);
 #endif
-static int compare_entry_names(const dir_entry_t *a, const dir_entry_t *b,
-		int ignore_case);
-static int compare_full_file_names(const char s[], const char t[],
-		int ignore_case);
-static int compare_file_names(const char s[], const char t[], int ignore_case);
-static int compare_file_sizes(const dir_entry_t *f, int fdir,
-		const dir_entry_t *s, int sdir);
-static int compare_item_count(const dir_entry_t *f, int fdir,
-		const dir_entry_t *s, int sdir);
-static int compare_group(const char f[], const char s[], regex_t *regex);
-static int compare_targets(const dir_entry_t *f, const dir_entry_t *s);
-
-/* View which is being sorted. */
-static FileView* view;
-/* Picked sort array of the view. */
-static const char *view_sort;
-/* Picked sort groups setting of the view. */
-static const char *view_sort_groups;
-/* Whether the view displays custom file list. */
-static int custom_view;
-/* Whether it's descending sort. */
-static int sort_descending;
-/* Key used to sort entries in current sorting round. */
-static SortingKey sort_type;
-/* Sorting key specific data. */
-static void *sort_data;
+static int compare_extensions(const sort_round_t *round, const sort_item_t *a,
+		const sort_item_t *b);
+static int compare_targets(const sort_item_t *a, const sort_item_t *b);
+static int compare_full_file_names(const char s[], const char t[]);
+static int compare_file_names(const char s[], const char t[]);
+static int sorting_needs_meta(const char sort[]);
 
 void
 sort_view(FileView *v)
 {
 	dir_entry_t *unsorted_list;
+	sort_params_t params;
 
 	if(v->sort[0] > SK_LAST)
 	{
@@ -94,16 +139,21 @@ sort_view(FileView *v)
 		return;
 	}
 
-	view = v;
-	view_sort = v->sort;
-	view_sort_groups = v->sort_groups;
-	custom_view = flist_custom_active(v);
+	params.view = v;
+	params.sort = v->sort;
+	params.sort_groups = v->sort_groups;
+	params.custom_view = flist_custom_active(v);
 
-	if(!custom_view || v->custom.type != CV_TREE)
+	if(sorting_needs_meta(params.sort))
+	{
+		flist_load_meta(v);
+	}
+
+	if(!params.custom_view || v->custom.type != CV_TREE)
 	{
 		/* Tree sorting works fine for flat list, but requires a bit more
 		 * resources, so skip it. */
-		sort_sequence(&v->dir_entry[0], v->list_rows);
+		sort_sequence(&params, &v->dir_entry[0], v->list_rows);
 		return;
 	}
 
@@ -118,7 +168,7 @@ sort_view(FileView *v)
 	unsorted_list = v->dir_entry;
 	v->dir_entry = dynarray_extend(NULL, v->list_rows*sizeof(*v->dir_entry));
 
-	sort_tree_slice(&v->dir_entry[0], unsorted_list, v->list_rows, 1);
+	sort_tree_slice(&params, &v->dir_entry[0], unsorted_list, v->list_rows, 1);
 
 	if(filter_is_empty(&v->local_filter.filter))
 	{
@@ -133,8 +183,8 @@ sort_view(FileView *v)
 /* Sorts one level of a tree per invocation, recurring to sort all nested
  * trees. */
 static void
-sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
-		size_t nchildren, int root)
+sort_tree_slice(const sort_params_t *params, dir_entry_t *entries,
+		const dir_entry_t *children, size_t nchildren, int root)
 {
 	int i = 0;
 	size_t pos = 0U;
@@ -148,7 +198,7 @@ sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
 		++i;
 	}
 
-	sort_sequence(entries, i);
+	sort_sequence(params, entries, i);
 
 	/* Finish sorting of this level by placing nodes at their corresponding
 	 * position starting with the last one.  Each subtree is then sorted
@@ -160,8 +210,8 @@ sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
 		entries[pos] = entries[i];
 		if(entries[pos].child_count != 0)
 		{
-			sort_tree_slice(&entries[pos + 1U], &children[entries[pos].child_pos + 1],
-					entries[pos].child_count, 0);
+			sort_tree_slice(params, &entries[pos + 1U],
+					&children[entries[pos].child_pos + 1], entries[pos].child_count, 0);
 		}
 		entries[pos].child_pos = root ? 0 : pos + 1;
 	}
@@ -170,28 +220,60 @@ sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
 void
 sort_entries(FileView *v, entries_t entries)
 {
+	sort_params_t params;
+
 	if(v->sort_g[0] > SK_LAST)
 	{
 		/* Completely skip sorting if primary key isn't set. */
 		return;
 	}
 
-	view = v;
-	view_sort = v->sort_g;
-	view_sort_groups = v->sort_groups_g;
-	custom_view = flist_custom_active(v);
+	params.view = v;
+	params.sort = v->sort_g;
+	params.sort_groups = v->sort_groups_g;
+	params.custom_view = flist_custom_active(v);
 
-	sort_sequence(entries.entries, entries.nentries);
+	sort_sequence(&params, entries.entries, entries.nentries);
 }
 
-/* Sorts sequence of file entries (plain list, not tree). */
+/* Sorts sequence of file entries (plain list, not tree).  Entries themselves
+ * are moved only once, all rounds of sorting are performed on array of items
+ * with precomputed keys. */
 static void
-sort_sequence(dir_entry_t *entries, size_t nentries)
+sort_sequence(const sort_params_t *params, dir_entry_t *entries,
+		size_t nentries)
 {
-	int i = SK_COUNT;
-	while(--i >= 0)
+	size_t i;
+	int j;
+	sort_round_t round = { .items = NULL };
+	dir_entry_t *sorted;
+
+	if(nentries < 2U)
 	{
-		const char sorting_key = view_sort[i];
+		return;
+	}
+
+	round.items = reallocarray(NULL, nentries, sizeof(*round.items));
+	sorted = reallocarray(NULL, nentries, sizeof(*sorted));
+	if(round.items == NULL || sorted == NULL)
+	{
+		free(round.items);
+		free(sorted);
+		return;
+	}
+
+	for(i = 0U; i < nentries; ++i)
+	{
+		round.items[i].entry = &entries[i];
+	}
+	round.nitems = nentries;
+	par_for(nentries, PAR_CHUNK, nentries < PAR_THRESHOLD ? 1 : 0, &init_items,
+			&round);
+
+	j = SK_COUNT;
+	while(--j >= 0)
+	{
+		const char sorting_key = params->sort[j];
 
 		if(abs(sorting_key) > SK_LAST)
 		{
@@ -200,29 +282,61 @@ sort_sequence(dir_entry_t *entries, size_t nentries)
 
 		if(sorting_key == SK_BY_GROUPS)
 		{
-			sort_by_groups(entries, nentries);
+			sort_by_groups(params, round.items, nentries);
 			continue;
 		}
 
-		sort_by_key(entries, nentries, sorting_key, NULL);
+		sort_by_key(params, round.items, nentries, sorting_key, NULL);
+	}
+
+	if(!ui_view_sort_list_contains(params->sort, SK_BY_DIR))
+	{
+		sort_by_key(params, round.items, nentries, SK_BY_DIR, NULL);
 	}
 
-	if(!ui_view_sort_list_contains(view_sort, SK_BY_DIR))
+	for(i = 0U; i < nentries; ++i)
 	{
-		sort_by_key(entries, nentries, SK_BY_DIR, NULL);
+		sorted[i] = *round.items[i].entry;
+		free(round.items[i].name_buf);
+		free(round.items[i].str_buf);
+	}
+	memcpy(entries, sorted, sizeof(*entries)*nentries);
+
+	free(sorted);
+	free(round.items);
+}
+
+/* Initializes items of the [from; to) range with key-independent data.  Might
+ * be called in parallel. */
+static void
+init_items(size_t from, size_t to, void *arg)
+{
+	sort_round_t *const round = arg;
+	size_t i;
+	for(i = from; i < to; ++i)
+	{
+		sort_item_t *const item = &round->items[i];
+		item->name = item->entry->name;
+		item->str = NULL;
+		item->name_buf = NULL;
+		item->str_buf = NULL;
+		item->size = 0U;
+		item->num = 0;
+		item->is_dir = (fentry_is_dir(item->entry) != 0);
+		item->is_parent = item->is_dir && is_parent_dir(item->entry->name);
 	}
 }
 
-/* Sorts specified range of entries according to sorting groups option. */
+/* Sorts items according to sorting groups option. */
 static void
-sort_by_groups(dir_entry_t *entries, size_t nentries)
+sort_by_groups(const sort_params_t *params, sort_item_t items[], size_t nitems)
 {
 	char **groups = NULL;
 	int ngroups = 0;
-	const int optimize = (view_sort_groups != view->sort_groups_g);
+	const int optimize = (params->sort_groups != params->view->sort_groups_g);
 	int i;
 
-	char *const copy = strdup(view_sort_groups);
+	char *const copy = strdup(params->sort_groups);
 	char *group = copy, *state = NULL;
 	while((group = split_and_get(group, ',', &state)) != NULL)
 	{
@@ -234,38 +348,365 @@ sort_by_groups(dir_entry_t *entries, size_t nentries)
 	{
 		regex_t regex;
 		(void)regcomp(&regex, groups[i], REG_EXTENDED | REG_ICASE);
-		sort_by_key(entries, nentries, SK_BY_GROUPS, &regex);
+		sort_by_key(params, items, nitems, SK_BY_GROUPS, &regex);
 		regfree(&regex);
 	}
 	if(optimize && ngroups != 0)
 	{
-		sort_by_key(entries, nentries, SK_BY_GROUPS, &view->primary_group);
+		sort_by_key(params, items, nitems, SK_BY_GROUPS,
+				&params->view->primary_group);
 	}
 
 	free_string_array(groups, ngroups);
 }
 
-/* Sorts specified range of entries by the key in a stable way. */
+/* Sorts items by the key in a stable way.  Keys are extracted first, then
+ * bottom-up merge sort is performed.  Both steps are done in parallel for large
+ * number of items. */
 static void
-sort_by_key(dir_entry_t *entries, size_t nentries, char key, void *data)
+sort_by_key(const sort_params_t *params, sort_item_t items[], size_t nitems,
+		char key, const regex_t *regex)
 {
-	unsigned int i;
+	sort_round_t round;
+	sort_item_t *buf;
+	const int nthreads = (nitems < PAR_THRESHOLD) ? 1 : 0;
 
-	if(nentries == 0U)
+	buf = reallocarray(NULL, nitems, sizeof(*buf));
+	if(buf == NULL)
 	{
 		return;
 	}
 
-	sort_descending = (key < 0);
-	sort_type = (SortingKey)abs(key);
-	sort_data = data;
+	round.params = params;
+	round.key = (SortingKey)abs(key);
+	round.descending = (key < 0);
+	round.regex = regex;
+	round.items = items;
+	round.nitems = nitems;
 
-	for(i = 0U; i < nentries; ++i)
+	par_for(nitems, PAR_CHUNK, nthreads, &extract_keys, &round);
+
+	round.src = items;
+	round.dst = buf;
+	round.width = SORT_RUN;
+	par_for(DIV_ROUND_UP(nitems, SORT_RUN), 1U, nthreads, &sort_runs, &round);
+
+	for(; round.width < nitems; round.width *= 2U)
+	{
+		sort_item_t *const tmp = round.src;
+		par_for(DIV_ROUND_UP(nitems, 2U*round.width), 1U, nthreads, &merge_runs,
+				&round);
+		round.src = round.dst;
+		round.dst = tmp;
+	}
+
+	if(round.src != items)
+	{
+		memcpy(items, round.src, sizeof(*items)*nitems);
+	}
+	free(buf);
+}
+
+int
+sort_is_incremental(const FileView *view)
+{
+	int i;
+
+	if(view->sort[0] > SK_LAST || flist_custom_active(view))
+	{
+		return 0;
+	}
+
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		switch(abs(view->sort[i]))
+		{
+			/* Sizes and number of items of directories can change without changing
+			 * directories themselves. */
+			case SK_BY_SIZE:
+			case SK_BY_NITEMS:
+			/* Link targets aren't part of entries. */
+			case SK_BY_TARGET:
+			/* Grouping is too expensive to be done per comparison. */
+			case SK_BY_GROUPS:
+				return 0;
+		}
+	}
+	return 1;
+}
+
+int
+sort_needs_meta(const FileView *view)
+{
+	return sorting_needs_meta(view->sort);
+}
+
+int
+sort_compare_entries(const FileView *view, const dir_entry_t *a,
+		const dir_entry_t *b)
+{
+	int i;
+	int result = 0;
+	sort_item_t items[2] = { { .entry = a }, { .entry = b } };
+	sort_round_t round = { .items = items };
+	const sort_params_t params = {
+		.view = view,
+		.sort = view->sort,
+		.sort_groups = view->sort_groups,
+		.custom_view = flist_custom_active(view),
+	};
+
+	init_items(0U, 2U, &round);
+
+	/* Keys are compared in the reverse order of their application in
+	 * sort_sequence(), that is starting with the most significant one. */
+	if(!ui_view_sort_list_contains(params.sort, SK_BY_DIR))
+	{
+		result = compare_by_key(&params, items, SK_BY_DIR);
+	}
+	for(i = 0; i < SK_COUNT && result == 0; ++i)
+	{
+		if(abs(params.sort[i]) <= SK_LAST && params.sort[i] != SK_BY_GROUPS)
+		{
+			result = compare_by_key(&params, items, params.sort[i]);
+		}
+	}
+
+	for(i = 0; i < 2; ++i)
 	{
-		entries[i].tag = i;
+		free(items[i].name_buf);
+		free(items[i].str_buf);
+	}
+	return result;
+}
+
+/* Compares pair of items by a single key.  Returns positive value if first item
+ * is greater than the second one, zero if they are equal, otherwise negative
+ * value is returned. */
+static int
+compare_by_key(const sort_params_t *params, sort_item_t items[2], char key)
+{
+	sort_round_t round = {
+		.params = params,
+		.key = (SortingKey)abs(key),
+		.descending = (key < 0),
+	};
+
+	extract_key(&round, &items[0]);
+	extract_key(&round, &items[1]);
+	return compare_items(&round, &items[0], &items[1]);
+}
+
+/* Extracts keys of items in the [from; to) range.  Might be called in
+ * parallel. */
+static void
+extract_keys(size_t from, size_t to, void *arg)
+{
+	const sort_round_t *const round = arg;
+	size_t i;
+	for(i = from; i < to; ++i)
+	{
+		extract_key(round, &round->items[i]);
+	}
+}
+
+/* Fills item with data that corresponds to key of the current round. */
+static void
+extract_key(const sort_round_t *round, sort_item_t *item)
+{
+	const dir_entry_t *const entry = item->entry;
+
+	/* Name is used by several keys, so don't reset it unless it's different. */
+	if(round->key != SK_BY_NAME && round->key != SK_BY_INAME)
+	{
+		free(item->name_buf);
+		item->name_buf = NULL;
+		item->name = entry->name;
+	}
+
+	free(item->str_buf);
+	item->str_buf = NULL;
+	item->str = NULL;
+
+	switch(round->key)
+	{
+		char buf[PATH_MAX];
+		regmatch_t match;
+		uint64_t size;
+
+		case SK_BY_NAME:
+		case SK_BY_INAME:
+			if(round->params->custom_view && item->name_buf == NULL)
+			{
+				get_short_path_of(round->params->view, entry, 0, 0, sizeof(buf), buf);
+				item->name_buf = strdup(buf);
+				item->name = (item->name_buf == NULL) ? entry->name : item->name_buf;
+			}
+			if(round->key == SK_BY_INAME)
+			{
+				/* Ignore too small buffer errors by not caring about part that didn't
+				 * fit. */
+				(void)str_to_lower(item->name, buf, NAME_MAX);
+				item->str_buf = strdup(buf);
+				item->str = (item->str_buf == NULL) ? item->name : item->str_buf;
+			}
+			break;
+
+		case SK_BY_DIR:
+			break;
+
+		case SK_BY_TYPE:
+			item->str = get_type_str(entry->type);
+			break;
+
+		case SK_BY_FILEEXT:
+		case SK_BY_EXTENSION:
+			item->str = strrchr(entry->name, '.');
+			break;
+
+		case SK_BY_SIZE:
+			item->size = entry->size;
+			if(item->is_dir)
+			{
+				dcache_get_of(entry, &size, NULL);
+				if(size != DCACHE_UNKNOWN)
+				{
+					item->size = size;
+				}
+			}
+			break;
+
+		case SK_BY_NITEMS:
+			/* We don't want to call entry_get_nitems() for files as sorting huge
+			 * lists of files can call this function a lot of times, thus even small
+			 * extra performance overhead is not desirable. */
+			item->size = item->is_dir
+			           ? entry_get_nitems(round->params->view, entry)
+			           : 0U;
+			break;
+
+		case SK_BY_GROUPS:
+			match = get_group_match(round->regex, entry->name);
+			copy_str(buf, MIN(NAME_MAX, match.rm_eo - match.rm_so + 1U),
+					entry->name + match.rm_so);
+			item->str_buf = strdup(buf);
+			item->str = (item->str_buf == NULL) ? "" : item->str_buf;
+			break;
+
+		case SK_BY_TARGET:
+			if(entry->type == FT_LINK)
+			{
+				char full_path[PATH_MAX];
+				get_full_path_of(entry, sizeof(full_path), full_path);
+				if(get_link_target(full_path, buf, sizeof(buf)) == 0)
+				{
+					item->str_buf = strdup(buf);
+					item->str = item->str_buf;
+				}
+			}
+			break;
+
+		case SK_BY_TIME_MODIFIED:
+			item->num = entry->mtime;
+			break;
+
+		case SK_BY_TIME_ACCESSED:
+			item->num = entry->atime;
+			break;
+
+		case SK_BY_TIME_CHANGED:
+			item->num = entry->ctime;
+			break;
+
+#ifndef _WIN32
+		case SK_BY_MODE:
+			item->num = entry->mode;
+			break;
+
+		case SK_BY_OWNER_NAME: /* FIXME */
+		case SK_BY_OWNER_ID:
+			item->num = entry->uid;
+			break;
+
+		case SK_BY_GROUP_NAME: /* FIXME */
+		case SK_BY_GROUP_ID:
+			item->num = entry->gid;
+			break;
+
+		case SK_BY_PERMISSIONS:
+			get_perm_string(buf, 11, entry->mode);
+			item->str_buf = strdup(buf);
+			item->str = (item->str_buf == NULL) ? "" : item->str_buf;
+			break;
+
+		case SK_BY_NLINKS:
+			item->num = entry->nlinks;
+			break;
+#endif
 	}
+}
 
-	qsort(entries, nentries, sizeof(*entries), &sort_dir_list);
+/* Sorts runs of items with indexes in the [from; to) range with insertion sort.
+ * Might be called in parallel. */
+static void
+sort_runs(size_t from, size_t to, void *arg)
+{
+	const sort_round_t *const round = arg;
+	size_t run;
+	for(run = from; run < to; ++run)
+	{
+		sort_item_t *const items = round->items + run*round->width;
+		const size_t n = MIN(round->width, round->nitems - run*round->width);
+		size_t i;
+		for(i = 1U; i < n; ++i)
+		{
+			const sort_item_t item = items[i];
+			size_t j = i;
+			while(j > 0U && compare_items(round, &items[j - 1U], &item) > 0)
+			{
+				items[j] = items[j - 1U];
+				--j;
+			}
+			items[j] = item;
+		}
+	}
+}
+
+/* Merges pairs of adjacent runs with indexes in the [from; to) range from
+ * source to destination.  Might be called in parallel. */
+static void
+merge_runs(size_t from, size_t to, void *arg)
+{
+	const sort_round_t *const round = arg;
+	size_t pair;
+	for(pair = from; pair < to; ++pair)
+	{
+		const size_t lo = pair*2U*round->width;
+		const size_t mid = MIN(lo + round->width, round->nitems);
+		const size_t hi = MIN(mid + round->width, round->nitems);
+		size_t i = lo, j = mid, k = lo;
+
+		while(i < mid && j < hi)
+		{
+			/* Taking item from the left run on ties keeps sorting stable. */
+			if(compare_items(round, &round->src[j], &round->src[i]) < 0)
+			{
+				round->dst[k++] = round->src[j++];
+			}
+			else
+			{
+				round->dst[k++] = round->src[i++];
+			}
+		}
+		while(i < mid)
+		{
+			round->dst[k++] = round->src[i++];
+		}
+		while(j < hi)
+		{
+			round->dst[k++] = round->src[j++];
+		}
+	}
 }
 
 /* Compares file names containing numbers correctly. */
@@ -329,236 +770,145 @@ skip_leading_zeros(const char str[])
 }
 #endif
 
+/* Compares two items by key of the current round.  Returns positive value if a
+ * is greater than b, zero if they are equal, otherwise negative value is
+ * returned. */
 static int
-sort_dir_list(const void *one, const void *two)
+compare_items(const sort_round_t *round, const sort_item_t *a,
+		const sort_item_t *b)
 {
-	/* TODO: refactor this function sort_dir_list(). */
-
 	int retval;
-	const dir_entry_t *const first = one;
-	const dir_entry_t *const second = two;
-
-	const int first_is_dir = fentry_is_dir(first);
-	const int second_is_dir = fentry_is_dir(second);
 
-	if(first_is_dir && is_parent_dir(first->name))
+	if(a->is_parent)
 	{
 		return -1;
 	}
-	if(second_is_dir && is_parent_dir(second->name))
+	if(b->is_parent)
 	{
 		return 1;
 	}
 
 	retval = 0;
-	switch(sort_type)
+	switch(round->key)
 	{
-		char *pfirst, *psecond;
-
 		case SK_BY_NAME:
+			retval = compare_full_file_names(a->name, b->name);
+			break;
+
 		case SK_BY_INAME:
-			if(custom_view)
+			retval = compare_full_file_names(a->str, b->str);
+			if(retval == 0)
 			{
-				retval = compare_entry_names(first, second, sort_type == SK_BY_INAME);
-			}
-			else
-			{
-				retval = compare_full_file_names(first->name, second->name,
-						sort_type == SK_BY_INAME);
+				/* Resort to comparing original names when their normalized versions
+				 * match to always solve ties in deterministic way. */
+				retval = strcmp(a->name, b->name);
 			}
 			break;
 
 		case SK_BY_DIR:
-			if(first_is_dir != second_is_dir)
+			if(a->is_dir != b->is_dir)
 			{
-				retval = first_is_dir ? -1 : 1;
+				retval = a->is_dir ? -1 : 1;
 			}
 			break;
 
 		case SK_BY_TYPE:
-			retval = strcmp(get_type_str(first->type), get_type_str(second->type));
+		case SK_BY_GROUPS:
+#ifndef _WIN32
+		case SK_BY_PERMISSIONS:
+#endif
+			retval = strcmp(a->str, b->str);
 			break;
 
 		case SK_BY_FILEEXT:
 		case SK_BY_EXTENSION:
-			pfirst = strrchr(first->name,  '.');
-			psecond = strrchr(second->name, '.');
-
-			if(first_is_dir && second_is_dir && sort_type == SK_BY_FILEEXT)
-			{
-				retval = compare_file_names(first->name, second->name, 0);
-			}
-			else if(first_is_dir != second_is_dir && sort_type == SK_BY_FILEEXT)
-			{
-				retval = first_is_dir ? -1 : 1;
-			}
-			else if(pfirst && psecond)
-			{
-				if(pfirst == first->name && psecond != second->name)
-				{
-					retval = -1;
-				}
-				else if(pfirst != first->name && psecond == second->name)
-				{
-					retval = 1;
-				}
-				else
-				{
-					retval = compare_file_names(++pfirst, ++psecond, 0);
-				}
-			}
-			else if(pfirst || psecond)
-				retval = pfirst ? -1 : 1;
-			else
-				retval = compare_file_names(first->name, second->name, 0);
+			retval = compare_extensions(round, a, b);
 			break;
 
 		case SK_BY_SIZE:
-			retval = compare_file_sizes(first, first_is_dir, second, second_is_dir);
-			break;
-
 		case SK_BY_NITEMS:
-			retval = compare_item_count(first, first_is_dir, second, second_is_dir);
-			break;
-
-		case SK_BY_GROUPS:
-			retval = compare_group(first->name, second->name, sort_data);
+			retval = (a->size < b->size) ? -1 : (a->size > b->size);
 			break;
 
 		case SK_BY_TARGET:
-			retval = compare_targets(first, second);
+			retval = compare_targets(a, b);
 			break;
 
 		case SK_BY_TIME_MODIFIED:
-			retval = first->mtime - second->mtime;
-			break;
-
 		case SK_BY_TIME_ACCESSED:
-			retval = first->atime - second->atime;
-			break;
-
 		case SK_BY_TIME_CHANGED:
-			retval = first->ctime - second->ctime;
-			break;
-
 #ifndef _WIN32
 		case SK_BY_MODE:
-			retval = first->mode - second->mode;
-			break;
-
-		case SK_BY_OWNER_NAME: /* FIXME */
+		case SK_BY_OWNER_NAME:
 		case SK_BY_OWNER_ID:
-			retval = first->uid - second->uid;
-			break;
-
-		case SK_BY_GROUP_NAME: /* FIXME */
+		case SK_BY_GROUP_NAME:
 		case SK_BY_GROUP_ID:
-			retval = first->gid - second->gid;
-			break;
-
-		case SK_BY_PERMISSIONS:
-			{
-				char first_perm[11], second_perm[11];
-				get_perm_string(first_perm, sizeof(first_perm), first->mode);
-				get_perm_string(second_perm, sizeof(second_perm), second->mode);
-				retval = strcmp(first_perm, second_perm);
-			}
-			break;
-
 		case SK_BY_NLINKS:
-			retval = first->nlinks - second->nlinks;
-			break;
 #endif
+			retval = (a->num < b->num) ? -1 : (a->num > b->num);
+			break;
 	}
 
-	if(retval == 0)
-	{
-		retval = first->tag - second->tag;
-	}
-	else if(sort_descending)
-	{
-		retval = -retval;
-	}
-
-	return retval;
+	return round->descending ? -retval : retval;
 }
 
-/* Compares two file sizes.  Returns standard -1, 0, 1 for comparisons. */
+/* Compares two items by extensions of their names.  Returns positive value if
+ * a is greater than b, zero if they are equal, otherwise negative value is
+ * returned. */
 static int
-compare_file_sizes(const dir_entry_t *f, int fdir, const dir_entry_t *s,
-		int sdir)
+compare_extensions(const sort_round_t *round, const sort_item_t *a,
+		const sort_item_t *b)
 {
-	uint64_t fsize = f->size;
-	uint64_t ssize = s->size;
+	const char *const aname = a->entry->name;
+	const char *const bname = b->entry->name;
+	const char *aext = a->str;
+	const char *bext = b->str;
 
-	if(fdir)
+	if(round->key == SK_BY_FILEEXT)
 	{
-		uint64_t size;
-		dcache_get_of(f, &size, NULL);
-		if(size != DCACHE_UNKNOWN)
+		if(a->is_dir && b->is_dir)
+		{
+			return compare_file_names(aname, bname);
+		}
+		if(a->is_dir != b->is_dir)
 		{
-			fsize = size;
+			return a->is_dir ? -1 : 1;
 		}
 	}
 
-	if(sdir)
+	if(aext != NULL && bext != NULL)
 	{
-		uint64_t size;
-		dcache_get_of(s, &size, NULL);
-		if(size != DCACHE_UNKNOWN)
+		if(aext == aname && bext != bname)
 		{
-			ssize = size;
+			return -1;
 		}
+		if(aext != aname && bext == bname)
+		{
+			return 1;
+		}
+		return compare_file_names(aext + 1, bext + 1);
 	}
-
-	return (fsize < ssize) ? -1 : (fsize > ssize);
-}
-
-/* Compares number of items in two directories (taken as zero for files).
- * Returns standard -1, 0, 1 for comparisons. */
-static int
-compare_item_count(const dir_entry_t *f, int fdir, const dir_entry_t *s,
-		int sdir)
-{
-	/* We don't want to call entry_get_nitems() for files as sorting huge lists
-	 * of files can call this function a lot of times, thus even small extra
-	 * performance overhead is not desirable. */
-	const uint64_t fsize = fdir ? entry_get_nitems(view, f) : 0U;
-	const uint64_t ssize = sdir ? entry_get_nitems(view, s) : 0U;
-	return (fsize > ssize) ? 1 : (fsize < ssize) ? -1 : 0;
-}
-
-/* Compares two file names according to grouping regular expression.  Returns
- * standard -1, 0, 1 for comparisons. */
-static int
-compare_group(const char f[], const char s[], regex_t *regex)
-{
-	char fname[NAME_MAX], sname[NAME_MAX];
-	regmatch_t fmatch = get_group_match(regex, f);
-	regmatch_t smatch = get_group_match(regex, s);
-
-	copy_str(fname, MIN(sizeof(fname), fmatch.rm_eo - fmatch.rm_so + 1U),
-			f + fmatch.rm_so);
-	copy_str(sname, MIN(sizeof(sname), smatch.rm_eo - smatch.rm_so + 1U),
-			s + smatch.rm_so);
-
-	return strcmp(fname, sname);
+	if(aext != NULL || bext != NULL)
+	{
+		return (aext != NULL) ? -1 : 1;
+	}
+	return compare_file_names(aname, bname);
 }
 
-/* Compares two file names according to symbolic link target.  Returns standard
- * -1, 0, 1 for comparisons. */
+/* Compares two items according to symbolic link target.  Returns standard -1,
+ * 0, 1 for comparisons. */
 static int
-compare_targets(const dir_entry_t *f, const dir_entry_t *s)
+compare_targets(const sort_item_t *a, const sort_item_t *b)
 {
-	char full_path[PATH_MAX];
-	char nlink[PATH_MAX], plink[PATH_MAX];
+	const int a_link = (a->entry->type == FT_LINK);
+	const int b_link = (b->entry->type == FT_LINK);
 
-	if((f->type == FT_LINK) != (s->type == FT_LINK))
+	if(a_link != b_link)
 	{
 		/* One of the entries is not a link. */
-		return (f->type == FT_LINK) ? 1 : -1;
+		return a_link ? 1 : -1;
 	}
-	if(f->type != FT_LINK)
+	if(!a_link)
 	{
 		/* Both entries are not symbolic links. */
 		return 0;
@@ -566,39 +916,20 @@ compare_targets(const dir_entry_t *f, const dir_entry_t *s)
 
 	/* Both entries are symbolic links. */
 
-	get_full_path_of(f, sizeof(full_path), full_path);
-	if(get_link_target(full_path, nlink, sizeof(nlink)) != 0)
+	if(a->str == NULL || b->str == NULL)
 	{
+		/* Failed to read target of at least one of them. */
 		return 0;
 	}
-	get_full_path_of(s, sizeof(full_path), full_path);
-	if(get_link_target(full_path, plink, sizeof(plink)) != 0)
-	{
-		return 0;
-	}
-
-	return stroscmp(nlink, plink);
-}
-
-/* Compares names of two file entries.  Returns positive value if a is greater
- * than b, zero if they are equal, otherwise negative value is returned. */
-static int
-compare_entry_names(const dir_entry_t *a, const dir_entry_t *b, int ignore_case)
-{
-	char a_short_path[PATH_MAX];
-	char b_short_path[PATH_MAX];
 
-	get_short_path_of(view, a, 0, 0, sizeof(a_short_path), a_short_path);
-	get_short_path_of(view, b, 0, 0, sizeof(b_short_path), b_short_path);
-
-	return compare_full_file_names(a_short_path, b_short_path, ignore_case);
+	return stroscmp(a->str, b->str);
 }
 
 /* Compares two full filenames and assumes that dot character is smaller than
  * any other character.  Returns positive value if s is greater than t, zero if
  * they are equal, otherwise negative value is returned. */
 static int
-compare_full_file_names(const char s[], const char t[], int ignore_case)
+compare_full_file_names(const char s[], const char t[])
 {
 	if(s[0] == '.' && t[0] != '.')
 	{
@@ -610,7 +941,7 @@ compare_full_file_names(const char s[], const char t[], int ignore_case)
 	}
 	else
 	{
-		return compare_file_names(s, t, ignore_case);
+		return compare_file_names(s, t);
 	}
 }
 
@@ -618,32 +949,9 @@ compare_full_file_names(const char s[], const char t[], int ignore_case)
  * value if s is greater than t, zero if they are equal, otherwise negative
  * value is returned. */
 static int
-compare_file_names(const char s[], const char t[], int ignore_case)
+compare_file_names(const char s[], const char t[])
 {
-	const char *s_val = s, *t_val = t;
-	char s_buf[NAME_MAX];
-	char t_buf[NAME_MAX];
-	int result;
-
-	if(ignore_case)
-	{
-		/* Ignore too small buffer errors by not caring about part that didn't
-		 * fit. */
-		(void)str_to_lower(s, s_buf, sizeof(s_buf));
-		(void)str_to_lower(t, t_buf, sizeof(t_buf));
-
-		s_val = s_buf;
-		t_val = t_buf;
-	}
-
-	result = cfg.sort_numbers ? strnumcmp(s_val, t_val) : strcmp(s_val, t_val);
-	if(result == 0 && ignore_case)
-	{
-		/* Resort to comparing original names when their normalized versions match
-		 * to always solve ties in deterministic way. */
-		result = strcmp(s, t);
-	}
-	return result;
+	return cfg.sort_numbers ? strnumcmp(s, t) : strcmp(s, t);
 }
 
 SortingKey
@@ -680,5 +988,32 @@ get_secondary_key(SortingKey primary_key)
 	return SK_BY_SIZE;
 }
 
+/* Checks whether sorting by specified keys requires more than names and types
+ * of files.  Returns non-zero if so, otherwise zero is returned. */
+static int
+sorting_needs_meta(const char sort[])
+{
+	int i;
+	for(i = 0; i < SK_COUNT && abs(sort[i]) <= SK_LAST; ++i)
+	{
+		switch(abs(sort[i]))
+		{
+			case SK_BY_EXTENSION:
+			case SK_BY_NAME:
+			case SK_BY_INAME:
+			case SK_BY_DIR:
+			case SK_BY_FILEEXT:
+			case SK_BY_GROUPS:
+			case SK_BY_TARGET:
+				break;
+
+			default:
+				/* SK_BY_TYPE is here, because FT_EXEC type needs file mode. */
+				return 1;
+		}
+	}
+	return 0;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
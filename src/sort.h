@@ -29,6 +29,23 @@ void sort_view(FileView *view);
 /* Sorts specified entries using global settings of the view. */
 void sort_entries(FileView *view, entries_t entries);
 
+/* Checks whether sorted list of the view can be kept sorted by inserting new
+ * entries at positions found by sort_compare_entries() instead of resorting
+ * the whole list.  This isn't the case when sorting depends on something other
+ * than entries themselves.  Returns non-zero if so, otherwise zero is
+ * returned. */
+int sort_is_incremental(const FileView *view);
+
+/* Checks whether sorting of the view needs more than names and types of
+ * files.  Returns non-zero if so, otherwise zero is returned. */
+int sort_needs_meta(const FileView *view);
+
+/* Compares two entries of the view according to its sorting configuration
+ * (grouping is not supported).  Returns positive value if a goes after b, zero
+ * if they are equivalent, otherwise negative value is returned. */
+int sort_compare_entries(const FileView *view, const dir_entry_t *a,
+		const dir_entry_t *b);
+
 /* Maps primary sort key to second column type.  Returns secondary key that
  * corresponds to the primary one. */
 SortingKey get_secondary_key(SortingKey primary_key);
@@ -26,6 +26,8 @@
 #undef MIN
 #endif
 
+#include <sys/stat.h> /* stat */
+
 #include <assert.h> /* assert() */
 #include <limits.h> /* INT_MIN */
 #include <stddef.h> /* NULL */
@@ -34,6 +36,7 @@
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
+#include "compat/os.h"
 #include "compat/pthread.h"
 #include "ui/colors.h"
 #include "ui/ui.h"
@@ -344,8 +347,22 @@ void
 dcache_get_of(const dir_entry_t *entry, uint64_t *size, uint64_t *nitems)
 {
 	char full_path[PATH_MAX];
+	time_t mtime = entry->mtime;
+
 	get_full_path_of(entry, sizeof(full_path), full_path);
-	dcache_get(full_path, size, nitems, entry->mtime);
+
+	/* Modification time of the entry might not be loaded yet, without it cached
+	 * data would be reported as up-to-date. */
+	if(entry->no_meta)
+	{
+		struct stat st;
+		if(os_lstat(full_path, &st) == 0)
+		{
+			mtime = st.st_mtime;
+		}
+	}
+
+	dcache_get(full_path, size, nitems, mtime);
 }
 
 /* Retrieves information about the path if data is newer than ts (0 requests to
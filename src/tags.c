@@ -68,6 +68,7 @@ const char *tags[] = {
 	"vifm-'ignorecase'",
 	"vifm-'incsearch'",
 	"vifm-'iooptions'",
+	"vifm-'iothreads'",
 	"vifm-'is'",
 	"vifm-'laststatus'",
 	"vifm-'lines'",
@@ -572,6 +573,7 @@ const char *tags[] = {
 	"vifm-gv",
 	"vifm-h",
 	"vifm-has()",
+	"vifm-hashcache",
 	"vifm-i",
 	"vifm-j",
 	"vifm-k",
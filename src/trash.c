@@ -286,8 +286,8 @@ empty_trash_dir(const char trash_dir[])
 
 	char *const trash_dir_copy = strdup(trash_dir);
 
-	if(bg_execute(task_desc, op_desc, BG_UNDEFINED_TOTAL, 1, &empty_trash_in_bg,
-			trash_dir_copy) != 0)
+	if(bg_execute(task_desc, op_desc, BG_UNDEFINED_TOTAL, 1, trash_dir,
+			&empty_trash_in_bg, trash_dir_copy) != 0)
 	{
 		free(trash_dir_copy);
 	}
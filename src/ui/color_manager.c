@@ -19,7 +19,8 @@
 #include "color_manager.h"
 
 #include <assert.h> /* assert() */
-#include <stddef.h> /* NULL */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() */
 
 #include "../utils/macros.h"
 #include "colors.h"
@@ -27,10 +28,29 @@
 /* Number of color pairs preallocated by curses library. */
 #define PREALLOCATED_COUNT 1
 
+/* Initial number of slots in the index of pairs, must be a power of two. */
+#define INITIAL_INDEX_SIZE 64U
+
+/* Slot of index of allocated pairs. */
+typedef struct
+{
+	int fg;   /* Foreground color. */
+	int bg;   /* Background color. */
+	int pair; /* Pair number or zero for an empty slot. */
+}
+index_slot_t;
+
 static int find_pair(int fg, int bg);
 static int color_pair_matches(int pair, int fg, int bg);
 static int allocate_pair(int fg, int bg);
 static int compress_pair_space(void);
+static void index_clear(void);
+static void index_rebuild(void);
+static void index_add(int pair, int fg, int bg);
+static int index_grow(void);
+static void index_insert(index_slot_t slots[], size_t size, int pair, int fg,
+		int bg);
+static size_t hash_colors(int fg, int bg);
 
 /* Number of color pairs available. */
 static int avail_pairs;
@@ -41,6 +61,15 @@ static int used_pairs;
 /* Configuration data passed in during initialization. */
 static colmgr_conf_t conf;
 
+/* Hash table that maps pairs of colors to allocated pair numbers to avoid
+ * querying every pair on lookup.  NULL if there is not enough memory, in which
+ * case pairs are searched sequentially. */
+static index_slot_t *index_slots;
+/* Number of slots in the index (zero or power of two). */
+static size_t index_size;
+/* Number of used slots in the index. */
+static size_t index_count;
+
 void
 colmgr_init(const colmgr_conf_t *conf_init)
 {
@@ -60,6 +89,8 @@ colmgr_reset(void)
 {
 	used_pairs = PREALLOCATED_COUNT;
 	avail_pairs = conf.max_color_pairs - used_pairs;
+
+	index_clear();
 }
 
 int
@@ -94,6 +125,21 @@ find_pair(int fg, int bg)
 {
 	int i;
 
+	if(index_slots != NULL)
+	{
+		size_t slot = hash_colors(fg, bg) & (index_size - 1U);
+		while(index_slots[slot].pair != 0)
+		{
+			const index_slot_t *const entry = &index_slots[slot];
+			if(entry->fg == fg && entry->bg == bg)
+			{
+				return entry->pair;
+			}
+			slot = (slot + 1U) & (index_size - 1U);
+		}
+		return -1;
+	}
+
 	for(i = PREALLOCATED_COUNT; i < used_pairs; ++i)
 	{
 		if(color_pair_matches(i, fg, bg))
@@ -129,6 +175,7 @@ allocate_pair(int fg, int bg)
 	}
 
 	conf.init_pair(used_pairs, fg, bg);
+	index_add(used_pairs, fg, bg);
 
 	--avail_pairs;
 	return used_pairs++;
@@ -186,8 +233,115 @@ compress_pair_space(void)
 	used_pairs = j;
 	avail_pairs = conf.max_color_pairs - used_pairs;
 
+	/* Pairs were moved around, so positions in the index are no longer valid. */
+	index_rebuild();
+
+	return 0;
+}
+
+/* Empties the index of pairs. */
+static void
+index_clear(void)
+{
+	free(index_slots);
+	index_slots = calloc(INITIAL_INDEX_SIZE, sizeof(*index_slots));
+	index_size = (index_slots == NULL) ? 0U : INITIAL_INDEX_SIZE;
+	index_count = 0U;
+}
+
+/* Fills index of pairs anew from current contents of pairs. */
+static void
+index_rebuild(void)
+{
+	int i;
+
+	index_clear();
+
+	for(i = PREALLOCATED_COUNT; i < used_pairs; ++i)
+	{
+		short fg, bg;
+		conf.pair_content(i, &fg, &bg);
+		index_add(i, fg, bg);
+	}
+}
+
+/* Records newly allocated pair in the index.  On failure to grow the index
+ * switches to sequential search. */
+static void
+index_add(int pair, int fg, int bg)
+{
+	if(index_slots == NULL)
+	{
+		return;
+	}
+
+	/* Keep load factor of the table below one half. */
+	if((index_count + 1U)*2U > index_size && index_grow() != 0)
+	{
+		free(index_slots);
+		index_slots = NULL;
+		index_size = 0U;
+		index_count = 0U;
+		return;
+	}
+
+	index_insert(index_slots, index_size, pair, fg, bg);
+	++index_count;
+}
+
+/* Doubles size of the index of pairs.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+index_grow(void)
+{
+	size_t i;
+	const size_t new_size = index_size*2U;
+	index_slot_t *const new_slots = calloc(new_size, sizeof(*new_slots));
+	if(new_slots == NULL)
+	{
+		return 1;
+	}
+
+	for(i = 0U; i < index_size; ++i)
+	{
+		const index_slot_t *const entry = &index_slots[i];
+		if(entry->pair != 0)
+		{
+			index_insert(new_slots, new_size, entry->pair, entry->fg, entry->bg);
+		}
+	}
+
+	free(index_slots);
+	index_slots = new_slots;
+	index_size = new_size;
 	return 0;
 }
 
+/* Puts pair into the first free slot of the table starting from the one that
+ * corresponds to its colors. */
+static void
+index_insert(index_slot_t slots[], size_t size, int pair, int fg, int bg)
+{
+	size_t slot = hash_colors(fg, bg) & (size - 1U);
+	while(slots[slot].pair != 0)
+	{
+		slot = (slot + 1U) & (size - 1U);
+	}
+
+	slots[slot].fg = fg;
+	slots[slot].bg = bg;
+	slots[slot].pair = pair;
+}
+
+/* Computes hash of a pair of colors.  Returns the hash. */
+static size_t
+hash_colors(int fg, int bg)
+{
+	unsigned int hash = (unsigned int)(fg + 1)*0x9e3779b1U
+	                  ^ (unsigned int)(bg + 1)*0x85ebca77U;
+	hash ^= hash >> 15;
+	return hash;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -24,6 +24,7 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* intptr_t */
 #include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* free() */
 #include <string.h> /* strcpy() strlen() */
@@ -38,8 +39,10 @@
 #include "../utils/fsddata.h"
 #include "../utils/macros.h"
 #include "../utils/matchers.h"
+#include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
+#include "../utils/trie.h"
 #include "../utils/utils.h"
 #include "../status.h"
 #include "color_manager.h"
@@ -398,6 +401,11 @@ static void restore_primary_cs(const col_scheme_t *cs);
 static void reset_to_default_cs(col_scheme_t *cs);
 static void free_cs_highlights(col_scheme_t *cs);
 static file_hi_t * clone_cs_highlights(const col_scheme_t *from);
+static unsigned int next_file_hi_gen(void);
+static int index_file_hi(col_scheme_t *cs, int idx);
+static int find_file_hi_by_ext(const col_scheme_t *cs, const char fname[],
+		int first);
+static void ascii_to_lower(char str[]);
 static void reset_cs_colors(col_scheme_t *cs);
 static int source_cs(const char name[]);
 static void get_cs_path(const char name[], char buf[], size_t buf_size);
@@ -409,6 +417,9 @@ static void ensure_dir_map_exists(void);
 /* Mapping of color schemes associations onto file system tree. */
 static fsddata_t *dir_map;
 
+/* Last value of file_hi_gen field of color schemes. */
+static unsigned int last_file_hi_gen;
+
 int
 cs_have_no_extensions(void)
 {
@@ -674,6 +685,7 @@ restore_primary_cs(const col_scheme_t *cs)
 {
 	free_cs_highlights(&cfg.cs);
 	cfg.cs = *cs;
+	cfg.cs.file_hi_gen = next_file_hi_gen();
 	cs_load_pairs();
 	update_screen(UT_FULL);
 }
@@ -733,6 +745,17 @@ cs_assign(col_scheme_t *to, const col_scheme_t *from)
 	free_cs_highlights(to);
 	*to = *from;
 	to->file_hi = clone_cs_highlights(from);
+	to->file_hi_gen = next_file_hi_gen();
+
+	to->file_hi_exts = trie_clone(from->file_hi_exts);
+	if(to->file_hi_exts == NULL)
+	{
+		int i;
+		for(i = 0; i < to->file_hi_count; ++i)
+		{
+			to->file_hi[i].by_ext = 0;
+		}
+	}
 }
 
 /* Resets color scheme to default builtin values. */
@@ -759,9 +782,12 @@ free_cs_highlights(col_scheme_t *cs)
 	}
 
 	free(cs->file_hi);
+	trie_free(cs->file_hi_exts);
 
 	cs->file_hi = NULL;
 	cs->file_hi_count = 0;
+	cs->file_hi_exts = NULL;
+	cs->file_hi_gen = next_file_hi_gen();
 }
 
 /* Clones filename specific highlight array of the *from color scheme and
@@ -778,11 +804,20 @@ clone_cs_highlights(const col_scheme_t *from)
 		const file_hi_t *const hi = &from->file_hi[i];
 		file_hi[i].matchers = matchers_clone(hi->matchers);
 		file_hi[i].hi = hi->hi;
+		file_hi[i].by_ext = hi->by_ext;
 	}
 
 	return file_hi;
 }
 
+/* Generates value for file_hi_gen field of a color scheme that differs from all
+ * previous ones.  Returns the value. */
+static unsigned int
+next_file_hi_gen(void)
+{
+	return ++last_file_hi_gen;
+}
+
 int
 cs_load_local(int left, const char dir[])
 {
@@ -1018,34 +1053,173 @@ cs_add_file_hi(struct matchers_t *matchers, const col_attr_t *hi)
 
 	file_hi->matchers = matchers;
 	file_hi->hi = *hi;
+	file_hi->by_ext = (index_file_hi(cs, cs->file_hi_count) == 0);
 
 	++cs->file_hi_count;
 
 	return 0;
 }
 
+/* Adds extensions of highlight at specified index to the index of extensions
+ * of the color scheme.  Returns zero if the highlight can be looked up via the
+ * index, otherwise non-zero is returned. */
+static int
+index_file_hi(col_scheme_t *cs, int idx)
+{
+	int i;
+	int count;
+	int error = 0;
+	char **const exts = matchers_get_exts(cs->file_hi[idx].matchers, &count);
+
+	if(exts == NULL)
+	{
+		return 1;
+	}
+
+	if(cs->file_hi_exts == NULL)
+	{
+		cs->file_hi_exts = trie_create();
+	}
+
+	for(i = 0; i < count && cs->file_hi_exts != NULL && !error; ++i)
+	{
+		void *data;
+
+		ascii_to_lower(exts[i]);
+
+		/* Earlier highlight takes precedence. */
+		if(trie_get(cs->file_hi_exts, exts[i], &data) != 0)
+		{
+			data = (void *)(intptr_t)(idx + 1);
+			error = (trie_set(cs->file_hi_exts, exts[i], data) < 0);
+		}
+	}
+
+	free_string_array(exts, count);
+	return (cs->file_hi_exts == NULL || error);
+}
+
 const col_attr_t *
 cs_get_file_hi(const col_scheme_t *cs, const char fname[], int *hi_hint)
 {
 	int i;
+	int found;
+	int use_index = 1;
+	int first = 0;
 
-	if(*hi_hint != -1)
+	if(*hi_hint >= 0)
 	{
-		assert(*hi_hint >= 0 && "Wrong index.");
 		assert(*hi_hint < cs->file_hi_count && "Wrong index.");
 		return &cs->file_hi[*hi_hint].hi;
 	}
 
-	for(i = 0; i < cs->file_hi_count; ++i)
+	/* Values below -1 specify number of highlights that didn't match.  New
+	 * highlights are only appended, so only they need to be checked. */
+	if(*hi_hint < -1)
+	{
+		first = -2 - *hi_hint;
+		if(first == cs->file_hi_count)
+		{
+			return NULL;
+		}
+		if(first > cs->file_hi_count)
+		{
+			first = 0;
+		}
+	}
+
+	found = find_file_hi_by_ext(cs, fname, first);
+	if(found < 0)
+	{
+		use_index = 0;
+		found = cs->file_hi_count;
+	}
+
+	for(i = first; i < found; ++i)
 	{
 		const file_hi_t *const file_hi = &cs->file_hi[i];
-		if(matchers_match(file_hi->matchers, fname))
+		if((!file_hi->by_ext || !use_index) &&
+				matchers_match(file_hi->matchers, fname))
+		{
+			found = i;
+			break;
+		}
+	}
+
+	if(found == cs->file_hi_count)
+	{
+		*hi_hint = -2 - cs->file_hi_count;
+		return NULL;
+	}
+
+	*hi_hint = found;
+	return &cs->file_hi[found].hi;
+}
+
+int
+cs_file_hi_is_cached(const col_scheme_t *cs, int hi_hint)
+{
+	return hi_hint >= 0 || hi_hint == -2 - cs->file_hi_count;
+}
+
+/* Looks up the first highlight not earlier than the specified one that matches
+ * file name via the index of extensions.  Returns index of the highlight,
+ * number of highlights if there is no match or -1 if the index can't be used
+ * for this name. */
+static int
+find_file_hi_by_ext(const col_scheme_t *cs, const char fname[], int first)
+{
+	char name[NAME_MAX + 2];
+	size_t i;
+	int found = cs->file_hi_count;
+
+	if(cs->file_hi_exts == NULL)
+	{
+		return found;
+	}
+
+	if(copy_str(name, sizeof(name), get_last_path_component(fname)) ==
+			sizeof(name))
+	{
+		return -1;
+	}
+
+	/* Such globs don't match names that start with a dot. */
+	if(name[0] == '.')
+	{
+		return found;
+	}
+
+	ascii_to_lower(name);
+
+	/* Try every suffix that starts with a dot except for the whole name. */
+	for(i = 1U; name[i] != '\0'; ++i)
+	{
+		void *data;
+		if(name[i] == '.' && trie_get(cs->file_hi_exts, &name[i], &data) == 0)
+		{
+			const int idx = (intptr_t)data - 1;
+			if(idx >= first && idx < found)
+			{
+				found = idx;
+			}
+		}
+	}
+
+	return found;
+}
+
+/* Converts ASCII letters of the string to lower case in place. */
+static void
+ascii_to_lower(char str[])
+{
+	for(; *str != '\0'; ++str)
+	{
+		if(*str >= 'A' && *str <= 'Z')
 		{
-			*hi_hint = i;
-			return &file_hi->hi;
+			*str += 'a' - 'A';
 		}
 	}
-	return NULL;
 }
 
 int
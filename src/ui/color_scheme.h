@@ -41,12 +41,15 @@ typedef enum
 ColorSchemeState;
 
 struct matchers_t;
+struct trie_t;
 
 /* Single file highlight description. */
 typedef struct
 {
 	struct matchers_t *matchers; /* Name matcher object. */
 	col_attr_t hi;               /* File appearance parameters. */
+	int by_ext;                  /* Whether the highlight is looked up via index
+	                                of extensions instead of the matchers. */
 }
 file_hi_t;
 
@@ -61,6 +64,11 @@ typedef struct
 
 	file_hi_t *file_hi; /* List of file highlight preferences. */
 	int file_hi_count;  /* Number of file highlight definitions. */
+	struct trie_t *file_hi_exts; /* Maps lower case extensions of highlights
+	                                like "*.ext" to index of the first such
+	                                highlight plus one. */
+	unsigned int file_hi_gen;    /* Changes when list of highlights is replaced
+	                                instead of being appended to. */
 }
 col_scheme_t;
 
@@ -140,11 +148,17 @@ void cs_mix_colors(col_attr_t *base, const col_attr_t *mixup);
 int cs_add_file_hi(struct matchers_t *matchers, const col_attr_t *hi);
 
 /* Gets filename-specific highlight.  hi_hint can't be NULL and should be equal
- * to -1 initially.  Returns NULL if nothing is found, otherwise returns pointer
- * to one of color scheme's highlights. */
+ * to -1 initially, it caches result of the lookup including its failure.
+ * Returns NULL if nothing is found, otherwise returns pointer to one of color
+ * scheme's highlights. */
 const col_attr_t * cs_get_file_hi(const col_scheme_t *cs, const char fname[],
 		int *hi_hint);
 
+/* Checks whether hint filled by cs_get_file_hi() fully determines result of its
+ * next invocation, in which case fname argument isn't used and can be NULL.
+ * Returns non-zero if so, otherwise zero is returned. */
+int cs_file_hi_is_cached(const col_scheme_t *cs, int hi_hint);
+
 /* Checks that color is non-empty (i.e. has at least one property set).  Returns
  * non-zero if so, otherwise zero is returned. */
 int cs_is_color_set(const col_attr_t *color);
@@ -30,8 +30,8 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
-#include <stdlib.h> /* abs() */
-#include <string.h> /* strcpy() strlen() */
+#include <stdlib.h> /* abs() calloc() free() realloc() */
+#include <string.h> /* memcmp() memcpy() strcat() strcpy() strlen() */
 
 #include "../cfg/config.h"
 #include "../utils/fs.h"
@@ -69,14 +69,66 @@ typedef struct
 	size_t *prefix_len; /* Data prefix length (should be drawn in neutral color).
 	                     * A pointer to allow changing value in const struct.
 	                     * Should be zero first time, then auto reset. */
+
+	struct frame_row_t *row; /* Row to record drawing into or NULL to draw
+	                          * directly in the window. */
 }
 column_data_t;
 
+/* Header of a single print operation recorded for a row.  It's followed by the
+ * printed text including its terminating null character. */
+typedef struct
+{
+	int column; /* Column of the window at which the text starts. */
+	int attrs;  /* Attributes of the text. */
+	size_t len; /* Length of the text. */
+}
+print_op_t;
+
+/* Single row of a window in the form of recorded print operations. */
+typedef struct frame_row_t
+{
+	char *ops;  /* Sequence of print operations. */
+	size_t len; /* Number of used bytes of ops. */
+	size_t cap; /* Number of allocated bytes of ops. */
+	int cells;  /* Number of file list cells drawn on the row. */
+	int dirty;  /* Whether row was drawn over outside of full redraw. */
+	int failed; /* Whether recording has failed due to lack of memory. */
+}
+frame_row_t;
+
+/* Contents of a window of a view in the form of rows. */
+typedef struct frame_t
+{
+	frame_row_t *rows; /* Rows as they are drawn in the window. */
+	frame_row_t *next; /* Rows that are being composed by current redraw. */
+	int height;        /* Number of elements in both arrays. */
+	int width;         /* Width of the window for which rows were drawn. */
+	int bg;            /* Background of the window for which rows were drawn. */
+	int valid;         /* Whether rows match what's drawn in the window. */
+	size_t repainted;  /* Number of cells repainted since creation of the view. */
+}
+frame_t;
+
+static size_t draw_cells(FileView *view, int top, size_t col_count,
+		size_t col_width, frame_t *frame);
+static void sync_hi_hints(FileView *view);
+static frame_t * prepare_frame(FileView *view);
+static int get_window_bg(const FileView *view);
+static int commit_frame(FileView *view, frame_t *frame);
+static void replay_row(WINDOW *win, int line, const frame_row_t *row);
+static void free_rows(frame_row_t rows[], int count);
+static void touch_row(const FileView *view, int line);
+static void print_at(const column_data_t *cdt, int column, const char text[],
+		int attrs);
+static void record_print(frame_row_t *row, int column, const char text[],
+		int attrs);
 static void calculate_table_conf(FileView *view, size_t *count, size_t *width);
 static void calculate_number_width(FileView *view);
 static int count_digits(int num);
 static int calculate_top_position(FileView *view, int top);
 static int get_line_color(const FileView *view, int pos);
+static int is_broken_link(const FileView *view, int pos);
 static size_t calculate_print_width(const FileView *view, int i,
 		size_t max_width);
 static void draw_cell(const FileView *view, const column_data_t *cdt,
@@ -91,9 +143,9 @@ static size_t get_effective_scroll_offset(const FileView *view);
 static void column_line_print(const void *data, int column_id, const char buf[],
 		size_t offset, AlignType align, const char full_column[]);
 static void draw_line_number(const column_data_t *cdt, int column);
-static void highlight_search(FileView *view, dir_entry_t *entry,
+static void highlight_search(const column_data_t *cdt, dir_entry_t *entry,
 		const char full_column[], char buf[], size_t buf_len, AlignType align,
-		int line, int col, int line_attrs);
+		int col, int line_attrs);
 static int prepare_col_color(const FileView *view, dir_entry_t *entry,
 		int primary, int line_color, int current);
 static void mix_in_file_hi(const FileView *view, dir_entry_t *entry,
@@ -210,6 +262,21 @@ fview_view_reset(FileView *view)
 	pthread_mutex_unlock(view->timestamps_mutex);
 }
 
+void
+fview_view_free_frame(FileView *view)
+{
+	frame_t *const frame = view->frame;
+	if(frame == NULL)
+	{
+		return;
+	}
+
+	free_rows(frame->rows, frame->height);
+	free_rows(frame->next, frame->height);
+	free(frame);
+	view->frame = NULL;
+}
+
 void
 fview_view_cs_reset(FileView *view)
 {
@@ -218,6 +285,9 @@ fview_view_cs_reset(FileView *view)
 	{
 		view->dir_entry[i].hi_num = -1;
 	}
+
+	/* Color pairs might be reused for different colors. */
+	fview_invalidate(view);
 }
 
 void
@@ -234,11 +304,9 @@ draw_dir_list(FileView *view)
 void
 draw_dir_list_only(FileView *view)
 {
-	int x;
-	size_t cell;
 	size_t col_width;
 	size_t col_count;
-	int coll_pad;
+	frame_t *frame;
 	int top = view->top_line;
 
 	if(curr_stats.load_stage < 2)
@@ -268,43 +336,308 @@ draw_dir_list_only(FileView *view)
 
 	top = calculate_top_position(view, top);
 
-	ui_view_erase(view);
+	sync_hi_hints(view);
+
+	/* Cells are composed off-screen first to repaint only rows that differ from
+	 * what's already in the window. */
+	frame = prepare_frame(view);
+	if(frame == NULL || !frame->valid)
+	{
+		ui_view_erase(view);
+	}
 
-	cell = 0U;
-	coll_pad = (!ui_view_displays_columns(view) && cfg.extra_padding) ? 1 : 0;
-	for(x = top; x < view->list_rows; ++x)
+	(void)draw_cells(view, top, col_count, col_width, frame);
+	if(frame != NULL && commit_frame(view, frame) != 0)
+	{
+		ui_view_erase(view);
+		frame->repainted += draw_cells(view, top, col_count, col_width, NULL);
+	}
+
+	view->top_line = top;
+	view->curr_line = view->list_pos - view->top_line;
+
+	if(view == curr_view)
+	{
+		consider_scroll_bind(view);
+	}
+
+	ui_view_win_changed(view);
+}
+
+void
+fview_invalidate(FileView *view)
+{
+	if(view->frame != NULL)
+	{
+		view->frame->valid = 0;
+	}
+}
+
+size_t
+fview_repainted_cells(const FileView *view)
+{
+	return (view->frame == NULL) ? 0U : view->frame->repainted;
+}
+
+/* Draws visible cells of the view starting with the top one.  Cells are
+ * recorded into the frame unless it's NULL, in which case they are drawn
+ * directly.  Returns number of processed cells. */
+static size_t
+draw_cells(FileView *view, int top, size_t col_count, size_t col_width,
+		frame_t *frame)
+{
+	int x;
+	size_t cell = 0U;
+	const int coll_pad = (!ui_view_displays_columns(view) && cfg.extra_padding)
+	                   ? 1
+	                   : 0;
+
+	for(x = top; x < view->list_rows && cell < view->window_cells; ++x, ++cell)
 	{
 		size_t prefix_len = 0U;
+		const size_t line = cell/col_count;
+		frame_row_t *const row = (frame != NULL && line < (size_t)frame->height)
+		                       ? &frame->next[line]
+		                       : NULL;
 		const column_data_t cdt = {
 			.view = view,
 			.line_pos = x,
 			.line_hi_group = get_line_color(view, x),
 			.is_current = (view == curr_view) ? x == view->list_pos : 0,
-			.current_line = cell/col_count,
+			.current_line = line,
 			.column_offset = (cell%col_count)*col_width,
 			.prefix_len = &prefix_len,
+			.row = row,
 		};
 
 		const size_t print_width = calculate_print_width(view, x, col_width);
 
 		draw_cell(view, &cdt, col_width - coll_pad, print_width);
 
-		++cell;
-		if(cell >= view->window_cells)
+		if(row != NULL)
 		{
-			break;
+			++row->cells;
 		}
 	}
 
-	view->top_line = top;
-	view->curr_line = view->list_pos - view->top_line;
+	return cell;
+}
 
-	if(view == curr_view)
+/* Makes sure that the view has a frame that matches its window and prepares
+ * the frame for recording a redraw.  Returns the frame or NULL on error. */
+static frame_t *
+prepare_frame(FileView *view)
+{
+	int i;
+	const int height = view->window_rows + 1;
+	const int bg = get_window_bg(view);
+	frame_t *frame = view->frame;
+
+	if(height <= 0)
 	{
-		consider_scroll_bind(view);
+		return NULL;
 	}
 
-	ui_view_win_changed(view);
+	if(frame == NULL)
+	{
+		frame = calloc(1, sizeof(*frame));
+		if(frame == NULL)
+		{
+			return NULL;
+		}
+		view->frame = frame;
+	}
+
+	if(frame->height != height)
+	{
+		frame_row_t *const rows = calloc(height, sizeof(*rows));
+		frame_row_t *const next = calloc(height, sizeof(*next));
+		if(rows == NULL || next == NULL)
+		{
+			free(rows);
+			free(next);
+			frame->valid = 0;
+			return NULL;
+		}
+
+		free_rows(frame->rows, frame->height);
+		free_rows(frame->next, frame->height);
+		frame->rows = rows;
+		frame->next = next;
+		frame->height = height;
+		frame->valid = 0;
+	}
+
+	if(frame->width != view->window_width || frame->bg != bg)
+	{
+		frame->width = view->window_width;
+		frame->bg = bg;
+		frame->valid = 0;
+	}
+
+	for(i = 0; i < height; ++i)
+	{
+		frame->next[i].len = 0U;
+		frame->next[i].cells = 0;
+		frame->next[i].failed = 0;
+	}
+
+	return frame;
+}
+
+/* Computes background attributes that ui_view_erase() sets for window of the
+ * view.  Returns the attributes. */
+static int
+get_window_bg(const FileView *view)
+{
+	const col_scheme_t *const cs = ui_view_get_cs(view);
+	return COLOR_PAIR(cs->pair[WIN_COLOR]) | cs->color[WIN_COLOR].attr;
+}
+
+/* Resets cached results of looking up file name specific highlights if the
+ * list of highlights was replaced since they were computed. */
+static void
+sync_hi_hints(FileView *view)
+{
+	const col_scheme_t *const cs = ui_view_get_cs(view);
+	if(view->hi_gen != cs->file_hi_gen)
+	{
+		fview_view_cs_reset(view);
+		view->hi_gen = cs->file_hi_gen;
+	}
+}
+
+/* Puts rows of the frame that differ from contents of the window on the
+ * screen.  Returns zero on success, otherwise non-zero is returned and nothing
+ * is drawn. */
+static int
+commit_frame(FileView *view, frame_t *frame)
+{
+	int i;
+
+	for(i = 0; i < frame->height; ++i)
+	{
+		if(frame->next[i].failed)
+		{
+			frame->valid = 0;
+			return 1;
+		}
+	}
+
+	for(i = 0; i < frame->height; ++i)
+	{
+		frame_row_t *const curr = &frame->rows[i];
+		const frame_row_t next = frame->next[i];
+
+		if(!frame->valid || curr->dirty || next.len != curr->len ||
+				(next.len != 0U && memcmp(next.ops, curr->ops, next.len) != 0))
+		{
+			/* Invalid frame means that the window has just been erased. */
+			if(frame->valid)
+			{
+				checked_wmove(view->win, i, 0);
+				wclrtoeol(view->win);
+			}
+			replay_row(view->win, i, &next);
+			frame->repainted += next.cells;
+		}
+
+		/* Swap the rows to reuse their memory on the next redraw. */
+		frame->next[i] = *curr;
+		*curr = next;
+		curr->dirty = 0;
+	}
+
+	frame->valid = 1;
+	return 0;
+}
+
+/* Performs print operations recorded for the row on the line of the window. */
+static void
+replay_row(WINDOW *win, int line, const frame_row_t *row)
+{
+	size_t pos = 0U;
+	while(pos < row->len)
+	{
+		print_op_t op;
+		memcpy(&op, row->ops + pos, sizeof(op));
+		pos += sizeof(op);
+
+		checked_wmove(win, line, op.column);
+		wprinta(win, row->ops + pos, op.attrs);
+		pos += op.len + 1U;
+	}
+}
+
+/* Frees memory of array of rows. */
+static void
+free_rows(frame_row_t rows[], int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free(rows[i].ops);
+	}
+	free(rows);
+}
+
+/* Marks row of the window as being changed outside of full redraw. */
+static void
+touch_row(const FileView *view, int line)
+{
+	frame_t *const frame = view->frame;
+	if(frame != NULL && line >= 0 && line < frame->height)
+	{
+		frame->rows[line].dirty = 1;
+	}
+}
+
+/* Prints text on the line of the cell either directly or by recording it into
+ * the row of the cell. */
+static void
+print_at(const column_data_t *cdt, int column, const char text[], int attrs)
+{
+	if(cdt->row == NULL)
+	{
+		checked_wmove(cdt->view->win, cdt->current_line, column);
+		wprinta(cdt->view->win, text, attrs);
+	}
+	else
+	{
+		record_print(cdt->row, column, text, attrs);
+	}
+}
+
+/* Appends print operation to the row.  On memory error the row is marked as
+ * failed. */
+static void
+record_print(frame_row_t *row, int column, const char text[], int attrs)
+{
+	const print_op_t op = { .column = column, .attrs = attrs,
+	                        .len = strlen(text) };
+	const size_t size = sizeof(op) + op.len + 1U;
+
+	if(row->failed)
+	{
+		return;
+	}
+
+	if(row->len + size > row->cap)
+	{
+		const size_t cap = MAX(row->cap*2U, row->len + size);
+		char *const ops = realloc(row->ops, cap);
+		if(ops == NULL)
+		{
+			row->failed = 1;
+			return;
+		}
+		row->ops = ops;
+		row->cap = cap;
+	}
+
+	memcpy(row->ops + row->len, &op, sizeof(op));
+	memcpy(row->ops + row->len + sizeof(op), text, op.len + 1U);
+	row->len += size;
 }
 
 /* Calculates number of columns and maximum width of column in a view. */
@@ -385,11 +718,14 @@ calculate_top_position(FileView *view, int top)
 	return result;
 }
 
-/* Calculates highlight group for the line specified by its position.  Returns
- * highlight group number. */
+/* Calculates highlight group for the line specified by its position.  This is
+ * the first thing done to an entry on drawing it, so it also makes sure that
+ * meta-data of the entry is loaded.  Returns highlight group number. */
 static int
 get_line_color(const FileView *view, int pos)
 {
+	fentry_load_meta(&view->dir_entry[pos]);
+
 	switch(view->dir_entry[pos].type)
 	{
 		case FT_DIR:
@@ -401,25 +737,7 @@ get_line_color(const FileView *view, int pos)
 			{
 				return LINK_COLOR;
 			}
-			else
-			{
-				char full[PATH_MAX];
-				get_full_path_at(view, pos, sizeof(full), full);
-				if(get_link_target_abs(full, view->dir_entry[pos].origin, full,
-							sizeof(full)) != 0)
-				{
-					return BROKEN_LINK_COLOR;
-				}
-
-				/* Assume that targets on slow file system are not broken as actual
-				 * check might take long time. */
-				if(is_on_slow_fs(full, cfg.slow_fs_list))
-				{
-					return LINK_COLOR;
-				}
-
-				return path_exists(full, DEREF) ? LINK_COLOR : BROKEN_LINK_COLOR;
-			}
+			return is_broken_link(view, pos) ? BROKEN_LINK_COLOR : LINK_COLOR;
 #ifndef _WIN32
 		case FT_SOCK:
 			return SOCKET_COLOR;
@@ -435,6 +753,47 @@ get_line_color(const FileView *view, int pos)
 	}
 }
 
+/* Checks whether symbolic link at specified position of the view points to
+ * nowhere.  The result is cached in the entry, which is recreated on reloading
+ * file list, so that redraws don't query file system.  Also remembers whether
+ * the target can be affected by changes in directory of the link.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+is_broken_link(const FileView *view, int pos)
+{
+	char full[PATH_MAX];
+	dir_entry_t *const entry = &view->dir_entry[pos];
+
+	if(entry->link_checked)
+	{
+		return entry->broken_link;
+	}
+
+	entry->link_checked = 1;
+
+	get_full_path_at(view, pos, sizeof(full), full);
+	if(get_link_target_abs(full, entry->origin, full, sizeof(full)) != 0)
+	{
+		entry->broken_link = 1;
+		/* Don't know where it points, so check it again on any change. */
+		entry->local_link = 1;
+	}
+	else
+	{
+		char target_dir[PATH_MAX];
+		copy_str(target_dir, sizeof(target_dir), full);
+		remove_last_path_component(target_dir);
+		entry->local_link = paths_are_equal(target_dir, entry->origin);
+
+		/* Assume that targets on slow file system are not broken as actual check
+		 * might take long time. */
+		entry->broken_link = !is_on_slow_fs(full, cfg.slow_fs_list)
+		                  && !path_exists(full, DEREF);
+	}
+
+	return entry->broken_link;
+}
+
 /* Calculates width of the column using entry and maximum width. */
 static size_t
 calculate_print_width(const FileView *view, int i, size_t max_width)
@@ -453,6 +812,11 @@ static void
 draw_cell(const FileView *view, const column_data_t *cdt, size_t col_width,
 		size_t print_width)
 {
+	if(cdt->row == NULL)
+	{
+		touch_row(view, cdt->current_line);
+	}
+
 	if(cfg.extra_padding)
 	{
 		column_line_print(cdt, FILL_COLUMN_ID, " ", -1, AT_LEFT, " ");
@@ -640,6 +1004,7 @@ put_inactive_mark(FileView *view)
 	checked_wmove(view->win, line, column);
 
 	wprinta(view->win, INACTIVE_CURSOR_MARK, line_attrs);
+	touch_row(view, line);
 	ui_view_win_changed(view);
 }
 
@@ -750,6 +1115,8 @@ clear_current_line_bar(FileView *view, int is_current)
 		return;
 	}
 
+	sync_hi_hints(view);
+
 	cdt.line_hi_group = get_line_color(view, old_pos),
 
 	calculate_table_conf(view, &col_count, &col_width);
@@ -954,13 +1321,10 @@ column_line_print(const void *data, int column_id, const char buf[],
 		buf += extra_prefix;
 		full_column += extra_prefix;
 
-		checked_wmove(view->win, cdt->current_line, final_offset - extra_prefix);
-		wprinta(view->win, print_buf,
+		print_at(cdt, final_offset - extra_prefix, print_buf,
 				prepare_col_color(view, entry, 0, cdt->line_hi_group, cdt->is_current));
 	}
 
-	checked_wmove(view->win, cdt->current_line, final_offset);
-
 	if(fentry_is_fake(entry))
 	{
 		memset(print_buf, '.', sizeof(print_buf) - 1U);
@@ -978,12 +1342,12 @@ column_line_print(const void *data, int column_id, const char buf[],
 	{
 		print_buf[trim_pos] = '\0';
 	}
-	wprinta(view->win, print_buf, line_attrs);
+	print_at(cdt, final_offset, print_buf, line_attrs);
 
 	if(primary && view->matches != 0 && entry->search_match)
 	{
-		highlight_search(view, entry, full_column, print_buf, trim_pos, align,
-				cdt->current_line, final_offset, line_attrs);
+		highlight_search(cdt, entry, full_column, print_buf, trim_pos, align,
+				final_offset, line_attrs);
 	}
 }
 
@@ -1004,17 +1368,16 @@ draw_line_number(const column_data_t *cdt, int column)
 	char num_str[view->real_num_width + 1];
 	snprintf(num_str, sizeof(num_str), format, view->real_num_width - 1, num);
 
-	checked_wmove(view->win, cdt->current_line, column);
-	wprinta(view->win, num_str,
+	print_at(cdt, column, num_str,
 			prepare_col_color(view, entry, 0, cdt->line_hi_group, cdt->is_current));
 }
 
 /* Highlights search match for the entry (assumed to be a search hit).  Modifies
  * the buf argument in process. */
 static void
-highlight_search(FileView *view, dir_entry_t *entry, const char full_column[],
-		char buf[], size_t buf_len, AlignType align, int line, int col,
-		int line_attrs)
+highlight_search(const column_data_t *cdt, dir_entry_t *entry,
+		const char full_column[], char buf[], size_t buf_len, AlignType align,
+		int col, int line_attrs)
 {
 	size_t name_offset, lo, ro;
 	const char *fname;
@@ -1050,8 +1413,7 @@ highlight_search(FileView *view, dir_entry_t *entry, const char full_column[],
 		const int offset = width - mark_len;
 		copy_str(mark, mark_len + 1, ">>>");
 
-		checked_wmove(view->win, line, col + offset);
-		wprinta(view->win, mark, line_attrs ^ A_REVERSE);
+		print_at(cdt, col + offset, mark, line_attrs ^ A_REVERSE);
 	}
 	else if(align == AT_RIGHT && lo < (short int)strlen(full_column) - buf_len)
 	{
@@ -1061,8 +1423,7 @@ highlight_search(FileView *view, dir_entry_t *entry, const char full_column[],
 		const size_t mark_len = MIN(sizeof(mark) - 1, width);
 		copy_str(mark, mark_len + 1, "<<<");
 
-		checked_wmove(view->win, line, col);
-		wprinta(view->win, mark, line_attrs ^ A_REVERSE);
+		print_at(cdt, col, mark, line_attrs ^ A_REVERSE);
 	}
 	else
 	{
@@ -1088,9 +1449,9 @@ highlight_search(FileView *view, dir_entry_t *entry, const char full_column[],
 		match_start = utf8_strsw(buf);
 		buf[lo] = c;
 
-		checked_wmove(view->win, line, col + match_start);
 		buf[ro] = '\0';
-		wprinta(view->win, buf + lo, line_attrs ^ (A_REVERSE | A_UNDERLINE));
+		print_at(cdt, col + match_start, buf + lo,
+				line_attrs ^ (A_REVERSE | A_UNDERLINE));
 	}
 }
 
@@ -1165,10 +1526,23 @@ mix_in_file_hi(const FileView *view, dir_entry_t *entry, int type_hi,
 static void
 mix_in_file_name_hi(const FileView *view, dir_entry_t *entry, col_attr_t *col)
 {
+	char typed_fname[PATH_MAX + 1];
+	const char *fname = NULL;
 	const col_scheme_t *const cs = ui_view_get_cs(view);
-	char *const typed_fname = get_typed_entry_fpath(entry);
-	const col_attr_t *color = cs_get_file_hi(cs, typed_fname, &entry->hi_num);
-	free(typed_fname);
+	const col_attr_t *color;
+
+	/* Avoid building the path when result of the lookup is known. */
+	if(!cs_file_hi_is_cached(cs, entry->hi_num))
+	{
+		get_full_path_of(entry, sizeof(typed_fname) - 1U, typed_fname);
+		if(fentry_is_dir(entry))
+		{
+			strcat(typed_fname, "/");
+		}
+		fname = typed_fname;
+	}
+
+	color = cs_get_file_hi(cs, fname, &entry->hi_num);
 	if(color != NULL)
 	{
 		cs_mix_colors(col, color);
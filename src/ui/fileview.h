@@ -36,11 +36,25 @@ void fview_view_init(FileView *view);
 /* Resets view state partially. */
 void fview_view_reset(FileView *view);
 
+/* Frees record of what was drawn in the window of the view, next redraw
+ * repaints all rows. */
+void fview_view_free_frame(FileView *view);
+
 /* Resets view state with regard to color schemes. */
 void fview_view_cs_reset(FileView *view);
 
 /* Appearance related functions. */
 
+/* Forgets what was drawn in the window of the view, so that next redraw of file
+ * list repaints all of its rows.  Should be called when something else draws
+ * in the window. */
+void fview_invalidate(FileView *view);
+
+/* Retrieves number of file list cells that were repainted in the view so far.
+ * Cells that didn't change between redraws aren't counted.  Returns the
+ * number. */
+size_t fview_repainted_cells(const FileView *view);
+
 /* Redraws directory list and puts inactive mark for the other view. */
 void draw_dir_list(FileView *view);
 
@@ -166,6 +180,9 @@ typedef struct
 	size_t *prefix_len; /* Data prefix length (should be drawn in neutral color).
 	                     * A pointer to allow changing value in const struct.
 	                     * Should be zero first time, then auto reset. */
+
+	struct frame_row_t *row; /* Row to record drawing into or NULL to draw
+	                          * directly in the window. */
 }
 column_data_t;
 
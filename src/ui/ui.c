@@ -574,6 +574,10 @@ update_screen(UpdateType update_kind)
 
 	curr_stats.need_update = UT_NONE;
 
+	/* Don't rely on contents of the views as the whole screen is redrawn. */
+	fview_invalidate(&lwin);
+	fview_invalidate(&rwin);
+
 	update_views(update_kind == UT_FULL);
 	/* Redraw message dialog over updated panes.  It's not very nice to do it
 	 * here, but for sure better then blocking pane updates by checking for
@@ -1749,6 +1753,7 @@ ui_view_erase(FileView *view)
 	const int bg = COLOR_PAIR(cs->pair[WIN_COLOR]) | cs->color[WIN_COLOR].attr;
 	wbkgdset(view->win, bg);
 	werase(view->win);
+	fview_invalidate(view);
 }
 
 void
@@ -1774,6 +1779,7 @@ ui_view_wipe(FileView *view)
 	}
 	redrawwin(view->win);
 	wrefresh(view->win);
+	fview_invalidate(view);
 }
 
 int
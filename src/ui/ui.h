@@ -175,10 +175,10 @@ typedef struct dir_entry_t
 #else
 	uint32_t attrs;
 #endif
+	FileType type;    /* Placed here to fill what would otherwise be padding. */
 	time_t mtime;
 	time_t atime;
 	time_t ctime;
-	FileType type;
 	int nlinks;       /* Number of hard links to the entry. */
 
 	int id;           /* File uniqueness identifier. */
@@ -187,7 +187,8 @@ typedef struct dir_entry_t
 	                     e.g. by sorting comparer to perform stable sort or item
 	                     mapping during tree filtering. */
 
-	int hi_num;       /* File highlighting parameters cache (initially -1). */
+	int hi_num;       /* File highlighting parameters cache (initially -1).  Also
+	                     caches absence of a match, see cs_get_file_hi(). */
 	int name_dec_num; /* File decoration parameters cache (initially -1).  The
 	                     value is shifted by one, 0 means type decoration. */
 
@@ -204,6 +205,20 @@ typedef struct dir_entry_t
 	unsigned int was_selected : 1; /* Previous selection state for Visual mode. */
 	unsigned int marked : 1;       /* Whether file should be processed. */
 	unsigned int temporary : 1;    /* Whether this is temporary node. */
+	unsigned int no_meta : 1;      /* Whether only name and type (which might be
+	                                  FT_REG for FT_EXEC) of the file are known,
+	                                  see fentry_load_meta(). */
+	unsigned int arena_name : 1;   /* Whether name is allocated by arena_strdup()
+	                                  instead of malloc(). */
+	unsigned int arena_origin : 1; /* Whether origin is allocated by
+	                                  arena_strdup() instead of malloc(). */
+	unsigned int link_checked : 1; /* Whether broken_link contains actual state
+	                                  of symbolic link. */
+	unsigned int broken_link : 1;  /* Whether target of symbolic link doesn't
+	                                  exist, see link_checked. */
+	unsigned int local_link : 1;   /* Whether target of symbolic link might be
+	                                  in the same directory, see
+	                                  link_checked. */
 }
 dir_entry_t;
 
@@ -257,12 +272,18 @@ typedef struct
 		/* Names of files in custom view while it's being composed.  Used for
 		 * duplicate elimination during construction of custom list. */
 		struct trie_t *paths_cache;
+
+		/* Results of scanning file system for tree-view or NULL.  Used to update
+		 * the view by listing only directories that have changed. */
+		struct tree_dir_t *tree;
 	}
 	custom;
 
 	/* Monitor that checks for directory changes. */
 	fswatch_t *watch;
 	char watched_dir[PATH_MAX];
+	/* Whether the monitor covers all directories of a tree-view. */
+	int watch_tree;
 
 	char last_dir[PATH_MAX];
 
@@ -364,6 +385,13 @@ typedef struct
 	size_t column_count; /* number of columns in the view, used for list view */
 	size_t window_cells; /* max number of files that can be displayed */
 
+	/* Rows of the window as they were drawn by the last redraw of file list,
+	 * used to repaint only rows that change.  Managed by fileview unit. */
+	struct frame_t *frame;
+	/* file_hi_gen of color scheme for which hi_num fields of entries are
+	 * computed. */
+	unsigned int hi_gen;
+
 	/* Whether and how line numbers are displayed. */
 	NumberingType num_type, num_type_g;
 	/* Min number of characters reserved for number field. */
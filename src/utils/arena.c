@@ -0,0 +1,206 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "arena.h"
+
+#ifdef _WIN32
+#include <malloc.h> /* _aligned_free() _aligned_malloc() */
+#endif
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uintptr_t */
+#include <stdlib.h> /* free() malloc() posix_memalign() */
+#include <string.h> /* memcpy() strlen() */
+
+/* Size of a chunk, which is also its alignment.  Chunk of a string is found by
+ * clearing lower bits of its address, which is why alignment matters. */
+#define CHUNK_SIZE (64*1024)
+
+/* Header of a chunk, strings follow it. */
+typedef struct
+{
+	int refs;     /* Number of strings in use. */
+	int detached; /* Whether arena doesn't allocate from this chunk anymore. */
+}
+chunk_t;
+
+/* Arena of strings. */
+struct arena_t
+{
+	chunk_t *chunk; /* Chunk for new strings or NULL. */
+	size_t used;    /* Number of used bytes of the chunk including header. */
+};
+
+static chunk_t * alloc_chunk(size_t size);
+static void detach_chunk(chunk_t *chunk);
+static void free_chunk(chunk_t *chunk);
+static chunk_t * get_chunk(const char str[]);
+
+arena_t *
+arena_create(void)
+{
+	arena_t *const arena = malloc(sizeof(*arena));
+	if(arena == NULL)
+	{
+		return NULL;
+	}
+
+	arena->chunk = NULL;
+	arena->used = 0U;
+	return arena;
+}
+
+void
+arena_free(arena_t *arena)
+{
+	if(arena != NULL)
+	{
+		detach_chunk(arena->chunk);
+		free(arena);
+	}
+}
+
+char *
+arena_strdup(arena_t *arena, const char str[])
+{
+	const size_t len = strlen(str) + 1U;
+	chunk_t *chunk;
+	char *copy;
+
+	if(sizeof(chunk_t) + len > CHUNK_SIZE)
+	{
+		/* Too long for a regular chunk, give the string a chunk of its own. */
+		chunk = alloc_chunk(sizeof(chunk_t) + len);
+		if(chunk == NULL)
+		{
+			return NULL;
+		}
+		chunk->detached = 1;
+		copy = (char *)(chunk + 1);
+	}
+	else
+	{
+		if(arena->chunk == NULL || arena->used + len > CHUNK_SIZE)
+		{
+			chunk = alloc_chunk(CHUNK_SIZE);
+			if(chunk == NULL)
+			{
+				return NULL;
+			}
+			detach_chunk(arena->chunk);
+			arena->chunk = chunk;
+			arena->used = sizeof(chunk_t);
+		}
+
+		chunk = arena->chunk;
+		copy = (char *)chunk + arena->used;
+		arena->used += len;
+	}
+
+	memcpy(copy, str, len);
+	++chunk->refs;
+	return copy;
+}
+
+void
+arena_ref(const char str[])
+{
+	++get_chunk(str)->refs;
+}
+
+void
+arena_release(const char str[])
+{
+	chunk_t *chunk;
+
+	if(str == NULL)
+	{
+		return;
+	}
+
+	chunk = get_chunk(str);
+	if(--chunk->refs == 0 && chunk->detached)
+	{
+		free_chunk(chunk);
+	}
+}
+
+/* Allocates chunk of specified size aligned at CHUNK_SIZE.  Returns the chunk
+ * or NULL on error. */
+static chunk_t *
+alloc_chunk(size_t size)
+{
+	chunk_t *chunk;
+
+#ifndef _WIN32
+	void *ptr;
+	if(posix_memalign(&ptr, CHUNK_SIZE, size) != 0)
+	{
+		return NULL;
+	}
+	chunk = ptr;
+#else
+	chunk = _aligned_malloc(size, CHUNK_SIZE);
+	if(chunk == NULL)
+	{
+		return NULL;
+	}
+#endif
+
+	chunk->refs = 0;
+	chunk->detached = 0;
+	return chunk;
+}
+
+/* Marks the chunk as not used by arena anymore freeing it if it has no
+ * strings in use.  NULL argument is fine. */
+static void
+detach_chunk(chunk_t *chunk)
+{
+	if(chunk == NULL)
+	{
+		return;
+	}
+
+	chunk->detached = 1;
+	if(chunk->refs == 0)
+	{
+		free_chunk(chunk);
+	}
+}
+
+/* Frees memory of the chunk. */
+static void
+free_chunk(chunk_t *chunk)
+{
+#ifndef _WIN32
+	free(chunk);
+#else
+	_aligned_free(chunk);
+#endif
+}
+
+/* Retrieves chunk that contains the string.  Returns the chunk. */
+static chunk_t *
+get_chunk(const char str[])
+{
+	return (chunk_t *)((uintptr_t)str & ~(uintptr_t)(CHUNK_SIZE - 1));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,53 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__ARENA_H__
+#define VIFM__UTILS__ARENA_H__
+
+/* Arena of strings meant for storing many small strings that are created at
+ * once (like names of files in a directory) with much less allocations and
+ * memory overhead than with strdup().  Strings are placed one after another
+ * into large chunks, each chunk counts strings that reference it and is freed
+ * as a whole once the last of them is released and the arena moved on to
+ * another chunk or was freed.  Strings can outlive their arena.  Not
+ * thread-safe. */
+
+/* Opaque arena type. */
+typedef struct arena_t arena_t;
+
+/* Creates an empty arena.  Returns the arena or NULL on error. */
+arena_t * arena_create(void);
+
+/* Frees the arena.  Memory of strings allocated from it is reclaimed once they
+ * are all released.  NULL argument is fine. */
+void arena_free(arena_t *arena);
+
+/* Copies the string into the arena.  Returns the copy or NULL on error. */
+char * arena_strdup(arena_t *arena, const char str[]);
+
+/* Registers another owner of a string allocated by arena_strdup(), which will
+ * have to call arena_release() for it. */
+void arena_ref(const char str[]);
+
+/* Releases string allocated by arena_strdup().  NULL argument is fine. */
+void arena_release(const char str[]);
+
+#endif /* VIFM__UTILS__ARENA_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
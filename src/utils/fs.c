@@ -31,11 +31,12 @@
 
 #include <sys/stat.h> /* S_* statbuf */
 #include <sys/types.h> /* size_t mode_t */
-#include <unistd.h> /* getcwd() pathconf() readlink() */
+#include <unistd.h> /* SEEK_DATA SEEK_HOLE getcwd() lseek() pathconf()
+                       readlink() */
 
-#include <errno.h> /* errno */
+#include <errno.h> /* ENXIO errno */
 #include <stddef.h> /* NULL */
-#include <stdio.h> /* snprintf() remove() */
+#include <stdio.h> /* FILE fclose() fileno() snprintf() remove() */
 #include <stdlib.h> /* free() qsort() */
 #include <string.h> /* strcpy() strdup() strlen() strncmp() strncpy() */
 
@@ -512,6 +513,55 @@ get_file_size(const char path[])
 #endif
 }
 
+uint64_t
+get_file_data_size(const char path[])
+{
+#ifdef SEEK_HOLE
+	struct stat st;
+	FILE *fp;
+	off_t pos;
+	uint64_t size;
+
+	/* Files without holes have at least as many blocks as their size needs. */
+	if(os_lstat(path, &st) != 0 || !S_ISREG(st.st_mode) ||
+			(uint64_t)st.st_blocks*512U >= (uint64_t)st.st_size)
+	{
+		return get_file_size(path);
+	}
+
+	fp = os_fopen(path, "rb");
+	if(fp == NULL)
+	{
+		return st.st_size;
+	}
+
+	size = 0U;
+	pos = 0;
+	while(pos < st.st_size)
+	{
+		const off_t data = lseek(fileno(fp), pos, SEEK_DATA);
+		const off_t hole = (data < 0) ? -1 : lseek(fileno(fp), data, SEEK_HOLE);
+		if(hole < 0)
+		{
+			/* Either there is no more data or holes aren't supported. */
+			if(data >= 0 || errno != ENXIO)
+			{
+				size = st.st_size;
+			}
+			break;
+		}
+
+		size += hole - data;
+		pos = hole;
+	}
+
+	fclose(fp);
+	return size;
+#else
+	return get_file_size(path);
+#endif
+}
+
 char **
 list_regular_files(const char path[], char *list[], int *len)
 {
@@ -648,9 +698,9 @@ int
 entry_is_link(const char path[], const struct dirent* dentry)
 {
 #ifndef _WIN32
-	if(dentry->d_type == DT_LNK)
+	if(dentry->d_type != DT_UNKNOWN)
 	{
-		return 1;
+		return dentry->d_type == DT_LNK;
 	}
 #endif
 	return is_symlink(path);
@@ -118,6 +118,10 @@ int is_dir_writable(const char path[]);
  * empty files and on error. */
 uint64_t get_file_size(const char path[]);
 
+/* Gets amount of data in a file, which is less than its size for sparse files.
+ * Returns zero for both empty files and on error. */
+uint64_t get_file_data_size(const char path[]);
+
 /* Appends all regular files inside the path directory.  Reallocates array of
  * strings if necessary to fit all elements.  Returns pointer to reallocated
  * array or source list (on error). */
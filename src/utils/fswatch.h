@@ -19,15 +19,41 @@
 #ifndef VIFM__UTILS__FSWATCH_H__
 #define VIFM__UTILS__FSWATCH_H__
 
+#include <time.h> /* time_t */
+
+#include "test_helpers.h"
+
 /* Implementation of file system changes checks via polling. */
 
 /* Opaque type of a watcher. */
 typedef struct fswatch_t fswatch_t;
 
+/* Kind of change of a file inside watched directory. */
+typedef enum
+{
+	FSWE_CREATED, /* File appeared in the directory (created or moved in). */
+	FSWE_DELETED, /* File disappeared from the directory (deleted or moved out). */
+	FSWE_CHANGED, /* Contents or attributes of the file were changed. */
+}
+FSWatchEventKind;
+
+/* Change of a single file inside watched directory. */
+typedef struct
+{
+	char *name;            /* Name of the file. */
+	FSWatchEventKind kind; /* First thing that happened to the file. */
+}
+fswatch_event_t;
+
 /* Creates new watcher for the specified path.  Returns the watcher or NULL on
  * error. */
 fswatch_t * fswatch_create(const char path[]);
 
+/* Extends watcher to also report changes of a subdirectory (at any depth) of
+ * the original directory.  Returns zero on success, otherwise non-zero is
+ * returned and changes of the subdirectory won't be detected. */
+int fswatch_add(fswatch_t *w, const char path[]);
+
 /* Frees a watcher.  w can be NULL. */
 void fswatch_free(fswatch_t *w);
 
@@ -36,6 +62,26 @@ void fswatch_free(fswatch_t *w);
  * non-zero if so, otherwise zero is returned. */
 int fswatch_changed(fswatch_t *w, int *error);
 
+/* Retrieves changes of files inside watched directory detected by the last
+ * call of fswatch_changed().  Events about the same file are merged.  The list
+ * is valid until the next call of fswatch_changed() or fswatch_free().  Returns
+ * NULL if the list isn't available (changes aren't tracked, there are too many
+ * of them, directory itself or one of directories added by fswatch_add() has
+ * changed), in which case whole directory should be considered changed. */
+const fswatch_event_t * fswatch_get_events(const fswatch_t *w, int *count);
+
+/* Retrieves directories (paths as they were passed to fswatch_create() or
+ * fswatch_add()) in which changes were detected by the last call of
+ * fswatch_changed().  Each directory is listed once.  The list is valid until
+ * the next call of fswatch_changed(), fswatch_add() or fswatch_free().  Returns
+ * NULL if the list isn't available, in which case all directories should be
+ * considered changed. */
+const char * const * fswatch_get_dirs(const fswatch_t *w, int *count);
+
+TSTATIC_DEFS(
+	void fswatch_set_clock(time_t (*clock)(time_t *t));
+)
+
 #endif /* VIFM__UTILS__FSWATCH_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
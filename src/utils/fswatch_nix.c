@@ -28,7 +28,9 @@
 #include <errno.h> /* EAGAIN errno */
 #include <stddef.h> /* NULL */
 #include <stdint.h> /* uint32_t */
-#include <stdlib.h> /* free() */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* atoi() free() */
+#include <string.h> /* strchr() strcmp() strdup() */
 #include <time.h> /* time_t time() */
 
 #include "../compat/fs_limits.h"
@@ -37,13 +39,44 @@
 /* TODO: consider implementation that could reuse already available descriptor
  *       by just removing old watch and then adding a new one. */
 
+/* Maximum number of files whose changes are tracked between queries.  It
+ * doesn't make sense to process more of them one by one. */
+#define MAX_EVENTS 128
+
+/* Events that are watched for. */
+#define WATCH_MASK (IN_ATTRIB | IN_MODIFY | IN_CREATE | IN_DELETE | \
+                    IN_MOVED_FROM | IN_MOVED_TO | IN_EXCL_UNLINK | \
+                    IN_CLOSE_WRITE)
+
 /* Watcher data. */
 struct fswatch_t
 {
 	/* File descriptor for inotify. */
 	int fd;
+	/* Watch descriptor of the directory passed to fswatch_create(). */
+	int root_wd;
 	/* Trie to keep track of per file frequency of notifications. */
 	trie_t *stats;
+	/* Changes of files found by the last query. */
+	fswatch_event_t events[MAX_EVENTS];
+	/* Number of elements in the events array. */
+	int nevents;
+	/* Whether events array describes all changes. */
+	int complete;
+	/* Keys of files (see update_file_stats()) whose changes were ignored during
+	 * their ban, they are reported as changed once the ban is over. */
+	char *muted[MAX_EVENTS];
+	/* Number of elements in the muted array. */
+	int nmuted;
+	/* Paths of watched directories keyed by their watch descriptors. */
+	trie_t *paths;
+	/* Directories in which changes were found by the last query, point to data
+	 * of the paths trie. */
+	const char *dirs[MAX_EVENTS];
+	/* Number of elements in the dirs array. */
+	int ndirs;
+	/* Whether dirs array lists all directories that have changed. */
+	int dirs_complete;
 };
 
 /* Per file statistics information. */
@@ -57,8 +90,18 @@ typedef struct
 }
 notif_stat_t;
 
+static int set_dir_path(fswatch_t *w, int wd, const char path[]);
 static int update_file_stats(fswatch_t *w, const struct inotify_event *e,
 		time_t now);
+static int mute_file(fswatch_t *w, const char key[]);
+static int release_muted(fswatch_t *w, time_t now);
+static void record_event(fswatch_t *w, const struct inotify_event *e);
+static void add_event(fswatch_t *w, const char name[], FSWatchEventKind kind);
+static void add_dir(fswatch_t *w, int wd);
+static void clear_events(fswatch_t *w);
+
+/* Source of current time, which is used to expire bans. */
+static time_t (*get_time)(time_t *t) = &time;
 
 fswatch_t *
 fswatch_create(const char path[])
@@ -80,35 +123,74 @@ fswatch_create(const char path[])
 		return NULL;
 	}
 
+	/* Create map to resolve watch descriptors into paths. */
+	w->paths = trie_create();
+	if(w->paths == NULL)
+	{
+		trie_free_with_data(w->stats, &free);
+		free(w);
+		return NULL;
+	}
+
 	/* Create inotify instance. */
 	w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
 	if(w->fd == -1)
 	{
+		trie_free_with_data(w->paths, &free);
 		trie_free_with_data(w->stats, &free);
 		free(w);
 		return NULL;
 	}
 
 	/* Add directory to watch. */
-	wd = inotify_add_watch(w->fd, path, IN_ATTRIB | IN_MODIFY | IN_CREATE |
-			IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_EXCL_UNLINK |
-			IN_CLOSE_WRITE);
-	if(wd == -1)
+	wd = inotify_add_watch(w->fd, path, WATCH_MASK);
+	if(wd == -1 || set_dir_path(w, wd, path) != 0)
 	{
 		close(w->fd);
+		trie_free_with_data(w->paths, &free);
 		trie_free_with_data(w->stats, &free);
 		free(w);
 		return NULL;
 	}
 
+	w->root_wd = wd;
+	w->nevents = 0;
+	w->complete = 1;
+	w->nmuted = 0;
+	w->ndirs = 0;
+	w->dirs_complete = 1;
+
 	return w;
 }
 
+int
+fswatch_add(fswatch_t *w, const char path[])
+{
+	/* All watches share the descriptor, events are told apart by wd field. */
+	const int wd = inotify_add_watch(w->fd, path, WATCH_MASK);
+	if(wd == -1)
+	{
+		return 1;
+	}
+
+	/* Adding a watch for a directory that's already watched returns its watch
+	 * descriptor, this updates path of a directory that was moved. */
+	return set_dir_path(w, wd, path);
+}
+
 void
 fswatch_free(fswatch_t *w)
 {
 	if(w != NULL)
 	{
+		int i;
+		for(i = 0; i < w->nmuted; ++i)
+		{
+			free(w->muted[i]);
+		}
+
+		clear_events(w);
+		trie_free_with_data(w->paths, &free);
 		trie_free_with_data(w->stats, &free);
 		close(w->fd);
 		free(w);
@@ -125,7 +207,9 @@ fswatch_changed(fswatch_t *w, int *error)
 	int nread;
 	int changed = 0;
 	int nreads = 0;
-	const time_t now = time(NULL);
+	const time_t now = get_time(NULL);
+
+	clear_events(w);
 
 	*error = 0;
 	do
@@ -152,6 +236,8 @@ fswatch_changed(fswatch_t *w, int *error)
 			e = (struct inotify_event *)p;
 			if(update_file_stats(w, e, now))
 			{
+				record_event(w, e);
+				add_dir(w, (e->mask & IN_Q_OVERFLOW) ? -1 : e->wd);
 				changed = 1;
 			}
 		}
@@ -165,9 +251,59 @@ fswatch_changed(fswatch_t *w, int *error)
 	}
 	while(nread != 0);
 
+	if(release_muted(w, now))
+	{
+		changed = 1;
+	}
+
 	return changed;
 }
 
+const fswatch_event_t *
+fswatch_get_events(const fswatch_t *w, int *count)
+{
+	*count = w->nevents;
+	return w->complete ? w->events : NULL;
+}
+
+const char * const *
+fswatch_get_dirs(const fswatch_t *w, int *count)
+{
+	*count = w->ndirs;
+	return w->dirs_complete ? w->dirs : NULL;
+}
+
+/* Associates path with a watch descriptor replacing previous association.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+set_dir_path(fswatch_t *w, int wd, const char path[])
+{
+	char key[32];
+	void *data = NULL;
+	char *copy;
+
+	snprintf(key, sizeof(key), "%d", wd);
+	if(trie_get(w->paths, key, &data) == 0 && strcmp(data, path) == 0)
+	{
+		return 0;
+	}
+
+	copy = strdup(path);
+	if(copy == NULL || trie_set(w->paths, key, copy) < 0)
+	{
+		free(copy);
+		return 1;
+	}
+
+	/* Old path (if any) could be in the list of changed directories. */
+	if(data != NULL)
+	{
+		w->dirs_complete = 0;
+	}
+	free(data);
+	return 0;
+}
+
 /* Updates information about a file event is about.  Returns non-zero if this is
  * an interesting event that's worth attention (e.g. re-reading information from
  * file system), otherwise zero is returned. */
@@ -179,10 +315,18 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 	const uint32_t IMPORTANT_EVENTS = IN_CREATE | IN_DELETE | IN_MOVED_FROM
 	                                | IN_MOVED_TO | IN_Q_OVERFLOW;
 
-	const char *const fname = (e->len == 0U) ? "." : e->name;
+	char key[NAME_MAX + 32];
+	const char *fname = (e->len == 0U) ? "." : e->name;
 	void *data;
 	notif_stat_t *stats;
 
+	if(e->wd != w->root_wd)
+	{
+		/* Names of files in different directories can coincide. */
+		snprintf(key, sizeof(key), "%d/%s", e->wd, fname);
+		fname = key;
+	}
+
 	/* See if we already know this file and retrieve associated information if
 	 * so. */
 	if(trie_get(w->stats, fname, &data) != 0)
@@ -211,10 +355,11 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 		stats->count = 1;
 	}
 
-	/* Ignore events during banned period, unless it's something new. */
+	/* Ignore events during banned period, unless it's something new.  The file
+	 * is remembered to report its last state after the ban. */
 	if(now < stats->banned_until && !(e->mask & ~stats->ban_mask))
 	{
-		return 0;
+		return (mute_file(w, fname) != 0);
 	}
 
 	/* Treat events happened in the next second as a sequence. */
@@ -234,6 +379,207 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 	return 1;
 }
 
+/* Remembers that change of a file was ignored.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+mute_file(fswatch_t *w, const char key[])
+{
+	int i;
+
+	for(i = 0; i < w->nmuted; ++i)
+	{
+		if(strcmp(w->muted[i], key) == 0)
+		{
+			return 0;
+		}
+	}
+
+	if(w->nmuted == MAX_EVENTS)
+	{
+		return 1;
+	}
+
+	w->muted[w->nmuted] = strdup(key);
+	if(w->muted[w->nmuted] == NULL)
+	{
+		return 1;
+	}
+
+	++w->nmuted;
+	return 0;
+}
+
+/* Reports changes of muted files whose ban is over.  Returns non-zero if there
+ * were such files, otherwise zero is returned. */
+static int
+release_muted(fswatch_t *w, time_t now)
+{
+	int i, j;
+	int released = 0;
+
+	for(i = 0, j = 0; i < w->nmuted; ++i)
+	{
+		void *data;
+		char *const key = w->muted[i];
+
+		if(trie_get(w->stats, key, &data) == 0 &&
+				now < ((notif_stat_t *)data)->banned_until)
+		{
+			w->muted[j++] = key;
+			continue;
+		}
+
+		/* Keys of files outside of the root directory contain a slash. */
+		if(strchr(key, '/') != NULL)
+		{
+			w->complete = 0;
+			add_dir(w, atoi(key));
+		}
+		else
+		{
+			add_event(w, key, FSWE_CHANGED);
+			add_dir(w, w->root_wd);
+		}
+
+		free(key);
+		released = 1;
+	}
+	w->nmuted = j;
+
+	return released;
+}
+
+/* Adds event to the list of changes of files or merges it with existing one
+ * for the same file. */
+static void
+record_event(fswatch_t *w, const struct inotify_event *e)
+{
+	FSWatchEventKind kind;
+
+	if(!w->complete)
+	{
+		return;
+	}
+
+	/* Events for the directory itself or its subdirectories and overflow of
+	 * event queue mean that there is no way to tell what exactly has changed. */
+	if(e->len == 0U || e->wd != w->root_wd || (e->mask & IN_Q_OVERFLOW))
+	{
+		w->complete = 0;
+		return;
+	}
+
+	if(e->mask & (IN_CREATE | IN_MOVED_TO))
+	{
+		kind = FSWE_CREATED;
+	}
+	else if(e->mask & (IN_DELETE | IN_MOVED_FROM))
+	{
+		kind = FSWE_DELETED;
+	}
+	else
+	{
+		kind = FSWE_CHANGED;
+	}
+
+	add_event(w, e->name, kind);
+}
+
+/* Adds event about the file to the list of changes unless there is already one
+ * for the same file. */
+static void
+add_event(fswatch_t *w, const char name[], FSWatchEventKind kind)
+{
+	int i;
+	fswatch_event_t *event;
+
+	if(!w->complete)
+	{
+		return;
+	}
+
+	for(i = 0; i < w->nevents; ++i)
+	{
+		if(strcmp(w->events[i].name, name) == 0)
+		{
+			/* Kind of the first event is preserved, because it's what tells whether
+			 * the file existed before. */
+			return;
+		}
+	}
+
+	if(w->nevents == MAX_EVENTS)
+	{
+		w->complete = 0;
+		return;
+	}
+
+	event = &w->events[w->nevents];
+	event->name = strdup(name);
+	if(event->name == NULL)
+	{
+		w->complete = 0;
+		return;
+	}
+
+	event->kind = kind;
+	++w->nevents;
+}
+
+/* Adds directory identified by its watch descriptor to the list of changed
+ * directories unless it's already there.  Negative wd marks the list as
+ * incomplete. */
+static void
+add_dir(fswatch_t *w, int wd)
+{
+	int i;
+	char key[32];
+	void *data;
+
+	if(!w->dirs_complete)
+	{
+		return;
+	}
+
+	snprintf(key, sizeof(key), "%d", wd);
+	if(wd < 0 || trie_get(w->paths, key, &data) != 0 || w->ndirs == MAX_EVENTS)
+	{
+		w->dirs_complete = 0;
+		return;
+	}
+
+	for(i = 0; i < w->ndirs; ++i)
+	{
+		if(w->dirs[i] == data)
+		{
+			return;
+		}
+	}
+
+	w->dirs[w->ndirs++] = data;
+}
+
+/* Empties lists of changes of files and directories. */
+static void
+clear_events(fswatch_t *w)
+{
+	int i;
+	for(i = 0; i < w->nevents; ++i)
+	{
+		free(w->events[i].name);
+	}
+	w->nevents = 0;
+	w->complete = 1;
+	w->ndirs = 0;
+	w->dirs_complete = 1;
+}
+
+TSTATIC void
+fswatch_set_clock(time_t (*clock)(time_t *t))
+{
+	get_time = clock;
+}
+
 #else
 
 #include "filemon.h"
@@ -302,6 +648,36 @@ fswatch_changed(fswatch_t *w, int *error)
 	return changed;
 }
 
+int
+fswatch_add(fswatch_t *w, const char path[])
+{
+	/* Only one stamp is tracked. */
+	return 1;
+}
+
+const fswatch_event_t *
+fswatch_get_events(const fswatch_t *w, int *count)
+{
+	/* Stamps don't tell anything about particular files. */
+	*count = 0;
+	return NULL;
+}
+
+const char * const *
+fswatch_get_dirs(const fswatch_t *w, int *count)
+{
+	/* Only one directory is watched. */
+	*count = 0;
+	return NULL;
+}
+
+TSTATIC void
+fswatch_set_clock(time_t (*clock)(time_t *t))
+{
+	/* Time isn't used. */
+	(void)clock;
+}
+
 #endif
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
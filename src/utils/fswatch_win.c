@@ -75,6 +75,14 @@ fswatch_create(const char path[])
 	return w;
 }
 
+int
+fswatch_add(fswatch_t *w, const char path[])
+{
+	/* Notifications are requested for the whole subtree of the directory, so
+	 * its subdirectories are watched already. */
+	return 0;
+}
+
 void
 fswatch_free(fswatch_t *w)
 {
@@ -112,6 +120,29 @@ fswatch_changed(fswatch_t *w, int *error)
 	return changed;
 }
 
+const fswatch_event_t *
+fswatch_get_events(const fswatch_t *w, int *count)
+{
+	/* Change notifications don't tell anything about particular files. */
+	*count = 0;
+	return NULL;
+}
+
+const char * const *
+fswatch_get_dirs(const fswatch_t *w, int *count)
+{
+	/* Notifications for the whole subtree are merged together. */
+	*count = 0;
+	return NULL;
+}
+
+TSTATIC void
+fswatch_set_clock(time_t (*clock)(time_t *t))
+{
+	/* Time isn't used. */
+	(void)clock;
+}
+
 /* Gets last directory modification time.  Returns non-zero on error, otherwise
  * zero is returned. */
 static int
@@ -18,11 +18,58 @@
 
 #include "globs.h"
 
-#include <stdlib.h> /* free() realloc() */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() realloc() */
 #include <stdio.h> /* sprintf() */
-#include <string.h> /* strdup() */
+#include <string.h> /* memmove() strdup() strlen() strpbrk() */
 
 #include "str.h"
+#include "string_array.h"
+#include "utf8.h"
+
+/* Kind of a compiled glob, which determines how it's matched. */
+typedef enum
+{
+	GK_LITERAL,  /* No wildcards. */
+	GK_PREFIX,   /* Literal followed by single trailing asterisk. */
+	GK_SUFFIX,   /* Leading asterisk followed by a literal. */
+	GK_WILDCARD, /* Anything else, matched by backtracking. */
+}
+GlobKind;
+
+/* Single compiled glob. */
+typedef struct
+{
+	GlobKind kind;   /* How the glob is matched. */
+	char *pat;       /* The glob converted to lower case. */
+	const char *lit; /* Literal part of the pattern for fast paths. */
+	size_t lit_len;  /* Length of the literal part. */
+}
+cglob_t;
+
+/* List of globs in compiled form. */
+struct globs_t
+{
+	cglob_t *list;      /* Globs that aren't of the form "*.ext". */
+	int count;          /* Number of elements in the list. */
+	char **exts;        /* Hash set of lower case extensions of "*.ext" globs
+	                       (with leading dots), empty slots are NULL. */
+	size_t exts_cap;    /* Number of slots in the set (zero or power of two). */
+	size_t exts_count;  /* Number of occupied slots in the set. */
+	size_t max_ext_len; /* Length of the longest extension. */
+};
+
+static int is_literal_ext(const char ext[], const char end[]);
+static int add_glob(globs_t *globs, const char glob[]);
+static int add_ext(globs_t *globs, char ext[]);
+static int has_ext(const globs_t *globs, const char name[], size_t len);
+static char ** find_ext_slot(char *exts[], size_t cap, const char ext[],
+		size_t len);
+static size_t hash_ext(const char ext[], size_t len);
+static int glob_matches(const cglob_t *glob, const char name[], size_t len);
+static int match_wildcards(const char pat[], const char name[]);
+static int equal_icase(const char str[], const char lower[], size_t len);
+static char to_lower(char c);
 
 char *
 globs_to_regex(const char globs[])
@@ -158,5 +205,419 @@ glob_to_regex(const char glob[], int extended)
 	return result;
 }
 
+char **
+globs_get_exts(const char globs[], int *count)
+{
+	char **exts = NULL;
+	int len = 0;
+
+	while(1)
+	{
+		const char *const end = until_first(globs, ',');
+		char *ext;
+
+		if(globs[0] != '*' || globs[1] != '.' || !is_literal_ext(globs + 1, end))
+		{
+			break;
+		}
+
+		ext = format_str("%.*s", (int)(end - (globs + 1)), globs + 1);
+		if(ext == NULL || put_into_string_array(&exts, len, ext) != len + 1)
+		{
+			free(ext);
+			break;
+		}
+		++len;
+
+		if(*end == '\0')
+		{
+			*count = len;
+			return exts;
+		}
+		globs = end + 1;
+	}
+
+	free_string_array(exts, len);
+	*count = 0;
+	return NULL;
+}
+
+/* Checks whether part of a glob consists only of characters that match
+ * themselves (ignoring case) and are ASCII.  Returns non-zero if so, otherwise
+ * zero is returned. */
+static int
+is_literal_ext(const char ext[], const char end[])
+{
+	for(; ext != end; ++ext)
+	{
+		if(*ext < ' ' || *ext > '~' || char_is_one_of("*?[]{}\\/", *ext))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+globs_t *
+globs_compile(const char globs[])
+{
+	globs_t *const compiled = calloc(1, sizeof(*compiled));
+	char *const globs_copy = strdup(globs);
+	char *glob = globs_copy, *state = NULL;
+	int error = (compiled == NULL || globs_copy == NULL);
+
+	while(!error && (glob = split_and_get(glob, ',', &state)) != NULL)
+	{
+		error = add_glob(compiled, glob);
+	}
+	free(globs_copy);
+
+	if(error)
+	{
+		globs_free(compiled);
+		return NULL;
+	}
+	return compiled;
+}
+
+/* Compiles single glob and adds it to the list.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+add_glob(globs_t *globs, const char glob[])
+{
+	const char *p;
+	const char *wildcard;
+	cglob_t *list;
+	cglob_t *cglob;
+	char *pat;
+	char *c;
+	size_t len;
+
+	/* Bracket expressions and escaping aren't supported as well as non-ASCII
+	 * characters, which can be equal to other characters when case is
+	 * ignored. */
+	for(p = glob; *p != '\0'; ++p)
+	{
+		if(*p == '[' || *p == '\\' || (unsigned char)*p >= 0x80)
+		{
+			return 1;
+		}
+	}
+
+	pat = strdup(glob);
+	if(pat == NULL)
+	{
+		return 1;
+	}
+
+	for(c = pat; *c != '\0'; ++c)
+	{
+		*c = to_lower(*c);
+	}
+	len = c - pat;
+
+	/* Leading asterisk is handled separately. */
+	wildcard = strpbrk(pat + (pat[0] == '*'), "*?");
+
+	if(pat[0] == '*' && pat[1] == '.' && wildcard == NULL)
+	{
+		memmove(pat, pat + 1, len);
+		return add_ext(globs, pat);
+	}
+
+	list = realloc(globs->list, sizeof(*list)*(globs->count + 1));
+	if(list == NULL)
+	{
+		free(pat);
+		return 1;
+	}
+	globs->list = list;
+
+	cglob = &globs->list[globs->count++];
+	cglob->pat = pat;
+	cglob->lit = pat;
+	cglob->lit_len = len;
+
+	if(pat[0] == '*')
+	{
+		cglob->kind = (wildcard == NULL) ? GK_SUFFIX : GK_WILDCARD;
+		++cglob->lit;
+		--cglob->lit_len;
+	}
+	else if(wildcard == NULL)
+	{
+		cglob->kind = GK_LITERAL;
+	}
+	else if(wildcard == pat + len - 1 && *wildcard == '*')
+	{
+		cglob->kind = GK_PREFIX;
+		--cglob->lit_len;
+	}
+	else
+	{
+		cglob->kind = GK_WILDCARD;
+	}
+
+	return 0;
+}
+
+/* Adds extension to the hash set of extensions taking ownership of the
+ * string.  Returns zero on success, otherwise non-zero is returned. */
+static int
+add_ext(globs_t *globs, char ext[])
+{
+	const size_t len = strlen(ext);
+	char **slot;
+
+	/* Keep load factor of the set below one half. */
+	if(2U*(globs->exts_count + 1U) > globs->exts_cap)
+	{
+		size_t i;
+		const size_t new_cap = (globs->exts_cap == 0U) ? 16U : 2U*globs->exts_cap;
+		char **const new_exts = calloc(new_cap, sizeof(*new_exts));
+		if(new_exts == NULL)
+		{
+			free(ext);
+			return 1;
+		}
+
+		for(i = 0U; i < globs->exts_cap; ++i)
+		{
+			char *const e = globs->exts[i];
+			if(e != NULL)
+			{
+				*find_ext_slot(new_exts, new_cap, e, strlen(e)) = e;
+			}
+		}
+
+		free(globs->exts);
+		globs->exts = new_exts;
+		globs->exts_cap = new_cap;
+	}
+
+	slot = find_ext_slot(globs->exts, globs->exts_cap, ext, len);
+	if(*slot != NULL)
+	{
+		free(ext);
+		return 0;
+	}
+
+	*slot = ext;
+	++globs->exts_count;
+	if(len > globs->max_ext_len)
+	{
+		globs->max_ext_len = len;
+	}
+	return 0;
+}
+
+void
+globs_free(globs_t *globs)
+{
+	int i;
+	size_t j;
+
+	if(globs == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < globs->count; ++i)
+	{
+		free(globs->list[i].pat);
+	}
+	free(globs->list);
+
+	for(j = 0U; j < globs->exts_cap; ++j)
+	{
+		free(globs->exts[j]);
+	}
+	free(globs->exts);
+
+	free(globs);
+}
+
+int
+globs_matches(const globs_t *globs, const char name[])
+{
+	int i;
+	const size_t len = strlen(name);
+
+	if(has_ext(globs, name, len))
+	{
+		return 1;
+	}
+
+	for(i = 0; i < globs->count; ++i)
+	{
+		if(glob_matches(&globs->list[i], name, len))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Checks whether name is matched by one of "*.ext" globs.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+has_ext(const globs_t *globs, const char name[], size_t len)
+{
+	size_t i;
+
+	/* Leading asterisk doesn't match empty string or leading dot. */
+	if(globs->exts_count == 0U || name[0] == '.')
+	{
+		return 0;
+	}
+
+	/* Extensions start with a dot, so only suffixes that start with a dot and
+	 * aren't longer than the longest extension need to be checked. */
+	i = (len > globs->max_ext_len) ? (len - globs->max_ext_len) : 1U;
+	for(; i < len; ++i)
+	{
+		if(name[i] == '.' &&
+				*find_ext_slot(globs->exts, globs->exts_cap, &name[i], len - i) != NULL)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Finds slot of the hash set of extensions, which either contains the
+ * extension (compared ignoring case) or is empty.  Returns pointer to the
+ * slot. */
+static char **
+find_ext_slot(char *exts[], size_t cap, const char ext[], size_t len)
+{
+	const size_t mask = cap - 1U;
+	size_t i = hash_ext(ext, len) & mask;
+	while(exts[i] != NULL)
+	{
+		if(equal_icase(ext, exts[i], len) && exts[i][len] == '\0')
+		{
+			break;
+		}
+		i = (i + 1U) & mask;
+	}
+	return &exts[i];
+}
+
+/* Computes FNV-1a hash of the extension converted to lower case.  Returns the
+ * hash. */
+static size_t
+hash_ext(const char ext[], size_t len)
+{
+	size_t i;
+	size_t hash = 2166136261U;
+	for(i = 0U; i < len; ++i)
+	{
+		hash = (hash ^ (unsigned char)to_lower(ext[i]))*16777619U;
+	}
+	return hash;
+}
+
+/* Checks whether name of length len is matched by the glob.  Returns non-zero
+ * if so, otherwise zero is returned. */
+static int
+glob_matches(const cglob_t *glob, const char name[], size_t len)
+{
+	/* Leading asterisk is equivalent to "[^.].*" regular expression. */
+	if(glob->pat[0] == '*' && (name[0] == '\0' || name[0] == '.'))
+	{
+		return 0;
+	}
+
+	switch(glob->kind)
+	{
+		case GK_LITERAL:
+			return len == glob->lit_len && equal_icase(name, glob->lit, len);
+		case GK_PREFIX:
+			return len >= glob->lit_len
+			    && equal_icase(name, glob->lit, glob->lit_len);
+		case GK_SUFFIX:
+			return len > glob->lit_len
+			    && equal_icase(name + len - glob->lit_len, glob->lit, glob->lit_len);
+		case GK_WILDCARD:
+			if(glob->pat[0] == '*')
+			{
+				name += utf8_chrw(name);
+			}
+			return match_wildcards(glob->pat, name);
+	}
+	return 0;
+}
+
+/* Matches name against lower case pattern with "*" and "?" wildcards, which
+ * match sequences of characters and single characters respectively.  Returns
+ * non-zero on match, otherwise zero is returned. */
+static int
+match_wildcards(const char pat[], const char name[])
+{
+	const char *star_pat = NULL;
+	const char *star_name = NULL;
+
+	while(*name != '\0')
+	{
+		if(*pat == '*')
+		{
+			star_pat = ++pat;
+			star_name = name;
+		}
+		else if(*pat == '?')
+		{
+			++pat;
+			name += utf8_chrw(name);
+		}
+		else if(*pat != '\0' && *pat == to_lower(*name))
+		{
+			++pat;
+			++name;
+		}
+		else if(star_pat != NULL)
+		{
+			/* Make the last asterisk consume one more character and retry. */
+			star_name += utf8_chrw(star_name);
+			name = star_name;
+			pat = star_pat;
+		}
+		else
+		{
+			return 0;
+		}
+	}
+
+	while(*pat == '*')
+	{
+		++pat;
+	}
+	return *pat == '\0';
+}
+
+/* Compares first len characters of the string with lower case string ignoring
+ * case of ASCII letters.  Returns non-zero if they are equal, otherwise zero is
+ * returned. */
+static int
+equal_icase(const char str[], const char lower[], size_t len)
+{
+	size_t i;
+	for(i = 0U; i < len; ++i)
+	{
+		if(to_lower(str[i]) != lower[i])
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Converts ASCII letter to lower case.  Returns the result. */
+static char
+to_lower(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? (c - 'A' + 'a') : c;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
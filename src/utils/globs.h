@@ -20,13 +20,17 @@
 #define VIFM__UTILS__GLOBS_H__
 
 /* Implements globs by converting them into regular expressions.  They are
- * treated as case insensitive.
+ * treated as case insensitive.  Lists of non-extended globs can also be
+ * compiled into a form that is matched directly with the same result.
  *
  * "*" at the beginning of a non-extended glob doesn't match empty string (e.g.
  * "*doc" should match "doc", but it won't).  This is a limitation of turning
  * list of globs into single regular expression.  Extended glob will match even
  * ".", which should be cut off somewhere else. */
 
+/* Opaque declaration of compiled list of globs. */
+typedef struct globs_t globs_t;
+
 /* Converts comma-separated list of globs into equivalent regular expression.
  * Returns pointer to a newly allocated string, which should be freed by the
  * caller, or NULL if there is not enough memory or no patters are given. */
@@ -38,6 +42,28 @@ char * globs_to_regex(const char globs[]);
  * there is not enough memory. */
 char * glob_to_regex(const char glob[], int extended);
 
+/* Checks whether comma-separated list of globs consists only of globs of the
+ * form "*.ext", where "ext" is a literal ASCII string, and extracts extensions
+ * (along with leading dots).  Such globs match names that end with one of the
+ * extensions ignoring case and don't start with a dot.  Returns list of length
+ * *count, which should be freed by the caller, or NULL if globs are of some
+ * other form or on error. */
+char ** globs_get_exts(const char globs[], int *count);
+
+/* Compiles comma-separated list of globs for matching names without regular
+ * expressions.  Only globs that consist of ASCII characters other than
+ * brackets and backslashes are supported.  Returns compiled globs or NULL if
+ * some of them aren't supported or on error. */
+globs_t * globs_compile(const char globs[]);
+
+/* Frees compiled globs.  globs can be NULL. */
+void globs_free(globs_t *globs);
+
+/* Checks whether the name is matched by any of the globs.  The result is the
+ * same as for case insensitive regular expression produced by
+ * globs_to_regex().  Returns non-zero if so, otherwise zero is returned. */
+int globs_matches(const globs_t *globs, const char name[]);
+
 #endif /* VIFM__UTILS__GLOBS_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -0,0 +1,545 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "hcache.h"
+
+#ifndef _WIN32
+#include <sys/mman.h> /* MAP_FAILED MAP_PRIVATE PROT_READ mmap() munmap() */
+#endif
+#include <sys/stat.h> /* fstat() stat */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* int64_t intptr_t uint32_t uint64_t */
+#include <stdio.h> /* FILE SEEK_SET fclose() fileno() fread() fseek() fwrite()
+                      remove() snprintf() */
+#include <stdlib.h> /* free() malloc() qsort() */
+#include <string.h> /* memcmp() memcpy() memset() strdup() */
+#include <time.h> /* time() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/os.h"
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
+#include "fs.h"
+#include "trie.h"
+#include "utils.h"
+
+/* Identifies format of the cache file. */
+#define MAGIC "VIFMHC\0\1"
+
+/* Records that weren't used for this number of days are dropped on saving. */
+#define MAX_AGE_DAYS 90
+
+/* Flags of a record. */
+enum
+{
+	HAS_SAMPLE = 1 << 0, /* Sample digest is valid. */
+	HAS_FULL   = 1 << 1, /* Full digest is valid. */
+};
+
+/* Beginning of the cache file, followed by count records sorted by device and
+ * inode numbers. */
+typedef struct
+{
+	char magic[8];     /* Always equal to MAGIC. */
+	uint32_t tag;      /* Tag passed to hcache_open(). */
+	uint32_t reserved; /* Padding, always zero. */
+	uint64_t count;    /* Number of records. */
+}
+header_t;
+
+/* Record of the cache file. */
+typedef struct
+{
+	uint64_t dev;    /* Device number. */
+	uint64_t ino;    /* Inode number. */
+	uint64_t size;   /* Size of the file. */
+	int64_t mtime;   /* Modification time in nanoseconds. */
+	int64_t ctime;   /* Change time in nanoseconds. */
+	uint64_t sample; /* Digest of part of the file. */
+	uint64_t full;   /* Digest of the whole file. */
+	uint32_t flags;  /* Set of HAS_* flags.  Record is dropped if it's zero. */
+	uint32_t used;   /* Day of the last use since the Epoch. */
+}
+record_t;
+
+/* Cache of digests. */
+struct hcache_t
+{
+	char *path;         /* Path to the cache file. */
+	unsigned int tag;   /* Description of how digests are computed. */
+
+	void *data;         /* Contents of the file (mapped or read into memory). */
+	size_t size;        /* Size of the data. */
+	int mapped;         /* Whether data was mapped. */
+	const record_t *records; /* Records loaded from the file. */
+	size_t nrecords;    /* Number of records loaded from the file. */
+
+	record_t *added;    /* New or updated records in no particular order. */
+	size_t nadded;      /* Number of elements in the added array. */
+	trie_t *index;      /* Maps device and inode to one-based index in added. */
+	int changed;        /* Whether the cache needs to be saved. */
+
+	uint32_t today;     /* Current day since the Epoch. */
+	pthread_mutex_t lock; /* Protects the whole structure. */
+};
+
+static void load(hcache_t *cache);
+static int save(hcache_t *cache);
+static int write_record(FILE *fp, const record_t *record, uint32_t today,
+		uint64_t *count);
+static int record_cmp(const void *a, const void *b);
+static const record_t * find_record(hcache_t *cache, const hcache_key_t *key);
+static record_t * get_added(hcache_t *cache, const hcache_key_t *key);
+static void format_index_key(const hcache_key_t *key, char buf[], size_t len);
+static int record_matches(const record_t *record, const hcache_key_t *key);
+
+hcache_t *
+hcache_open(const char path[], unsigned int tag)
+{
+	hcache_t *const cache = malloc(sizeof(*cache));
+	if(cache == NULL)
+	{
+		return NULL;
+	}
+
+	memset(cache, 0, sizeof(*cache));
+	cache->path = strdup(path);
+	cache->tag = tag;
+	cache->index = trie_create();
+	cache->today = time(NULL)/(24*60*60);
+	if(cache->path == NULL || cache->index == NULL ||
+			pthread_mutex_init(&cache->lock, NULL) != 0)
+	{
+		trie_free(cache->index);
+		free(cache->path);
+		free(cache);
+		return NULL;
+	}
+
+	load(cache);
+	return cache;
+}
+
+/* Maps or reads cache file into memory.  Broken or incompatible file is
+ * ignored. */
+static void
+load(hcache_t *cache)
+{
+	struct stat st;
+	const header_t *header;
+	FILE *const fp = os_fopen(cache->path, "rb");
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	if(fstat(fileno(fp), &st) != 0 || st.st_size < (off_t)sizeof(header_t))
+	{
+		fclose(fp);
+		return;
+	}
+	cache->size = st.st_size;
+
+#ifndef _WIN32
+	cache->data = mmap(NULL, cache->size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+	if(cache->data == MAP_FAILED)
+	{
+		cache->data = NULL;
+	}
+	cache->mapped = (cache->data != NULL);
+#endif
+
+	if(cache->data == NULL)
+	{
+		cache->data = malloc(cache->size);
+		if(cache->data != NULL &&
+				fread(cache->data, cache->size, 1, fp) != 1)
+		{
+			free(cache->data);
+			cache->data = NULL;
+		}
+	}
+	fclose(fp);
+
+	if(cache->data == NULL)
+	{
+		return;
+	}
+
+	header = cache->data;
+	if(memcmp(header->magic, MAGIC, sizeof(header->magic)) != 0 ||
+			header->tag != cache->tag ||
+			header->count != (cache->size - sizeof(*header))/sizeof(record_t) ||
+			(cache->size - sizeof(*header))%sizeof(record_t) != 0)
+	{
+		/* Rewrite incompatible file on closing. */
+		cache->changed = 1;
+		return;
+	}
+
+	cache->records = (const record_t *)(header + 1);
+	cache->nrecords = header->count;
+}
+
+int
+hcache_close(hcache_t *cache)
+{
+	int error = 0;
+
+	if(cache == NULL)
+	{
+		return 0;
+	}
+
+	if(cache->changed)
+	{
+		error = save(cache);
+	}
+
+#ifndef _WIN32
+	if(cache->mapped)
+	{
+		(void)munmap(cache->data, cache->size);
+		cache->data = NULL;
+	}
+#endif
+	free(cache->data);
+
+	pthread_mutex_destroy(&cache->lock);
+	trie_free(cache->index);
+	free(cache->added);
+	free(cache->path);
+	free(cache);
+	return error;
+}
+
+/* Merges loaded and added records and writes them to a temporary file, which
+ * then replaces the cache file.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+save(hcache_t *cache)
+{
+	char tmp_path[PATH_MAX + 16];
+	header_t header;
+	size_t i, j;
+	int error;
+	FILE *fp;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s_%u", cache->path, get_pid());
+	fp = os_fopen(tmp_path, "wb");
+	if(fp == NULL)
+	{
+		return 1;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(header.magic));
+	header.tag = cache->tag;
+	error = (fwrite(&header, sizeof(header), 1, fp) != 1);
+
+	qsort(cache->added, cache->nadded, sizeof(*cache->added), &record_cmp);
+
+	i = 0U;
+	j = 0U;
+	while(!error && (i < cache->nrecords || j < cache->nadded))
+	{
+		const record_t *record;
+		if(j == cache->nadded)
+		{
+			record = &cache->records[i++];
+		}
+		else if(i == cache->nrecords)
+		{
+			record = &cache->added[j++];
+		}
+		else
+		{
+			const int cmp = record_cmp(&cache->records[i], &cache->added[j]);
+			/* Added records replace loaded ones. */
+			i += (cmp <= 0);
+			record = (cmp < 0) ? &cache->records[i - 1] : &cache->added[j++];
+		}
+
+		error = write_record(fp, record, cache->today, &header.count);
+	}
+
+	error = error
+	     || fseek(fp, 0L, SEEK_SET) != 0
+	     || fwrite(&header, sizeof(header), 1, fp) != 1;
+	error = (fclose(fp) != 0 || error);
+
+	if(error || rename_file(tmp_path, cache->path) != 0)
+	{
+		(void)remove(tmp_path);
+		return 1;
+	}
+	return 0;
+}
+
+/* Writes record to the file unless it's invalid or unused for too long.
+ * Increments *count on writing.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+write_record(FILE *fp, const record_t *record, uint32_t today, uint64_t *count)
+{
+	if(record->flags == 0 || (int64_t)today - record->used > MAX_AGE_DAYS)
+	{
+		return 0;
+	}
+
+	++*count;
+	return (fwrite(record, sizeof(*record), 1, fp) != 1);
+}
+
+/* qsort() and bsearch()-like comparer of records by device and inode numbers.
+ * Returns negative, zero or positive number as usual. */
+static int
+record_cmp(const void *a, const void *b)
+{
+	const record_t *const x = a;
+	const record_t *const y = b;
+	if(x->dev != y->dev)
+	{
+		return (x->dev < y->dev) ? -1 : 1;
+	}
+	if(x->ino != y->ino)
+	{
+		return (x->ino < y->ino) ? -1 : 1;
+	}
+	return 0;
+}
+
+int
+hcache_key_from_file(const char path[], hcache_key_t *key)
+{
+	struct stat st;
+	if(os_stat(path, &st) != 0 || st.st_ino == 0)
+	{
+		return 1;
+	}
+
+	key->dev = st.st_dev;
+	key->ino = st.st_ino;
+	key->size = st.st_size;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+	key->mtime = st.st_mtim.tv_sec*1000000000LL + st.st_mtim.tv_nsec;
+	key->ctime = st.st_ctim.tv_sec*1000000000LL + st.st_ctim.tv_nsec;
+#else
+	key->mtime = st.st_mtime*1000000000LL;
+	key->ctime = st.st_ctime*1000000000LL;
+#endif
+	return 0;
+}
+
+int
+hcache_get(hcache_t *cache, const hcache_key_t *key, hcache_value_t *value)
+{
+	const record_t *record;
+	int found = 0;
+
+	if(cache == NULL)
+	{
+		return 1;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+
+	record = find_record(cache, key);
+	if(record != NULL && !record_matches(record, key))
+	{
+		/* The file has changed, forget about it. */
+		record_t *const added = get_added(cache, key);
+		if(added != NULL)
+		{
+			added->flags = 0;
+		}
+		cache->changed = 1;
+	}
+	else if(record != NULL && record->flags != 0)
+	{
+		value->sample = record->sample;
+		value->full = record->full;
+		value->has_sample = ((record->flags & HAS_SAMPLE) != 0);
+		value->has_full = ((record->flags & HAS_FULL) != 0);
+		found = 1;
+
+		/* Keep track of when the record was used last time, but don't rewrite the
+		 * file just for this more often than once a day. */
+		if(record->used != cache->today)
+		{
+			record_t *const added = get_added(cache, key);
+			if(added != NULL)
+			{
+				added->used = cache->today;
+				cache->changed = 1;
+			}
+		}
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+	return !found;
+}
+
+void
+hcache_put(hcache_t *cache, const hcache_key_t *key,
+		const hcache_value_t *value)
+{
+	record_t *record;
+
+	if(cache == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+
+	record = get_added(cache, key);
+	if(record != NULL)
+	{
+		if(value->has_sample)
+		{
+			record->sample = value->sample;
+			record->flags |= HAS_SAMPLE;
+		}
+		if(value->has_full)
+		{
+			record->full = value->full;
+			record->flags |= HAS_FULL;
+		}
+		record->used = cache->today;
+		cache->changed = 1;
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+}
+
+/* Looks up record for the file among added and loaded ones.  Returns the record
+ * or NULL if there is none. */
+static const record_t *
+find_record(hcache_t *cache, const hcache_key_t *key)
+{
+	char name[64];
+	void *data;
+	size_t l, r;
+
+	format_index_key(key, name, sizeof(name));
+	if(trie_get(cache->index, name, &data) == 0)
+	{
+		return &cache->added[(intptr_t)data - 1];
+	}
+
+	l = 0U;
+	r = cache->nrecords;
+	while(l < r)
+	{
+		const size_t m = l + (r - l)/2U;
+		const record_t *const record = &cache->records[m];
+		if(record->dev < key->dev ||
+				(record->dev == key->dev && record->ino < key->ino))
+		{
+			l = m + 1U;
+		}
+		else if(record->dev == key->dev && record->ino == key->ino)
+		{
+			return record;
+		}
+		else
+		{
+			r = m;
+		}
+	}
+	return NULL;
+}
+
+/* Retrieves modifiable record for the file, which is created from loaded one or
+ * from scratch when necessary.  Record of changed file is reset.  Returns the
+ * record or NULL on error. */
+static record_t *
+get_added(hcache_t *cache, const hcache_key_t *key)
+{
+	char name[64];
+	void *data;
+	record_t *record;
+
+	format_index_key(key, name, sizeof(name));
+	if(trie_get(cache->index, name, &data) == 0)
+	{
+		record = &cache->added[(intptr_t)data - 1];
+	}
+	else
+	{
+		const record_t *const loaded = find_record(cache, key);
+
+		record_t *const added = reallocarray(cache->added, cache->nadded + 1U,
+				sizeof(*added));
+		if(added == NULL)
+		{
+			return NULL;
+		}
+		cache->added = added;
+
+		if(trie_set(cache->index, name, (void *)(intptr_t)(cache->nadded + 1U))
+				!= 0)
+		{
+			return NULL;
+		}
+
+		record = &cache->added[cache->nadded++];
+		if(loaded != NULL)
+		{
+			*record = *loaded;
+		}
+		else
+		{
+			memset(record, 0, sizeof(*record));
+			record->dev = key->dev;
+			record->ino = key->ino;
+			record->used = cache->today;
+		}
+	}
+
+	if(!record_matches(record, key))
+	{
+		record->size = key->size;
+		record->mtime = key->mtime;
+		record->ctime = key->ctime;
+		record->flags = 0;
+	}
+	return record;
+}
+
+/* Formats key of the index of added records. */
+static void
+format_index_key(const hcache_key_t *key, char buf[], size_t len)
+{
+	snprintf(buf, len, "%llx:%llx", key->dev, key->ino);
+}
+
+/* Checks whether record describes current state of the file.  Returns non-zero
+ * if so, otherwise zero is returned. */
+static int
+record_matches(const record_t *record, const hcache_key_t *key)
+{
+	return record->size == key->size
+	    && record->mtime == key->mtime
+	    && record->ctime == key->ctime;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,77 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__HCACHE_H__
+#define VIFM__UTILS__HCACHE_H__
+
+/* Persistent cache of digests of contents of files.  Files are identified by
+ * device and inode numbers, while their size and timestamps are used to detect
+ * changes.  The cache is stored in a binary file which is memory mapped on
+ * loading and rewritten (dropping stale and long unused records) on closing if
+ * anything has changed.  All functions accept NULL cache and do nothing in
+ * that case.  Getting and putting values is thread-safe. */
+
+/* Opaque declaration of the cache type. */
+typedef struct hcache_t hcache_t;
+
+/* Identity and state of a file. */
+typedef struct
+{
+	unsigned long long dev;  /* Device number. */
+	unsigned long long ino;  /* Inode number. */
+	unsigned long long size; /* Size of the file. */
+	long long mtime;         /* Modification time in nanoseconds. */
+	long long ctime;         /* Change time in nanoseconds. */
+}
+hcache_key_t;
+
+/* Digests associated with a file. */
+typedef struct
+{
+	unsigned long long sample; /* Digest of part of the file. */
+	unsigned long long full;   /* Digest of the whole file. */
+	int has_sample;            /* Whether sample field is set. */
+	int has_full;              /* Whether full field is set. */
+}
+hcache_value_t;
+
+/* Loads cache from the file, which doesn't need to exist.  The tag describes
+ * how digests were computed, the file is ignored if its tag is different.
+ * Returns the cache or NULL on error. */
+hcache_t * hcache_open(const char path[], unsigned int tag);
+
+/* Saves cache if it was changed and frees it.  Returns zero on success,
+ * otherwise non-zero is returned. */
+int hcache_close(hcache_t *cache);
+
+/* Fills key for the file.  Returns zero on success, otherwise non-zero is
+ * returned (e.g., when file system doesn't provide inode numbers). */
+int hcache_key_from_file(const char path[], hcache_key_t *key);
+
+/* Looks up digests of the file.  Outdated record is dropped.  Returns zero and
+ * fills *value if the file is known, otherwise non-zero is returned. */
+int hcache_get(hcache_t *cache, const hcache_key_t *key, hcache_value_t *value);
+
+/* Stores digests of the file merging them with already known ones. */
+void hcache_put(hcache_t *cache, const hcache_key_t *key,
+		const hcache_value_t *value);
+
+#endif /* VIFM__UTILS__HCACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
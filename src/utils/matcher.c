@@ -42,14 +42,15 @@ MType;
 /* Wrapper for a regular expression, its state and compiled form. */
 struct matcher_t
 {
-	MType type;    /* Type of the matcher's pattern. */
-	char *expr;    /* User-entered pattern. */
-	char *undec;   /* User-entered pattern undecorated pattern. */
-	char *raw;     /* Raw stripped value (regular expression). */
-	int full_path; /* Matches full path instead of just file name. */
-	int cflags;    /* Regular expression compilation flags. */
-	int negated;   /* Whether match is inverted. */
-	regex_t regex; /* The expression in compiled form. */
+	MType type;     /* Type of the matcher's pattern. */
+	char *expr;     /* User-entered pattern. */
+	char *undec;    /* User-entered pattern undecorated pattern. */
+	char *raw;      /* Raw stripped value (regular expression). */
+	int full_path;  /* Matches full path instead of just file name. */
+	int cflags;     /* Regular expression compilation flags. */
+	int negated;    /* Whether match is inverted. */
+	regex_t regex;  /* The expression in compiled form. */
+	globs_t *globs; /* Globs compiled for matching without regex or NULL. */
 };
 
 static int is_full_path(const char expr[], int re, int glob, int *strip);
@@ -95,6 +96,7 @@ matcher_alloc(const char expr[], int cs_by_def, int glob_by_def,
 	{
 		free(m.raw);
 		free(m.undec);
+		globs_free(m.globs);
 		return NULL;
 	}
 
@@ -232,6 +234,10 @@ parse_glob(matcher_t *m, int strip, char **error)
 	free(m->raw);
 	m->raw = re;
 
+	/* Regular expression is still needed to validate the globs and as a
+	 * fallback for unsupported ones. */
+	m->globs = globs_compile(m->undec);
+
 	m->cflags = REG_EXTENDED | REG_ICASE;
 	return 0;
 }
@@ -288,6 +294,9 @@ matcher_clone(const matcher_t *matcher)
 	clone->expr = strdup(matcher->expr);
 	clone->raw = strdup(matcher->raw);
 	clone->undec = strdup(matcher->undec);
+	clone->globs = (matcher->globs == NULL || clone->undec == NULL)
+	             ? NULL
+	             : globs_compile(clone->undec);
 
 	err = regcomp(&clone->regex, matcher->raw, matcher->cflags);
 
@@ -320,6 +329,7 @@ free_matcher_items(matcher_t *matcher)
 	free(matcher->raw);
 	free(matcher->undec);
 	regfree(&matcher->regex);
+	globs_free(matcher->globs);
 }
 
 int
@@ -338,9 +348,26 @@ matcher_matches(const matcher_t *matcher, const char path[])
 		path = get_last_path_component(path);
 	}
 
+	if(matcher->globs != NULL)
+	{
+		return globs_matches(matcher->globs, path)^matcher->negated;
+	}
+
 	return (regexec(&matcher->regex, path, 0, NULL, 0) == 0)^matcher->negated;
 }
 
+char **
+matcher_get_exts(const matcher_t *matcher, int *count)
+{
+	if(matcher->type != MT_GLOBS || matcher->negated || matcher->full_path)
+	{
+		*count = 0;
+		return NULL;
+	}
+
+	return globs_get_exts(matcher->undec, count);
+}
+
 const char *
 matcher_get_undec(const matcher_t *matcher)
 {
@@ -56,6 +56,11 @@ int matcher_includes(const matcher_t *matcher, const matcher_t *like);
  * otherwise zero is returned. */
 int matcher_is_full_path(const matcher_t *matcher);
 
+/* Checks whether matcher is a list of globs like "*.ext" matched against file
+ * name, see globs_get_exts().  Returns list of extensions of length *count,
+ * which should be freed by the caller, or NULL. */
+char ** matcher_get_exts(const matcher_t *matcher, int *count);
+
 #endif /* VIFM__UTILS__MATCHER_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -210,6 +210,18 @@ matchers_get_expr(const matchers_t *matchers)
 	return matchers->expr;
 }
 
+char **
+matchers_get_exts(const matchers_t *matchers, int *count)
+{
+	if(matchers->count != 1)
+	{
+		*count = 0;
+		return NULL;
+	}
+
+	return matcher_get_exts(matchers->list[0], count);
+}
+
 int
 matchers_includes(const matchers_t *matchers, const matchers_t *like)
 {
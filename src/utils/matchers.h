@@ -46,6 +46,11 @@ int matchers_match_dir(const matchers_t *matchers, const char path[]);
 /* Retrieves original matcher expression.  Returns the expression. */
 const char * matchers_get_expr(const matchers_t *matchers);
 
+/* Checks whether matchers consist of single list of globs like "*.ext" that is
+ * matched against file name, see globs_get_exts().  Returns list of extensions
+ * of length *count, which should be freed by the caller, or NULL. */
+char ** matchers_get_exts(const matchers_t *matchers, int *count);
+
 /* Checks whether everything matched by the matcher is also matched by the like.
  * Returns non-zero if so, otherwise zero is returned. */
 int matchers_includes(const matchers_t *matchers, const matchers_t *like);
@@ -0,0 +1,359 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "parallel.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h> /* sysconf() */
+#endif
+
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_* */
+
+#include <stddef.h> /* size_t */
+#include <stdlib.h> /* free() malloc() */
+#include <time.h> /* CLOCK_REALTIME clock_gettime() timespec */
+
+#include "../compat/reallocarray.h"
+#include "macros.h"
+
+/* State shared among threads that process a range. */
+typedef struct
+{
+	pthread_mutex_t lock; /* Protects next field. */
+	size_t next;          /* Beginning of next unprocessed chunk. */
+	size_t count;         /* Size of the whole range. */
+	size_t chunk_size;    /* Maximum size of a chunk. */
+	par_range_func func;  /* Processing function. */
+	void *arg;            /* Argument for the function. */
+}
+par_state_t;
+
+/* Queue of tasks along with state of their processing. */
+struct par_queue_t
+{
+	pthread_mutex_t lock; /* Protects all fields below. */
+	pthread_cond_t cond;  /* Signals new tasks and end of processing. */
+	void **tasks;         /* Stack of pending tasks. */
+	size_t ntasks;        /* Number of pending tasks. */
+	size_t capacity;      /* Number of tasks that fit into the stack. */
+	int nbusy;            /* Number of tasks that are being processed. */
+	int cancelled;        /* Whether processing was cancelled. */
+	par_task_func func;   /* Processing function. */
+	void *arg;            /* Argument for the function. */
+};
+
+static void * worker(void *arg);
+static int take_chunk(par_state_t *state, size_t *from, size_t *to);
+static void * queue_worker(void *arg);
+static void * take_task(par_queue_t *queue);
+
+int
+par_get_nthreads(void)
+{
+	long ncpus;
+
+#ifndef _WIN32
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	ncpus = info.dwNumberOfProcessors;
+#endif
+
+	if(ncpus < 1)
+	{
+		return 1;
+	}
+	return MIN(ncpus, PAR_MAX_THREADS);
+}
+
+void
+par_for(size_t count, size_t chunk_size, int nthreads, par_range_func func,
+		void *arg)
+{
+	int i;
+	int nspawned;
+	pthread_t *threads;
+	par_state_t state = {
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.next = 0U,
+		.count = count,
+		.chunk_size = (chunk_size == 0U ? 1U : chunk_size),
+		.func = func,
+		.arg = arg,
+	};
+
+	if(nthreads <= 0)
+	{
+		nthreads = par_get_nthreads();
+	}
+
+	/* Don't start threads that won't get any work. */
+	nthreads = MIN((size_t)nthreads,
+			(count + state.chunk_size - 1U)/state.chunk_size);
+
+	nspawned = 0;
+	threads = (nthreads > 1) ? malloc(sizeof(*threads)*(nthreads - 1)) : NULL;
+	if(threads != NULL)
+	{
+		for(i = 0; i < nthreads - 1; ++i)
+		{
+			if(pthread_create(&threads[i], NULL, &worker, &state) != 0)
+			{
+				break;
+			}
+			++nspawned;
+		}
+	}
+
+	/* Calling thread participates in processing as well and handles everything
+	 * if no threads were started. */
+	(void)worker(&state);
+
+	for(i = 0; i < nspawned; ++i)
+	{
+		(void)pthread_join(threads[i], NULL);
+	}
+	free(threads);
+
+	pthread_mutex_destroy(&state.lock);
+}
+
+/* Entry point of processing threads.  Returns NULL. */
+static void *
+worker(void *arg)
+{
+	par_state_t *const state = arg;
+
+	size_t from, to;
+	while(take_chunk(state, &from, &to))
+	{
+		state->func(from, to, state->arg);
+	}
+
+	return NULL;
+}
+
+/* Picks next unprocessed chunk of the range.  Returns non-zero if *from and *to
+ * were set, otherwise zero is returned. */
+static int
+take_chunk(par_state_t *state, size_t *from, size_t *to)
+{
+	int taken = 0;
+
+	pthread_mutex_lock(&state->lock);
+	if(state->next < state->count)
+	{
+		*from = state->next;
+		*to = MIN(state->next + state->chunk_size, state->count);
+		state->next = *to;
+		taken = 1;
+	}
+	pthread_mutex_unlock(&state->lock);
+
+	return taken;
+}
+
+int
+par_run(void *task, int nthreads, par_task_func func, par_poll_func poll,
+		void *arg)
+{
+	int i;
+	int nspawned;
+	int cancelled;
+	pthread_t *threads;
+	par_queue_t queue = {
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.cond = PTHREAD_COND_INITIALIZER,
+		.tasks = NULL,
+		.ntasks = 0U,
+		.capacity = 0U,
+		.nbusy = 0,
+		.cancelled = 0,
+		.func = func,
+		.arg = arg,
+	};
+
+	if(par_push(&queue, task) != 0)
+	{
+		return 0;
+	}
+
+	if(nthreads <= 0)
+	{
+		nthreads = par_get_nthreads();
+	}
+
+	nspawned = 0;
+	threads = malloc(sizeof(*threads)*nthreads);
+	if(threads != NULL)
+	{
+		for(i = 0; i < nthreads; ++i)
+		{
+			if(pthread_create(&threads[i], NULL, &queue_worker, &queue) != 0)
+			{
+				break;
+			}
+			++nspawned;
+		}
+	}
+
+	if(nspawned == 0)
+	{
+		/* Do all the work on this thread. */
+		while((task = take_task(&queue)) != NULL)
+		{
+			func(&queue, task, arg);
+			--queue.nbusy;
+			if(poll != NULL && poll(arg))
+			{
+				queue.cancelled = 1;
+				break;
+			}
+		}
+	}
+	else
+	{
+		pthread_mutex_lock(&queue.lock);
+		while(!queue.cancelled && (queue.ntasks != 0U || queue.nbusy != 0))
+		{
+			struct timespec ts;
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_nsec += 100*1000*1000;
+			if(ts.tv_nsec >= 1000*1000*1000)
+			{
+				ts.tv_nsec -= 1000*1000*1000;
+				++ts.tv_sec;
+			}
+			(void)pthread_cond_timedwait(&queue.cond, &queue.lock, &ts);
+
+			pthread_mutex_unlock(&queue.lock);
+			cancelled = (poll != NULL && poll(arg));
+			pthread_mutex_lock(&queue.lock);
+
+			if(cancelled)
+			{
+				queue.cancelled = 1;
+				pthread_cond_broadcast(&queue.cond);
+			}
+		}
+		pthread_mutex_unlock(&queue.lock);
+	}
+
+	for(i = 0; i < nspawned; ++i)
+	{
+		(void)pthread_join(threads[i], NULL);
+	}
+	free(threads);
+
+	cancelled = queue.cancelled;
+
+	free(queue.tasks);
+	pthread_cond_destroy(&queue.cond);
+	pthread_mutex_destroy(&queue.lock);
+
+	return cancelled;
+}
+
+int
+par_push(par_queue_t *queue, void *task)
+{
+	int error = 0;
+
+	pthread_mutex_lock(&queue->lock);
+	if(queue->ntasks == queue->capacity)
+	{
+		const size_t capacity = (queue->capacity == 0U) ? 64U : queue->capacity*2U;
+		void **const tasks = reallocarray(queue->tasks, capacity, sizeof(*tasks));
+		if(tasks == NULL)
+		{
+			error = 1;
+		}
+		else
+		{
+			queue->tasks = tasks;
+			queue->capacity = capacity;
+		}
+	}
+	if(!error)
+	{
+		queue->tasks[queue->ntasks++] = task;
+		pthread_cond_broadcast(&queue->cond);
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	return error;
+}
+
+/* Entry point of threads that process queue of tasks.  Returns NULL. */
+static void *
+queue_worker(void *arg)
+{
+	par_queue_t *const queue = arg;
+
+	pthread_mutex_lock(&queue->lock);
+	while(1)
+	{
+		void *task;
+
+		/* Wait until there is something to do or nothing will be left to do. */
+		while(queue->ntasks == 0U && queue->nbusy != 0 && !queue->cancelled)
+		{
+			pthread_cond_wait(&queue->cond, &queue->lock);
+		}
+
+		if(queue->cancelled || queue->ntasks == 0U)
+		{
+			break;
+		}
+
+		task = queue->tasks[--queue->ntasks];
+		++queue->nbusy;
+		pthread_mutex_unlock(&queue->lock);
+
+		queue->func(queue, task, queue->arg);
+
+		pthread_mutex_lock(&queue->lock);
+		if(--queue->nbusy == 0 && queue->ntasks == 0U)
+		{
+			/* Wake up everybody to let them know that processing is over. */
+			pthread_cond_broadcast(&queue->cond);
+		}
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	return NULL;
+}
+
+/* Picks next task on the calling thread when no other threads are running.
+ * Returns the task or NULL if there are no more tasks. */
+static void *
+take_task(par_queue_t *queue)
+{
+	if(queue->ntasks == 0U)
+	{
+		return NULL;
+	}
+	++queue->nbusy;
+	return queue->tasks[--queue->ntasks];
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,75 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__PARALLEL_H__
+#define VIFM__UTILS__PARALLEL_H__
+
+#include <stddef.h> /* size_t */
+
+/* Maximum number of threads returned by par_get_nthreads() and accepted from
+ * the user.  There is no point in creating too many threads. */
+#define PAR_MAX_THREADS 16
+
+/* Simple means of processing independent items on several threads.  Mainly
+ * meant for hiding latency of blocking calls (like file system queries). */
+
+/* Queue of tasks processed by par_run(). */
+typedef struct par_queue_t par_queue_t;
+
+/* Callback that processes items of the [from; to) range.  Might be called
+ * concurrently with different ranges. */
+typedef void (*par_range_func)(size_t from, size_t to, void *arg);
+
+/* Callback that processes a single task and can add new ones to the queue.
+ * Might be called concurrently with different tasks. */
+typedef void (*par_task_func)(par_queue_t *queue, void *task, void *arg);
+
+/* Callback that is periodically invoked on the calling thread of par_run().
+ * Returns non-zero to cancel processing of tasks, otherwise zero is
+ * returned. */
+typedef int (*par_poll_func)(void *arg);
+
+/* Retrieves number of threads that is considered to be reasonable for parallel
+ * processing.  Returns positive number. */
+int par_get_nthreads(void);
+
+/* Processes [0; count) range in chunks of at most chunk_size items using up to
+ * nthreads threads (including calling one).  Non-positive nthreads means
+ * par_get_nthreads().  Falls back to processing on calling thread on failure
+ * to spawn threads.  Returns after all items are processed. */
+void par_for(size_t count, size_t chunk_size, int nthreads,
+		par_range_func func, void *arg);
+
+/* Processes dynamically growing set of tasks starting with the specified one
+ * using up to nthreads threads (non-positive value means par_get_nthreads()).
+ * Calling thread only invokes poll (can be NULL) about ten times per second
+ * unless threads can't be spawned, in which case it processes all tasks itself
+ * calling poll after each of them.  Returns non-zero if processing was
+ * cancelled by poll, in which case some tasks might remain unprocessed,
+ * otherwise zero is returned. */
+int par_run(void *task, int nthreads, par_task_func func, par_poll_func poll,
+		void *arg);
+
+/* Adds task to the queue.  Returns zero on success, otherwise non-zero is
+ * returned and the task won't be processed. */
+int par_push(par_queue_t *queue, void *task);
+
+#endif /* VIFM__UTILS__PARALLEL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
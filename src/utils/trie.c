@@ -18,49 +18,67 @@
 
 #include "trie.h"
 
-#include <stdlib.h> /* calloc() free() */
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint32_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* strcmp() */
 
-/* Trie node. */
+#include "arena.h"
+
+/* The "trie" is actually an open-addressing hash table with linear probing,
+ * keys of which are stored in an arena.  This is a lot faster and takes less
+ * memory than a tree with a node per character, especially for long paths.
+ * The name stays for compatibility. */
+
+/* Initial number of slots, must be a power of two. */
+#define INITIAL_CAPACITY 16U
+
+/* Single slot of the hash table. */
+typedef struct
+{
+	char *key;     /* Key or NULL for an unused slot. */
+	void *data;    /* Data associated with the key. */
+	uint32_t hash; /* Cached hash of the key. */
+}
+slot_t;
+
+/* Hash table. */
 struct trie_t
 {
-	trie_t *left;     /* Nodes with values less than value. */
-	trie_t *right;    /* Nodes with values greater than value. */
-	trie_t *children; /* Child nodes. */
-	void *data;       /* Data associated with the key. */
-	char value;       /* Value of the node. */
-	char exists;      /* Whether this node exists or it's an intermediate node. */
+	slot_t *slots;   /* Array of slots (NULL until first insertion). */
+	size_t capacity; /* Number of slots, zero or a power of two. */
+	size_t count;    /* Number of used slots. */
+	arena_t *keys;   /* Storage of keys. */
 };
 
-static trie_t *clone_nodes(trie_t *trie, int *error);
-static void get_or_create(trie_t *trie, const char str[], void *data,
-		int *result);
+static void free_slots(trie_t *trie);
+static slot_t * find_slot(const trie_t *trie, const char str[], uint32_t hash);
+static int grow(trie_t *trie);
+static uint32_t hash_str(const char str[]);
 
 trie_t *
 trie_create(void)
 {
-	return calloc(1U, sizeof(struct trie_t));
-}
-
-trie_t *
-trie_clone(trie_t *trie)
-{
-	int error = 0;
+	trie_t *const trie = calloc(1U, sizeof(*trie));
+	if(trie == NULL)
+	{
+		return NULL;
+	}
 
-	trie = clone_nodes(trie, &error);
-	if(error)
+	trie->keys = arena_create();
+	if(trie->keys == NULL)
 	{
-		trie_free(trie);
+		free(trie);
 		return NULL;
 	}
 
 	return trie;
 }
 
-/* Clones node and all its relatives.  Sets *error to non-zero on error.
- * Returns new node. */
-static trie_t *
-clone_nodes(trie_t *trie, int *error)
+trie_t *
+trie_clone(trie_t *trie)
 {
+	size_t i;
 	trie_t *new_trie;
 
 	if(trie == NULL)
@@ -68,17 +86,43 @@ clone_nodes(trie_t *trie, int *error)
 		return NULL;
 	}
 
-	new_trie = malloc(sizeof(*new_trie));
+	new_trie = trie_create();
 	if(new_trie == NULL)
 	{
-		*error = 1;
 		return NULL;
 	}
 
-	*new_trie = *trie;
-	new_trie->left = clone_nodes(trie->left, error);
-	new_trie->right = clone_nodes(trie->right, error);
-	new_trie->children = clone_nodes(trie->children, error);
+	if(trie->capacity == 0U)
+	{
+		return new_trie;
+	}
+
+	new_trie->slots = calloc(trie->capacity, sizeof(*new_trie->slots));
+	if(new_trie->slots == NULL)
+	{
+		trie_free(new_trie);
+		return NULL;
+	}
+	new_trie->capacity = trie->capacity;
+
+	/* Layout of slots doesn't depend on anything but keys, so just copy them. */
+	for(i = 0U; i < trie->capacity; ++i)
+	{
+		const slot_t *const slot = &trie->slots[i];
+		if(slot->key == NULL)
+		{
+			continue;
+		}
+
+		new_trie->slots[i] = *slot;
+		new_trie->slots[i].key = arena_strdup(new_trie->keys, slot->key);
+		if(new_trie->slots[i].key == NULL)
+		{
+			trie_free(new_trie);
+			return NULL;
+		}
+		++new_trie->count;
+	}
 
 	return new_trie;
 }
@@ -88,9 +132,7 @@ trie_free(trie_t *trie)
 {
 	if(trie != NULL)
 	{
-		trie_free(trie->left);
-		trie_free(trie->right);
-		trie_free(trie->children);
+		free_slots(trie);
 		free(trie);
 	}
 }
@@ -98,14 +140,35 @@ trie_free(trie_t *trie)
 void
 trie_free_with_data(trie_t *trie, trie_free_func free_func)
 {
-	if(trie != NULL)
+	size_t i;
+
+	if(trie == NULL)
 	{
-		trie_free_with_data(trie->left, free_func);
-		trie_free_with_data(trie->right, free_func);
-		trie_free_with_data(trie->children, free_func);
-		free_func(trie->data);
-		free(trie);
+		return;
+	}
+
+	for(i = 0U; i < trie->capacity; ++i)
+	{
+		if(trie->slots[i].key != NULL)
+		{
+			free_func(trie->slots[i].data);
+		}
+	}
+
+	trie_free(trie);
+}
+
+/* Frees keys and slots of the trie. */
+static void
+free_slots(trie_t *trie)
+{
+	size_t i;
+	for(i = 0U; i < trie->capacity; ++i)
+	{
+		arena_release(trie->slots[i].key);
 	}
+	arena_free(trie->keys);
+	free(trie->slots);
 }
 
 int
@@ -117,91 +180,137 @@ trie_put(trie_t *trie, const char str[])
 int
 trie_set(trie_t *trie, const char str[], const void *data)
 {
-	int result;
+	uint32_t hash;
+	slot_t *slot;
 
 	if(trie == NULL)
 	{
 		return -1;
 	}
 
-	get_or_create(trie, str, (void *)data, &result);
-	return result;
-}
+	hash = hash_str(str);
+	slot = find_slot(trie, str, hash);
+	if(slot != NULL && slot->key != NULL)
+	{
+		slot->data = (void *)data;
+		return 1;
+	}
 
-/* Gets node which might involve its creation.  Sets *return to negative value
- * on error, to zero on successful insertion and to positive number if element
- * was already in the trie. */
-static void
-get_or_create(trie_t *trie, const char str[], void *data, int *result)
-{
-	trie_t **link = &trie;
-	while(1)
+	/* Keep load factor below 3/4. */
+	if(4U*(trie->count + 1U) > 3U*trie->capacity)
 	{
-		/* Create inexistent node. */
-		if(trie == NULL)
+		if(grow(trie) != 0)
 		{
-			trie = trie_create();
-			if(trie == NULL)
-			{
-				*result = -1;
-				break;
-			}
-			trie->value = *str;
-			*link = trie;
+			return -1;
 		}
+		slot = find_slot(trie, str, hash);
+	}
 
-		if(trie->value == *str)
-		{
-			if(*str == '\0')
-			{
-				/* Found full match. */
-				*result = (trie->exists != 0);
-				trie->exists = 1;
-				trie->data = data;
-				break;
-			}
-
-			link = &trie->children;
-			++str;
-		}
-		else
-		{
-			link = (*str < trie->value) ? &trie->left : &trie->right;
-		}
-		trie = *link;
+	slot->key = arena_strdup(trie->keys, str);
+	if(slot->key == NULL)
+	{
+		return -1;
 	}
+	slot->data = (void *)data;
+	slot->hash = hash;
+	++trie->count;
+	return 0;
 }
 
 int
 trie_get(trie_t *trie, const char str[], void **data)
 {
-	while(1)
+	const slot_t *slot;
+
+	if(trie == NULL)
 	{
-		if(trie == NULL)
+		return 1;
+	}
+
+	slot = find_slot(trie, str, hash_str(str));
+	if(slot == NULL || slot->key == NULL)
+	{
+		return 1;
+	}
+
+	*data = slot->data;
+	return 0;
+}
+
+/* Finds slot that holds the key or where it should be inserted.  Returns the
+ * slot or NULL if the table has no slots. */
+static slot_t *
+find_slot(const trie_t *trie, const char str[], uint32_t hash)
+{
+	size_t i;
+	const size_t mask = trie->capacity - 1U;
+
+	if(trie->capacity == 0U)
+	{
+		return NULL;
+	}
+
+	for(i = hash & mask; ; i = (i + 1U) & mask)
+	{
+		slot_t *const slot = &trie->slots[i];
+		if(slot->key == NULL ||
+				(slot->hash == hash && strcmp(slot->key, str) == 0))
 		{
-			return 1;
+			return slot;
 		}
+	}
+}
+
+/* Doubles number of slots in the table.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+grow(trie_t *trie)
+{
+	size_t i;
+	const size_t capacity = (trie->capacity == 0U)
+	                      ? INITIAL_CAPACITY
+	                      : trie->capacity*2U;
+	slot_t *const old_slots = trie->slots;
+	const size_t old_capacity = trie->capacity;
 
-		if(trie->value == *str)
+	slot_t *const slots = calloc(capacity, sizeof(*slots));
+	if(slots == NULL)
+	{
+		return 1;
+	}
+
+	trie->slots = slots;
+	trie->capacity = capacity;
+
+	for(i = 0U; i < old_capacity; ++i)
+	{
+		const slot_t *const old = &old_slots[i];
+		if(old->key != NULL)
 		{
-			if(*str == '\0')
+			size_t j = old->hash & (capacity - 1U);
+			while(slots[j].key != NULL)
 			{
-				/* Found full match. */
-				if(!trie->exists)
-				{
-					return 1;
-				}
-				*data = trie->data;
-				return 0;
+				j = (j + 1U) & (capacity - 1U);
 			}
-
-			trie = trie->children;
-			++str;
-			continue;
+			slots[j] = *old;
 		}
+	}
+
+	free(old_slots);
+	return 0;
+}
 
-		trie = (*str < trie->value) ? trie->left : trie->right;
+/* Computes FNV-1a hash of a string.  Returns the hash. */
+static uint32_t
+hash_str(const char str[])
+{
+	uint32_t hash = 2166136261U;
+	while(*str != '\0')
+	{
+		hash ^= (unsigned char)*str++;
+		hash *= 16777619U;
 	}
+	return hash;
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
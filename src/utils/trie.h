@@ -21,6 +21,9 @@
 
 #include <stddef.h> /* NULL */
 
+/* Set of strings with optional data associated with each of them.  Despite the
+ * name, it's implemented as a hash table. */
+
 /* Declaration of opaque trie type. */
 typedef struct trie_t trie_t;
 
@@ -0,0 +1,104 @@
+#include <stic.h>
+
+#include <stdio.h> /* printf() snprintf() */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* strdup() */
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() */
+
+#include "../../src/utils/arena.h"
+
+/* Compares allocation of names of files with strdup() against arena, which is
+ * what loading of file lists does. */
+
+/* Number of names in a single "directory". */
+#define NNAMES 500000
+/* Number of times "directory" is loaded. */
+#define NLOADS 5
+
+static double now(void);
+
+/* Names to be copied. */
+static char (*src)[32];
+/* Copies of names of the current load. */
+static char **names;
+
+SETUP_ONCE()
+{
+	int i;
+
+	src = malloc(sizeof(*src)*NNAMES);
+	names = malloc(sizeof(*names)*NNAMES);
+
+	for(i = 0; i < NNAMES; ++i)
+	{
+		snprintf(src[i], sizeof(src[i]), "file-name-%06d.txt", i);
+	}
+}
+
+TEARDOWN_ONCE()
+{
+	free(src);
+	free(names);
+}
+
+TEST(strdup_names)
+{
+	int load, i;
+	int failed = 0;
+	const double start = now();
+
+	for(load = 0; load < NLOADS; ++load)
+	{
+		for(i = 0; i < NNAMES; ++i)
+		{
+			names[i] = strdup(src[i]);
+			failed += (names[i] == NULL);
+		}
+		for(i = 0; i < NNAMES; ++i)
+		{
+			free(names[i]);
+		}
+	}
+
+	printf("strdup(): %.3f s\n", now() - start);
+	assert_int_equal(0, failed);
+}
+
+TEST(arena_names)
+{
+	int load, i;
+	int failed = 0;
+	const double start = now();
+
+	for(load = 0; load < NLOADS; ++load)
+	{
+		arena_t *const arena = arena_create();
+		assert_non_null(arena);
+
+		for(i = 0; i < NNAMES; ++i)
+		{
+			names[i] = arena_strdup(arena, src[i]);
+			failed += (names[i] == NULL);
+		}
+		arena_free(arena);
+		for(i = 0; i < NNAMES; ++i)
+		{
+			arena_release(names[i]);
+		}
+	}
+
+	printf("arena:    %.3f s\n", now() - start);
+	assert_int_equal(0, failed);
+}
+
+/* Retrieves current time.  Returns the time in seconds. */
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
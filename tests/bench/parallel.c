@@ -0,0 +1,132 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* stat */
+#include <unistd.h> /* unlink() */
+
+#include <stddef.h> /* size_t */
+#include <stdio.h> /* printf() snprintf() */
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/compat/pthread.h"
+#include "../../src/utils/parallel.h"
+
+/* Compares querying information about files of a directory on a single thread
+ * against doing it on several threads, which is what loading of file lists
+ * does.  Effect is much larger on network or otherwise slow file systems, as
+ * well as with cold cache. */
+
+/* Number of files in the directory. */
+#define NFILES 20000
+/* Number of times the directory is processed. */
+#define NLOADS 5
+
+static void stat_files(size_t from, size_t to, void *arg);
+static double bench(int nthreads);
+static void make_path(char buf[], size_t len, int i);
+static double now(void);
+
+/* Protects failures. */
+static pthread_mutex_t failures_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Number of failed stat() calls. */
+static int failures;
+
+SETUP_ONCE()
+{
+	int i;
+	char path[PATH_MAX];
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		FILE *f;
+		make_path(path, sizeof(path), i);
+		f = fopen(path, "w");
+		if(f != NULL)
+		{
+			fclose(f);
+		}
+	}
+}
+
+TEARDOWN_ONCE()
+{
+	int i;
+	char path[PATH_MAX];
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		make_path(path, sizeof(path), i);
+		(void)unlink(path);
+	}
+}
+
+SETUP()
+{
+	failures = 0;
+}
+
+TEST(stat_on_single_thread)
+{
+	printf("1 thread:  %.3f s\n", bench(1));
+	assert_int_equal(0, failures);
+}
+
+TEST(stat_on_several_threads)
+{
+	const int nthreads = par_get_nthreads();
+	printf("%d thread(s): %.3f s\n", nthreads, bench(nthreads));
+	assert_int_equal(0, failures);
+}
+
+/* Processes all files several times on specified number of threads.  Returns
+ * time it took in seconds. */
+static double
+bench(int nthreads)
+{
+	int load;
+	const double start = now();
+	for(load = 0; load < NLOADS; ++load)
+	{
+		par_for(NFILES, 256, nthreads, &stat_files, NULL);
+	}
+	return now() - start;
+}
+
+/* Queries information about files of the range. */
+static void
+stat_files(size_t from, size_t to, void *arg)
+{
+	int nfailed = 0;
+	char path[PATH_MAX];
+	struct stat st;
+
+	for(; from < to; ++from)
+	{
+		make_path(path, sizeof(path), from);
+		nfailed += (os_lstat(path, &st) != 0);
+	}
+
+	pthread_mutex_lock(&failures_lock);
+	failures += nfailed;
+	pthread_mutex_unlock(&failures_lock);
+}
+
+/* Formats path to i-th file. */
+static void
+make_path(char buf[], size_t len, int i)
+{
+	snprintf(buf, len, "%s/file%05d", SANDBOX_PATH, i);
+}
+
+/* Retrieves current time.  Returns the time in seconds. */
+static double
+now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
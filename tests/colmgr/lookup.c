@@ -0,0 +1,80 @@
+#include <stic.h>
+
+#include "../../src/ui/color_manager.h"
+
+#include "test.h"
+
+static void check_pair(int pair, int fg, int bg);
+
+SETUP()
+{
+	colmgr_reset();
+	pair_content_calls = 0;
+}
+
+TEST(lookup_does_not_query_colors_of_pairs)
+{
+	int i, round;
+	int pairs[CUSTOM_COLOR_PAIRS];
+
+	for(i = 0; i < CUSTOM_COLOR_PAIRS; ++i)
+	{
+		pairs[i] = colmgr_get_pair(INUSE_SEED, i);
+		assert_true(pairs[i] > 0);
+	}
+
+	for(round = 0; round < 100; ++round)
+	{
+		for(i = 0; i < CUSTOM_COLOR_PAIRS; ++i)
+		{
+			assert_int_equal(pairs[i], colmgr_get_pair(INUSE_SEED, i));
+		}
+	}
+
+	assert_int_equal(0, pair_content_calls);
+}
+
+TEST(pairs_are_found_after_compression)
+{
+	int i;
+
+	for(i = 0; i < CUSTOM_COLOR_PAIRS/2; ++i)
+	{
+		assert_true(colmgr_get_pair(UNUSED_SEED, i) > 0);
+		assert_true(colmgr_get_pair(INUSE_SEED, i) > 0);
+	}
+	assert_true(colmgr_get_pair(UNUSED_SEED, i) > 0);
+
+	/* This causes compression of pair space. */
+	check_pair(colmgr_get_pair(INUSE_SEED, i), INUSE_SEED, i);
+
+	for(i = 0; i < CUSTOM_COLOR_PAIRS/2; ++i)
+	{
+		check_pair(colmgr_get_pair(INUSE_SEED, i), INUSE_SEED, i);
+	}
+}
+
+TEST(pairs_with_default_colors_are_distinguished)
+{
+	const int p1 = colmgr_get_pair(-1, 0);
+	const int p2 = colmgr_get_pair(0, -1);
+	const int p3 = colmgr_get_pair(-1, -1);
+
+	check_pair(p1, -1, 0);
+	check_pair(p2, 0, -1);
+	check_pair(p3, -1, -1);
+
+	assert_int_equal(p1, colmgr_get_pair(-5, 0));
+	assert_int_equal(p3, colmgr_get_pair(-1, -7));
+}
+
+static void
+check_pair(int pair, int fg, int bg)
+{
+	assert_true(pair > 0);
+	assert_int_equal(fg, colors[pair][0]);
+	assert_int_equal(bg, colors[pair][1]);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
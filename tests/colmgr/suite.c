@@ -10,7 +10,8 @@ static int pair_content(short pair, short *f, short *b);
 static int pair_in_use(short int pair);
 static void move_pair(short int from, short int to);
 
-static int colors[TOTAL_COLOR_PAIRS][2];
+int colors[TOTAL_COLOR_PAIRS][2];
+int pair_content_calls;
 
 DEFINE_SUITE();
 
@@ -44,6 +45,7 @@ init_pair(short pair, short f, short b)
 static int
 pair_content(short pair, short *f, short *b)
 {
+	++pair_content_calls;
 	*f = colors[pair][0];
 	*b = colors[pair][1];
 	return 0;
@@ -8,6 +8,12 @@
 #define UNUSED_SEED 99
 #define INUSE_SEED 999
 
+/* Foreground and background colors of every pair. */
+extern int colors[TOTAL_COLOR_PAIRS][2];
+
+/* Number of times colors of a pair were queried. */
+extern int pair_content_calls;
+
 #endif /* VIFM_TESTS__COLMGR__TEST_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -0,0 +1,78 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+
+#include "../../src/io/private/ioeta.h"
+#include "../../src/io/ioeta.h"
+
+static const io_cancellation_t no_cancellation;
+
+TEST(bg_estimation_matches_regular_one)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	ioeta_calculate_bg(estim, TEST_DATA_PATH "/various-sizes");
+	ioeta_wait(estim);
+
+	assert_int_equal(7, estim->total_items);
+	assert_int_equal(0, estim->current_item);
+	assert_int_equal(73728, estim->total_bytes);
+	assert_int_equal(0, estim->current_byte);
+
+	ioeta_free(estim);
+}
+
+TEST(bg_estimation_processes_all_queued_paths)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	ioeta_calculate_bg(estim, TEST_DATA_PATH "/existing-files");
+	ioeta_calculate_bg(estim, TEST_DATA_PATH "/various-sizes");
+	ioeta_wait(estim);
+	ioeta_calculate_bg(estim, TEST_DATA_PATH "/existing-files");
+	ioeta_wait(estim);
+
+	assert_int_equal(13, estim->total_items);
+	assert_int_equal(73728, estim->total_bytes);
+
+	ioeta_free(estim);
+}
+
+TEST(bg_estimation_adds_to_existing_totals)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	ioeta_calculate(estim, TEST_DATA_PATH "/various-sizes", 0);
+	ioeta_calculate_bg(estim, TEST_DATA_PATH "/various-sizes");
+	ioeta_wait(estim);
+
+	assert_int_equal(14, estim->total_items);
+	assert_int_equal(2*73728, estim->total_bytes);
+
+	ioeta_free(estim);
+}
+
+TEST(progress_ahead_of_bg_estimation_is_not_lost)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	ioeta_calculate_bg(estim, TEST_DATA_PATH "/existing-files");
+	ioeta_wait(estim);
+	estim->total_bytes = 100000;
+	ioeta_update(estim, "", "", 1, 0);
+
+	assert_int_equal(3, estim->total_items);
+	assert_int_equal(100000, estim->total_bytes);
+
+	ioeta_free(estim);
+}
+
+TEST(estim_can_be_freed_during_bg_estimation)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+	ioeta_calculate_bg(estim, TEST_DATA_PATH);
+	ioeta_free(estim);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -4,10 +4,17 @@
 
 #include <sys/types.h> /* stat */
 #include <sys/stat.h> /* stat */
-#include <unistd.h> /* lstat() */
+#include <unistd.h> /* ftruncate() lstat() */
+
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE SEEK_SET fclose() fflush() fileno() fopen() fseek()
+                      fwrite() */
+#include <string.h> /* memset() */
 
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
+#include "../../src/io/private/ioeta.h"
+#include "../../src/io/ioeta.h"
 #include "../../src/io/iop.h"
 #include "../../src/utils/fs.h"
 #include "../../src/utils/utils.h"
@@ -15,6 +22,9 @@
 #include "utils.h"
 
 static void file_is_copied(const char original[]);
+static void create_big_file(const char path[]);
+static int create_sparse_file(const char path[]);
+static int always_cancel(void *arg);
 static int not_windows(void);
 
 TEST(dir_is_not_copied)
@@ -171,6 +181,187 @@ file_is_copied(const char original[])
 	delete_test_file(SANDBOX_PATH "/copy");
 }
 
+TEST(file_larger_than_transfer_block_is_copied_with_progress)
+{
+	const io_cancellation_t no_cancellation = {};
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	create_big_file(SANDBOX_PATH "/big");
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/big",
+			.arg2.dst = SANDBOX_PATH "/copy",
+
+			.estim = estim,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(iop_cp(&args));
+
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_true(files_are_identical(SANDBOX_PATH "/copy", SANDBOX_PATH "/big"));
+	assert_true(estim->current_byte == get_file_size(SANDBOX_PATH "/big"));
+
+	ioeta_free(estim);
+	delete_test_file(SANDBOX_PATH "/big");
+	delete_test_file(SANDBOX_PATH "/copy");
+}
+
+TEST(copying_can_be_cancelled)
+{
+	create_big_file(SANDBOX_PATH "/big");
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/big",
+			.arg2.dst = SANDBOX_PATH "/copy",
+
+			.cancellation.hook = &always_cancel,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_failure(iop_cp(&args));
+
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_true(get_file_size(SANDBOX_PATH "/copy") == 0);
+
+	delete_test_file(SANDBOX_PATH "/big");
+	delete_test_file(SANDBOX_PATH "/copy");
+}
+
+TEST(holes_of_sparse_files_are_preserved, IF(not_windows))
+{
+	struct stat st;
+	const io_cancellation_t no_cancellation = {};
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+	const int sparse = create_sparse_file(SANDBOX_PATH "/sparse");
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/sparse",
+			.arg2.dst = SANDBOX_PATH "/copy",
+
+			.estim = estim,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(iop_cp(&args));
+
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_true(files_are_identical(SANDBOX_PATH "/copy",
+				SANDBOX_PATH "/sparse"));
+	assert_true(get_file_size(SANDBOX_PATH "/copy") == 3*1024*1024);
+	assert_true(estim->current_byte ==
+			get_file_data_size(SANDBOX_PATH "/sparse"));
+
+	/* File system of the sandbox might not support holes. */
+	if(sparse)
+	{
+		assert_success(stat(SANDBOX_PATH "/copy", &st));
+		assert_true((uint64_t)st.st_blocks*512U < 3*1024*1024);
+		assert_true(estim->current_byte < 3*1024*1024);
+	}
+
+	ioeta_free(estim);
+	delete_test_file(SANDBOX_PATH "/sparse");
+	delete_test_file(SANDBOX_PATH "/copy");
+}
+
+TEST(short_kernel_copy_is_continued_from_where_it_stopped, IF(not_windows))
+{
+	struct stat st;
+	const io_cancellation_t no_cancellation = {};
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+	const int sparse = create_sparse_file(SANDBOX_PATH "/sparse");
+
+	iop_set_kernel_copy_limit(3);
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/sparse",
+			.arg2.dst = SANDBOX_PATH "/copy",
+
+			.estim = estim,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(iop_cp(&args));
+
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	iop_set_kernel_copy_limit((uint64_t)-1);
+
+	assert_true(files_are_identical(SANDBOX_PATH "/copy",
+				SANDBOX_PATH "/sparse"));
+	assert_true(get_file_size(SANDBOX_PATH "/copy") == 3*1024*1024);
+	assert_true(estim->current_byte ==
+			get_file_data_size(SANDBOX_PATH "/sparse"));
+
+	if(sparse)
+	{
+		struct stat orig_st;
+		assert_success(stat(SANDBOX_PATH "/sparse", &orig_st));
+		assert_success(stat(SANDBOX_PATH "/copy", &st));
+		assert_true(st.st_blocks <= orig_st.st_blocks);
+	}
+
+	ioeta_free(estim);
+	delete_test_file(SANDBOX_PATH "/sparse");
+	delete_test_file(SANDBOX_PATH "/copy");
+}
+
+/* Creates file that is larger than any block used for copying. */
+static void
+create_big_file(const char path[])
+{
+	int i;
+	char block[64*1024];
+	FILE *const f = fopen(path, "wb");
+	assert_non_null(f);
+
+	for(i = 0; i < 160; ++i)
+	{
+		memset(block, 'a' + i%26, sizeof(block));
+		assert_int_equal(1, fwrite(block, sizeof(block), 1, f));
+	}
+	assert_int_equal(1, fwrite("x", 1, 1, f));
+	fclose(f);
+}
+
+/* Creates a 3 MiB file with data at the beginning and in the middle.  Returns
+ * non-zero if the file has holes. */
+static int
+create_sparse_file(const char path[])
+{
+	struct stat st;
+	FILE *const f = fopen(path, "wb");
+	assert_non_null(f);
+
+	assert_int_equal(1, fwrite("begin", 5, 1, f));
+	assert_success(fseek(f, 1024*1024, SEEK_SET));
+	assert_int_equal(1, fwrite("middle", 6, 1, f));
+	assert_success(fflush(f));
+	assert_success(ftruncate(fileno(f), 3*1024*1024));
+	fclose(f);
+
+	assert_success(stat(path, &st));
+	return (uint64_t)st.st_blocks*512U < (uint64_t)st.st_size;
+}
+
+static int
+always_cancel(void *arg)
+{
+	return 1;
+}
+
 TEST(appending_works_for_files)
 {
 	uint64_t size;
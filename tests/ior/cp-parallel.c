@@ -0,0 +1,236 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* stat */
+
+#include <stdio.h> /* FILE fclose() fgets() fopen() fputs() snprintf() */
+#include <string.h> /* strlen() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/io/ioeta.h"
+#include "../../src/io/ior.h"
+#include "../../src/utils/fs.h"
+
+#include "utils.h"
+
+#define NFILES 50
+
+static void create_tree(const char root[]);
+static void check_tree(const char root[]);
+static void write_file(const char path[], const char contents[]);
+static void check_file(const char path[], const char contents[]);
+static int not_windows(void);
+
+static const io_cancellation_t no_cancellation;
+
+TEST(all_files_are_copied_on_several_threads)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	create_tree(SANDBOX_PATH "/src");
+	ioeta_calculate(estim, SANDBOX_PATH "/src", 0);
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.estim = estim,
+			.max_threads = 4,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	check_tree(SANDBOX_PATH "/dst");
+
+	assert_int_equal(2*NFILES, estim->current_item);
+	assert_true(estim->total_bytes == estim->current_byte);
+	assert_true(estim->current_byte > 0U);
+
+	ioeta_free(estim);
+
+	delete_tree(SANDBOX_PATH "/src");
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+TEST(dir_permissions_are_set_after_copying_files, IF(not_windows))
+{
+	struct stat st;
+
+	create_tree(SANDBOX_PATH "/src");
+	assert_success(os_chmod(SANDBOX_PATH "/src/sub", 0555));
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.max_threads = 4,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	check_tree(SANDBOX_PATH "/dst");
+	assert_success(os_stat(SANDBOX_PATH "/dst/sub", &st));
+	assert_int_equal(0555, st.st_mode & 0777);
+
+	assert_success(os_chmod(SANDBOX_PATH "/src/sub", 0755));
+	assert_success(os_chmod(SANDBOX_PATH "/dst/sub", 0755));
+	delete_tree(SANDBOX_PATH "/src");
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+TEST(files_are_replaced_when_asked)
+{
+	create_tree(SANDBOX_PATH "/src");
+	create_empty_dir(SANDBOX_PATH "/dst");
+	create_empty_dir(SANDBOX_PATH "/dst/sub");
+	create_empty_file(SANDBOX_PATH "/dst/sub/file7");
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.arg3.crs = IO_CRS_REPLACE_FILES,
+			.max_threads = 4,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	check_tree(SANDBOX_PATH "/dst");
+
+	delete_tree(SANDBOX_PATH "/src");
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+TEST(failure_to_copy_a_file_is_reported)
+{
+	create_tree(SANDBOX_PATH "/src");
+	create_empty_dir(SANDBOX_PATH "/dst");
+	create_empty_dir(SANDBOX_PATH "/dst/sub");
+	create_empty_dir(SANDBOX_PATH "/dst/sub/file7");
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.arg3.crs = IO_CRS_REPLACE_FILES,
+			.max_threads = 4,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_failure(ior_cp(&args));
+		assert_true(args.result.errors.error_count != 0);
+
+		ioe_errlst_free(&args.result.errors);
+	}
+
+	delete_tree(SANDBOX_PATH "/src");
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+TEST(single_thread_copies_everything_too)
+{
+	create_tree(SANDBOX_PATH "/src");
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.max_threads = 1,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	check_tree(SANDBOX_PATH "/dst");
+
+	delete_tree(SANDBOX_PATH "/src");
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+/* Creates directory with NFILES files and a subdirectory with the same number
+ * of files. */
+static void
+create_tree(const char root[])
+{
+	int i;
+	char path[PATH_MAX];
+
+	create_empty_dir(root);
+	snprintf(path, sizeof(path), "%s/sub", root);
+	create_empty_dir(path);
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%d", root, i);
+		write_file(path, path + strlen(root));
+		snprintf(path, sizeof(path), "%s/sub/file%d", root, i);
+		write_file(path, path + strlen(root));
+	}
+}
+
+/* Verifies that tree created by create_tree() exists at the root. */
+static void
+check_tree(const char root[])
+{
+	int i;
+	char path[PATH_MAX];
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%d", root, i);
+		check_file(path, path + strlen(root));
+		snprintf(path, sizeof(path), "%s/sub/file%d", root, i);
+		check_file(path, path + strlen(root));
+	}
+}
+
+static void
+write_file(const char path[], const char contents[])
+{
+	FILE *const fp = fopen(path, "w");
+	if(fp != NULL)
+	{
+		fputs(contents, fp);
+		fclose(fp);
+	}
+}
+
+static void
+check_file(const char path[], const char contents[])
+{
+	char line[PATH_MAX];
+	FILE *const fp = fopen(path, "r");
+	assert_non_null(fp);
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	assert_non_null(fgets(line, sizeof(line), fp));
+	assert_string_equal(contents, line);
+	fclose(fp);
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -2,7 +2,12 @@
 
 #include <unistd.h> /* F_OK access() */
 
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+
 #include "../../src/compat/os.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/io/ioeta.h"
+#include "../../src/io/iop.h"
 #include "../../src/io/ior.h"
 #include "../../src/utils/fs.h"
 
@@ -11,6 +16,11 @@
 #define DIRECTORY_NAME SANDBOX_PATH "/directory-to-remove"
 #define FILE_NAME "file-to-remove"
 
+static int always_cancel(void *arg);
+static int not_windows(void);
+
+static const io_cancellation_t no_cancellation;
+
 TEST(file_is_removed)
 {
 	create_empty_file(SANDBOX_PATH "/" FILE_NAME);
@@ -65,5 +75,142 @@ TEST(non_empty_directory_is_removed)
 	assert_failure(access(DIRECTORY_NAME, F_OK));
 }
 
+TEST(nested_directories_are_removed)
+{
+	os_mkdir(DIRECTORY_NAME, 0700);
+	os_mkdir(DIRECTORY_NAME "/a", 0700);
+	os_mkdir(DIRECTORY_NAME "/a/b", 0700);
+	os_mkdir(DIRECTORY_NAME "/a/b/c", 0700);
+	create_empty_file(DIRECTORY_NAME "/" FILE_NAME);
+	create_empty_file(DIRECTORY_NAME "/a/" FILE_NAME);
+	create_empty_file(DIRECTORY_NAME "/a/b/c/" FILE_NAME);
+
+	{
+		io_args_t args = {
+			.arg1.src = DIRECTORY_NAME,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_rm(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_failure(access(DIRECTORY_NAME, F_OK));
+}
+
+TEST(symlink_to_dir_is_removed_without_its_target, IF(not_windows))
+{
+	os_mkdir(SANDBOX_PATH "/target", 0700);
+	create_empty_file(SANDBOX_PATH "/target/" FILE_NAME);
+	os_mkdir(DIRECTORY_NAME, 0700);
+
+	{
+		io_args_t args = {
+			.arg1.path = "../target",
+			.arg2.target = DIRECTORY_NAME "/link",
+		};
+		assert_success(iop_ln(&args));
+	}
+
+	{
+		io_args_t args = {
+			.arg1.src = DIRECTORY_NAME,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_rm(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_failure(access(DIRECTORY_NAME, F_OK));
+	assert_success(access(SANDBOX_PATH "/target/" FILE_NAME, F_OK));
+
+	delete_tree(SANDBOX_PATH "/target");
+}
+
+TEST(wide_tree_is_removed_with_progress)
+{
+	int i, j;
+	char path[PATH_MAX];
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	os_mkdir(DIRECTORY_NAME, 0700);
+	for(i = 0; i < 10; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/dir%d", DIRECTORY_NAME, i);
+		os_mkdir(path, 0700);
+		for(j = 0; j < 30; ++j)
+		{
+			FILE *fp;
+			snprintf(path, sizeof(path), "%s/dir%d/file%d", DIRECTORY_NAME, i, j);
+			fp = fopen(path, "w");
+			if(fp != NULL)
+			{
+				fputs("data", fp);
+				fclose(fp);
+			}
+		}
+	}
+
+	ioeta_calculate(estim, DIRECTORY_NAME, 0);
+
+	{
+		io_args_t args = {
+			.arg1.src = DIRECTORY_NAME,
+			.estim = estim,
+			.max_threads = 4,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_rm(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_failure(access(DIRECTORY_NAME, F_OK));
+
+	/* Files plus directories. */
+	assert_int_equal(10*30 + 10 + 1, estim->current_item);
+	assert_int_equal(10*30*4, estim->current_byte);
+	assert_true(estim->total_bytes == estim->current_byte);
+
+	ioeta_free(estim);
+}
+
+TEST(removal_can_be_cancelled)
+{
+	os_mkdir(DIRECTORY_NAME, 0700);
+	create_empty_file(DIRECTORY_NAME "/" FILE_NAME);
+
+	{
+		io_args_t args = {
+			.arg1.src = DIRECTORY_NAME,
+			.cancellation.hook = &always_cancel,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_failure(ior_rm(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_success(access(DIRECTORY_NAME, F_OK));
+	delete_tree(DIRECTORY_NAME);
+}
+
+static int
+always_cancel(void *arg)
+{
+	return 1;
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -1,12 +1,42 @@
 #include <stic.h>
 
+#include <unistd.h> /* usleep() */
+
 #include "../../src/cfg/config.h"
+#include "../../src/compat/pthread.h"
 #include "../../src/utils/cancellation.h"
 #include "../../src/utils/str.h"
 #include "../../src/background.h"
 
 #include "utils.h"
 
+static void blocking_task(bg_op_t *bg_op, void *arg);
+static void flagging_task(bg_op_t *bg_op, void *arg);
+static void pausable_task(bg_op_t *bg_op, void *arg);
+static void recording_task(bg_op_t *bg_op, void *arg);
+static void set_flag(int *flag);
+static int get_flag(const int *flag);
+static void wait_for_flag(const int *flag);
+static void wait_for_all_jobs(void);
+
+/* Protects flags used by tests. */
+static pthread_mutex_t flags_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Set by blocking_task() when it starts. */
+static int blocking_started;
+/* Set to let blocking_task() finish. */
+static int blocking_released;
+/* Arguments of recording_task() in order of invocation. */
+static int order[2];
+/* Number of elements in order array. */
+static int norder;
+
+SETUP()
+{
+	blocking_started = 0;
+	blocking_released = 0;
+	norder = 0;
+}
+
 TEST(background_redirects_streams_properly, IF(not_windows))
 {
 	update_string(&cfg.shell, "/bin/sh");
@@ -14,5 +44,240 @@ TEST(background_redirects_streams_properly, IF(not_windows))
 	update_string(&cfg.shell, NULL);
 }
 
+TEST(operations_on_the_same_device_are_run_one_after_another)
+{
+	int done = 0;
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&blocking_task, NULL));
+	wait_for_flag(&blocking_started);
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&flagging_task, &done));
+	assert_true(bg_job_is_queued(bg_jobs));
+	usleep(20000);
+	assert_false(get_flag(&done));
+
+	set_flag(&blocking_released);
+	wait_for_all_jobs();
+	assert_true(get_flag(&done));
+	assert_false(bg_job_is_queued(bg_jobs));
+}
+
+TEST(cancelled_queued_operation_is_started_right_away)
+{
+	int done = 0;
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&blocking_task, NULL));
+	wait_for_flag(&blocking_started);
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&flagging_task, &done));
+	assert_true(bg_job_is_queued(bg_jobs));
+
+	assert_true(bg_job_cancel(bg_jobs));
+	assert_false(bg_job_is_queued(bg_jobs));
+	wait_for_flag(&done);
+
+	set_flag(&blocking_released);
+	wait_for_all_jobs();
+}
+
+TEST(tasks_and_operations_without_path_are_not_queued)
+{
+	int task_done = 0;
+	int op_done = 0;
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&blocking_task, NULL));
+	wait_for_flag(&blocking_started);
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 0, SANDBOX_PATH,
+				&flagging_task, &task_done));
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, NULL,
+				&flagging_task, &op_done));
+	wait_for_flag(&task_done);
+	wait_for_flag(&op_done);
+
+	set_flag(&blocking_released);
+	wait_for_all_jobs();
+}
+
+TEST(queued_operation_with_higher_priority_is_started_first)
+{
+	static int first = 1, second = 2;
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&blocking_task, NULL));
+	wait_for_flag(&blocking_started);
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&recording_task, &first));
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&recording_task, &second));
+	bg_job_set_priority(bg_jobs, 1);
+	assert_int_equal(1, bg_job_get_priority(bg_jobs));
+
+	set_flag(&blocking_released);
+	wait_for_all_jobs();
+
+	assert_int_equal(2, norder);
+	assert_int_equal(2, order[0]);
+	assert_int_equal(1, order[1]);
+}
+
+TEST(paused_queued_operation_is_started_after_resuming)
+{
+	int done = 0;
+	bg_job_t *blocking_job;
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&blocking_task, NULL));
+	blocking_job = bg_jobs;
+	wait_for_flag(&blocking_started);
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&flagging_task, &done));
+	assert_true(bg_job_pause(bg_jobs));
+	assert_false(bg_job_pause(bg_jobs));
+	assert_true(bg_job_is_paused(bg_jobs));
+
+	set_flag(&blocking_released);
+	while(bg_job_is_running(blocking_job))
+	{
+		usleep(1000);
+	}
+	usleep(20000);
+	assert_false(get_flag(&done));
+	assert_true(bg_job_is_queued(bg_jobs));
+
+	assert_true(bg_job_resume(bg_jobs));
+	assert_false(bg_job_is_paused(bg_jobs));
+	wait_for_all_jobs();
+	assert_true(get_flag(&done));
+}
+
+TEST(paused_operation_waits_on_checking_for_cancellation)
+{
+	int done = 0;
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&pausable_task, &done));
+	wait_for_flag(&blocking_started);
+	assert_true(bg_job_pause(bg_jobs));
+
+	set_flag(&blocking_released);
+	usleep(20000);
+	assert_false(get_flag(&done));
+	assert_false(bg_job_cancelled(bg_jobs));
+
+	assert_true(bg_job_resume(bg_jobs));
+	wait_for_all_jobs();
+	assert_true(get_flag(&done));
+}
+
+TEST(cancelling_paused_operation_resumes_it)
+{
+	int done = 0;
+
+	assert_success(bg_execute("", "", BG_UNDEFINED_TOTAL, 1, SANDBOX_PATH,
+				&pausable_task, &done));
+	wait_for_flag(&blocking_started);
+	assert_true(bg_job_pause(bg_jobs));
+
+	set_flag(&blocking_released);
+	assert_true(bg_job_cancel(bg_jobs));
+	assert_false(bg_job_is_paused(bg_jobs));
+	wait_for_all_jobs();
+	assert_true(get_flag(&done));
+}
+
+/* Background task that waits for blocking_released flag to be set. */
+static void
+blocking_task(bg_op_t *bg_op, void *arg)
+{
+	set_flag(&blocking_started);
+	while(!get_flag(&blocking_released))
+	{
+		usleep(1000);
+	}
+}
+
+/* Background task that sets flag pointed to by its argument. */
+static void
+flagging_task(bg_op_t *bg_op, void *arg)
+{
+	set_flag(arg);
+}
+
+/* Background task that checks for cancellation after blocking_released flag is
+ * set and then sets flag pointed to by its argument. */
+static void
+pausable_task(bg_op_t *bg_op, void *arg)
+{
+	blocking_task(bg_op, NULL);
+	(void)bg_op_cancelled(bg_op);
+	set_flag(arg);
+}
+
+/* Background task that appends integer pointed to by its argument to the order
+ * array. */
+static void
+recording_task(bg_op_t *bg_op, void *arg)
+{
+	pthread_mutex_lock(&flags_lock);
+	order[norder++] = *(const int *)arg;
+	pthread_mutex_unlock(&flags_lock);
+}
+
+static void
+set_flag(int *flag)
+{
+	pthread_mutex_lock(&flags_lock);
+	*flag = 1;
+	pthread_mutex_unlock(&flags_lock);
+}
+
+static int
+get_flag(const int *flag)
+{
+	int value;
+	pthread_mutex_lock(&flags_lock);
+	value = *flag;
+	pthread_mutex_unlock(&flags_lock);
+	return value;
+}
+
+static void
+wait_for_flag(const int *flag)
+{
+	int counter = 0;
+	while(!get_flag(flag))
+	{
+		usleep(5000);
+		if(++counter > 200)
+		{
+			assert_fail("Waiting for too long.");
+			break;
+		}
+	}
+}
+
+static void
+wait_for_all_jobs(void)
+{
+	int counter = 0;
+	while(bg_has_active_jobs())
+	{
+		usleep(5000);
+		if(++counter > 200)
+		{
+			assert_fail("Waiting for too long.");
+			break;
+		}
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -11,7 +11,6 @@
 #include "../../src/compat/fs_limits.h"
 #include "../../src/filelist.h"
 #include "../../src/filtering.h"
-#include "../../src/utils/dynarray.h"
 #include "../../src/utils/fs.h"
 #include "../../src/utils/path.h"
 #include "../../src/utils/str.h"
@@ -68,13 +67,7 @@ init_view(FileView *view)
 static void
 free_view(FileView *view)
 {
-	int i;
-
-	for(i = 0; i < view->list_rows; ++i)
-	{
-		free(view->dir_entry[i].name);
-	}
-	dynarray_free(view->dir_entry);
+	free_dir_entries(view, &view->dir_entry, &view->list_rows);
 
 	filter_dispose(&view->local_filter.filter);
 	filter_dispose(&view->manual_filter);
@@ -0,0 +1,170 @@
+#include <stic.h>
+
+#include <unistd.h> /* rmdir() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputc() remove() */
+#include <string.h> /* strcpy() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/str.h"
+#include "../../src/compare.h"
+
+#include "utils.h"
+
+static void basic_panes_check(int expected_len);
+static void make_big_file(const char path[], char middle);
+
+SETUP()
+{
+	curr_view = &lwin;
+	other_view = &rwin;
+
+	view_setup(&lwin);
+	view_setup(&rwin);
+
+	opt_handlers_setup();
+}
+
+TEARDOWN()
+{
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+
+	opt_handlers_teardown();
+}
+
+TEST(files_with_same_head_and_tail_are_distinguished)
+{
+	make_big_file(SANDBOX_PATH "/a", 'a');
+	make_big_file(SANDBOX_PATH "/b", 'b');
+	make_big_file(SANDBOX_PATH "/c", 'a');
+
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, 0);
+
+	assert_int_equal(CV_COMPARE, lwin.custom.type);
+	assert_int_equal(3, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_int_equal(1, lwin.dir_entry[0].id);
+	assert_string_equal("c", lwin.dir_entry[1].name);
+	assert_int_equal(1, lwin.dir_entry[1].id);
+	assert_string_equal("b", lwin.dir_entry[2].name);
+	assert_int_equal(2, lwin.dir_entry[2].id);
+
+	assert_success(remove(SANDBOX_PATH "/a"));
+	assert_success(remove(SANDBOX_PATH "/b"));
+	assert_success(remove(SANDBOX_PATH "/c"));
+}
+
+TEST(files_are_hashed_on_any_number_of_threads)
+{
+	int nthreads;
+	for(nthreads = 0; nthreads < 3; ++nthreads)
+	{
+		cfg.io_threads = nthreads;
+
+		assert_success(os_mkdir(SANDBOX_PATH "/l", 0700));
+		assert_success(os_mkdir(SANDBOX_PATH "/r", 0700));
+		make_big_file(SANDBOX_PATH "/l/a", 'a');
+		make_big_file(SANDBOX_PATH "/l/b", 'b');
+		make_big_file(SANDBOX_PATH "/r/c", 'b');
+		make_big_file(SANDBOX_PATH "/r/d", 'd');
+
+		strcpy(lwin.curr_dir, SANDBOX_PATH "/l");
+		strcpy(rwin.curr_dir, SANDBOX_PATH "/r");
+		compare_two_panes(CT_CONTENTS, LT_ALL, 0, 0);
+
+		basic_panes_check(3);
+		assert_string_equal("a", lwin.dir_entry[0].name);
+		assert_string_equal("", rwin.dir_entry[0].name);
+		assert_string_equal("b", lwin.dir_entry[1].name);
+		assert_string_equal("c", rwin.dir_entry[1].name);
+		assert_string_equal("", lwin.dir_entry[2].name);
+		assert_string_equal("d", rwin.dir_entry[2].name);
+
+		view_teardown(&lwin);
+		view_teardown(&rwin);
+		view_setup(&lwin);
+		view_setup(&rwin);
+
+		assert_success(remove(SANDBOX_PATH "/l/a"));
+		assert_success(remove(SANDBOX_PATH "/l/b"));
+		assert_success(remove(SANDBOX_PATH "/r/c"));
+		assert_success(remove(SANDBOX_PATH "/r/d"));
+		assert_success(rmdir(SANDBOX_PATH "/l"));
+		assert_success(rmdir(SANDBOX_PATH "/r"));
+	}
+
+	cfg.io_threads = 0;
+}
+
+TEST(digests_are_cached_between_comparisons)
+{
+	int i;
+
+	copy_str(cfg.config_dir, sizeof(cfg.config_dir), SANDBOX_PATH);
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+	make_big_file(SANDBOX_PATH "/dir/a", 'a');
+	make_big_file(SANDBOX_PATH "/dir/b", 'b');
+	make_big_file(SANDBOX_PATH "/dir/c", 'a');
+
+	for(i = 0; i < 2; ++i)
+	{
+		strcpy(lwin.curr_dir, SANDBOX_PATH "/dir");
+		compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, 0);
+		assert_success(os_access(SANDBOX_PATH "/hashcache", R_OK));
+
+		assert_int_equal(3, lwin.list_rows);
+		assert_string_equal("a", lwin.dir_entry[0].name);
+		assert_int_equal(1, lwin.dir_entry[0].id);
+		assert_string_equal("c", lwin.dir_entry[1].name);
+		assert_int_equal(1, lwin.dir_entry[1].id);
+		assert_string_equal("b", lwin.dir_entry[2].name);
+		assert_int_equal(2, lwin.dir_entry[2].id);
+
+		view_teardown(&lwin);
+		view_setup(&lwin);
+	}
+
+	assert_success(remove(SANDBOX_PATH "/dir/a"));
+	assert_success(remove(SANDBOX_PATH "/dir/b"));
+	assert_success(remove(SANDBOX_PATH "/dir/c"));
+	assert_success(rmdir(SANDBOX_PATH "/dir"));
+	assert_success(remove(SANDBOX_PATH "/hashcache"));
+	cfg.config_dir[0] = '\0';
+}
+
+/* Creates a file that is large enough to not be sampled entirely and which
+ * differs from other such files only in the middle. */
+static void
+make_big_file(const char path[], char middle)
+{
+	int i;
+	FILE *const f = fopen(path, "wb");
+	assert_non_null(f);
+
+	for(i = 0; i < 64*1024; ++i)
+	{
+		fputc(i == 32*1024 ? middle : 'x', f);
+	}
+	fclose(f);
+}
+
+static void
+basic_panes_check(int expected_len)
+{
+	int i;
+
+	assert_int_equal(expected_len, lwin.list_rows);
+	assert_int_equal(expected_len, rwin.list_rows);
+
+	for(i = 0; i < expected_len; ++i)
+	{
+		assert_int_equal(lwin.dir_entry[i].id, rwin.dir_entry[i].id);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
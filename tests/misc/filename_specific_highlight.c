@@ -1,5 +1,7 @@
 #include <stic.h>
 
+#include <curses.h>
+
 #include "../../src/cfg/config.h"
 #include "../../src/ui/color_scheme.h"
 #include "../../src/utils/matchers.h"
@@ -110,5 +112,99 @@ TEST(negation)
 			matchers_get_expr(cfg.cs.file_hi[0].matchers));
 }
 
+TEST(extension_highlight_ignores_case)
+{
+	int hint = -1;
+	const col_attr_t *hi;
+
+	assert_success(exec_commands("highlight {*.jpg,*.tar.gz} ctermfg=red", &lwin,
+				CIT_COMMAND));
+	assert_true(cfg.cs.file_hi[0].by_ext);
+
+	hi = cs_get_file_hi(&cfg.cs, "/dir/image.JPG", &hint);
+	assert_non_null(hi);
+	assert_int_equal(COLOR_RED, hi->fg);
+	assert_int_equal(0, hint);
+
+	hint = -1;
+	assert_non_null(cs_get_file_hi(&cfg.cs, "/dir/a.b.Tar.gz", &hint));
+	hint = -1;
+	assert_null(cs_get_file_hi(&cfg.cs, "/dir/image.jpg/", &hint));
+	hint = -1;
+	assert_null(cs_get_file_hi(&cfg.cs, "/dir/image.jpeg", &hint));
+}
+
+TEST(extension_highlight_skips_dot_files)
+{
+	int hint = -1;
+
+	assert_success(exec_commands("highlight {*.vim} ctermfg=red", &lwin,
+				CIT_COMMAND));
+
+	assert_null(cs_get_file_hi(&cfg.cs, "/dir/.vim", &hint));
+	hint = -1;
+	assert_null(cs_get_file_hi(&cfg.cs, "/dir/.vimrc.vim", &hint));
+	hint = -1;
+	assert_non_null(cs_get_file_hi(&cfg.cs, "/.dir/vimrc.vim", &hint));
+}
+
+TEST(order_of_extension_and_other_highlights_is_preserved)
+{
+	int hint = -1;
+	const col_attr_t *hi;
+
+	assert_success(exec_commands("highlight /^a/ ctermfg=blue", &lwin,
+				CIT_COMMAND));
+	assert_success(exec_commands("highlight {*.c} ctermfg=red", &lwin,
+				CIT_COMMAND));
+	assert_success(exec_commands("highlight {*.C} ctermfg=green", &lwin,
+				CIT_COMMAND));
+	assert_false(cfg.cs.file_hi[0].by_ext);
+	assert_true(cfg.cs.file_hi[1].by_ext);
+	assert_true(cfg.cs.file_hi[2].by_ext);
+
+	hi = cs_get_file_hi(&cfg.cs, "a.c", &hint);
+	assert_int_equal(COLOR_BLUE, hi->fg);
+
+	hint = -1;
+	hi = cs_get_file_hi(&cfg.cs, "b.c", &hint);
+	assert_int_equal(COLOR_RED, hi->fg);
+	assert_int_equal(1, hint);
+}
+
+TEST(absence_of_match_is_cached_until_new_highlight)
+{
+	int hint = -1;
+
+	assert_success(exec_commands("highlight {*.c} ctermfg=red", &lwin,
+				CIT_COMMAND));
+
+	assert_null(cs_get_file_hi(&cfg.cs, "file.h", &hint));
+	assert_true(cs_file_hi_is_cached(&cfg.cs, hint));
+	assert_null(cs_get_file_hi(&cfg.cs, NULL, &hint));
+
+	assert_success(exec_commands("highlight {*.h} ctermfg=red", &lwin,
+				CIT_COMMAND));
+	assert_false(cs_file_hi_is_cached(&cfg.cs, hint));
+	assert_non_null(cs_get_file_hi(&cfg.cs, "file.h", &hint));
+	assert_int_equal(1, hint);
+}
+
+TEST(assigned_color_scheme_keeps_index_of_extensions)
+{
+	int hint = -1;
+	col_scheme_t cs = {};
+
+	assert_success(exec_commands("highlight {*.c} ctermfg=red", &lwin,
+				CIT_COMMAND));
+
+	cs_assign(&cs, &cfg.cs);
+	cs_reset(&cfg.cs);
+
+	assert_non_null(cs_get_file_hi(&cs, "file.c", &hint));
+
+	cs_reset(&cs);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -366,6 +366,7 @@ TEST(unsorted_view_remains_one_on_vifminfo_reread_on_restart)
 	opt_handlers_teardown();
 
 	assert_success(remove(SANDBOX_PATH "/vifminfo"));
+	cfg.config_dir[0] = '\0';
 }
 
 TEST(location_is_saved_on_entering_custom_view)
@@ -1,8 +1,13 @@
 #include <stic.h>
 
-#include <string.h> /* strcpy() */
+#include <unistd.h> /* rmdir() symlink() unlink() */
+
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* strcmp() strcpy() */
 
 #include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
 #include "../../src/ui/ui.h"
 #include "../../src/compare.h"
 #include "../../src/filelist.h"
@@ -10,6 +15,8 @@
 
 #include "utils.h"
 
+static int using_inotify(void);
+
 SETUP()
 {
 	curr_view = &lwin;
@@ -42,6 +49,276 @@ TEST(compare_view_defines_id_grouping)
 	assert_int_equal(1, lwin.list_pos = flist_find_group(&lwin, 0));
 }
 
+TEST(all_files_of_large_directory_are_loaded)
+{
+	enum { NFILES = 1000 };
+
+	int i;
+	char path[PATH_MAX];
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%04d", SANDBOX_PATH, i);
+		create_file(path);
+	}
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	load_dir_list(&lwin, 1);
+
+	assert_int_equal(NFILES + 1, lwin.list_rows);
+	assert_string_equal("dir", lwin.dir_entry[0].name);
+	assert_int_equal(FT_DIR, lwin.dir_entry[0].type);
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "file%04d", i);
+		assert_string_equal(path, lwin.dir_entry[i + 1].name);
+		assert_int_equal(FT_REG, lwin.dir_entry[i + 1].type);
+	}
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%04d", SANDBOX_PATH, i);
+		assert_success(unlink(path));
+	}
+	assert_success(rmdir(SANDBOX_PATH "/dir"));
+}
+
+TEST(reload_with_few_changes_keeps_list_sorted)
+{
+	enum { NFILES = 20 };
+
+	int i;
+	char path[PATH_MAX];
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%02d", SANDBOX_PATH, i);
+		create_file(path);
+	}
+
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	load_dir_list(&lwin, 1);
+	assert_int_equal(NFILES, lwin.list_rows);
+
+	lwin.dir_entry[5].selected = 1;
+	lwin.list_pos = 10;
+
+	assert_success(unlink(SANDBOX_PATH "/file03"));
+	create_file(SANDBOX_PATH "/file07a");
+	create_file(SANDBOX_PATH "/file99");
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+
+	load_dir_list(&lwin, 1);
+
+	assert_int_equal(NFILES + 2, lwin.list_rows);
+	assert_string_equal("dir", lwin.dir_entry[0].name);
+	for(i = 2; i < lwin.list_rows; ++i)
+	{
+		assert_true(strcmp(lwin.dir_entry[i - 1].name, lwin.dir_entry[i].name) < 0);
+	}
+	assert_string_equal("file07a", lwin.dir_entry[8].name);
+	assert_string_equal("file99", lwin.dir_entry[lwin.list_rows - 1].name);
+
+	assert_int_equal(1, lwin.selected_files);
+	assert_true(lwin.dir_entry[5].selected);
+	assert_string_equal("file05", lwin.dir_entry[5].name);
+	assert_string_equal("file10", lwin.dir_entry[lwin.list_pos].name);
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%02d", SANDBOX_PATH, i);
+		(void)unlink(path);
+	}
+	assert_success(unlink(SANDBOX_PATH "/file07a"));
+	assert_success(unlink(SANDBOX_PATH "/file99"));
+	assert_success(rmdir(SANDBOX_PATH "/dir"));
+}
+
+TEST(file_events_are_applied_without_reload, IF(using_inotify))
+{
+	enum { NFILES = 10 };
+
+	int i;
+	char path[PATH_MAX];
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%02d", SANDBOX_PATH, i);
+		create_file(path);
+	}
+
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	load_dir_list(&lwin, 1);
+	assert_int_equal(NFILES, lwin.list_rows);
+	(void)ui_view_query_scheduled_event(&lwin);
+
+	lwin.dir_entry[2].selected = 1;
+	lwin.selected_files = 1;
+	lwin.list_pos = 5;
+
+	create_file(SANDBOX_PATH "/file04a");
+	assert_success(unlink(SANDBOX_PATH "/file07"));
+
+	check_if_filelist_have_changed(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+
+	assert_int_equal(NFILES, lwin.list_rows);
+	assert_string_equal("file04a", lwin.dir_entry[5].name);
+	assert_string_equal("file05", lwin.dir_entry[lwin.list_pos].name);
+	assert_string_equal("file08", lwin.dir_entry[8].name);
+	assert_int_equal(1, lwin.selected_files);
+	assert_true(lwin.dir_entry[2].selected);
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%02d", SANDBOX_PATH, i);
+		(void)unlink(path);
+	}
+	assert_success(unlink(SANDBOX_PATH "/file04a"));
+}
+
+TEST(file_events_reset_state_of_links, IF(using_inotify))
+{
+	enum { NFILES = 10 };
+
+	int i;
+	char path[PATH_MAX];
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%02d", SANDBOX_PATH, i);
+		create_file(path);
+	}
+	create_file(SANDBOX_PATH "/b");
+	assert_success(symlink("b", SANDBOX_PATH "/a"));
+	assert_success(symlink("../b", SANDBOX_PATH "/c"));
+
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	load_dir_list(&lwin, 1);
+	assert_int_equal(NFILES + 3, lwin.list_rows);
+	(void)ui_view_query_scheduled_event(&lwin);
+
+	/* Pretend that the links were drawn while their targets existed. */
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	lwin.dir_entry[0].link_checked = 1;
+	lwin.dir_entry[0].broken_link = 0;
+	lwin.dir_entry[0].local_link = 1;
+	assert_string_equal("c", lwin.dir_entry[2].name);
+	lwin.dir_entry[2].link_checked = 1;
+	lwin.dir_entry[2].broken_link = 0;
+	lwin.dir_entry[2].local_link = 0;
+
+	assert_success(unlink(SANDBOX_PATH "/b"));
+
+	check_if_filelist_have_changed(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+
+	assert_int_equal(NFILES + 2, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_false(lwin.dir_entry[0].link_checked);
+	/* Link that points outside of the directory isn't affected. */
+	assert_string_equal("c", lwin.dir_entry[1].name);
+	assert_true(lwin.dir_entry[1].link_checked);
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%02d", SANDBOX_PATH, i);
+		assert_success(unlink(path));
+	}
+	assert_success(unlink(SANDBOX_PATH "/a"));
+	assert_success(unlink(SANDBOX_PATH "/c"));
+}
+
+TEST(reload_keeps_state_of_modified_files)
+{
+	enum { NFILES = 20 };
+
+	int i;
+	char path[PATH_MAX];
+	FILE *fp;
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%02d", SANDBOX_PATH, i);
+		create_file(path);
+	}
+
+	/* Secondary key makes reloading compare meta-data of files. */
+	lwin.sort[1] = SK_BY_TIME_MODIFIED;
+
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	load_dir_list(&lwin, 1);
+	assert_int_equal(NFILES, lwin.list_rows);
+
+	lwin.dir_entry[5].selected = 1;
+	lwin.selected_files = 1;
+	lwin.list_pos = 5;
+
+	fp = fopen(SANDBOX_PATH "/file05", "w");
+	assert_non_null(fp);
+	fputs("modified", fp);
+	fclose(fp);
+
+	load_dir_list(&lwin, 1);
+
+	assert_int_equal(NFILES, lwin.list_rows);
+	assert_string_equal("file05", lwin.dir_entry[5].name);
+	assert_int_equal(8, lwin.dir_entry[5].size);
+	assert_int_equal(1, lwin.selected_files);
+	assert_true(lwin.dir_entry[5].selected);
+	assert_int_equal(5, lwin.list_pos);
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%02d", SANDBOX_PATH, i);
+		assert_success(unlink(path));
+	}
+}
+
+TEST(meta_data_is_loaded_on_reading_directory, IF(not_windows))
+{
+	strcpy(lwin.curr_dir, TEST_DATA_PATH "/various-sizes");
+	load_dir_list(&lwin, 1);
+
+	assert_int_equal(7, lwin.list_rows);
+	assert_string_equal("block-size-file", lwin.dir_entry[0].name);
+	assert_false(lwin.dir_entry[0].no_meta);
+	assert_ulong_equal(8192, lwin.dir_entry[0].size);
+}
+
+TEST(meta_data_is_loaded_on_demand_on_slow_fs, IF(not_windows))
+{
+	strcpy(lwin.curr_dir, TEST_DATA_PATH "/various-sizes");
+	lwin.on_slow_fs = 1;
+	load_dir_list(&lwin, 1);
+
+	assert_int_equal(7, lwin.list_rows);
+	assert_string_equal("block-size-file", lwin.dir_entry[0].name);
+	assert_true(lwin.dir_entry[0].no_meta);
+	assert_int_equal(FT_REG, lwin.dir_entry[0].type);
+
+	fentry_load_meta(&lwin.dir_entry[0]);
+	assert_false(lwin.dir_entry[0].no_meta);
+	assert_ulong_equal(8192, lwin.dir_entry[0].size);
+
+	lwin.on_slow_fs = 0;
+}
+
+TEST(sorting_by_size_loads_meta_data, IF(not_windows))
+{
+	strcpy(lwin.curr_dir, TEST_DATA_PATH "/various-sizes");
+	lwin.sort[0] = SK_BY_SIZE;
+	load_dir_list(&lwin, 1);
+
+	assert_int_equal(7, lwin.list_rows);
+	assert_string_equal("empty-file", lwin.dir_entry[0].name);
+	assert_false(lwin.dir_entry[0].no_meta);
+	assert_string_equal("double-block-size-plus-one-file",
+			lwin.dir_entry[6].name);
+	assert_ulong_equal(16385, lwin.dir_entry[6].size);
+}
+
 TEST(goto_file_nagivates_to_files)
 {
 	strcpy(lwin.curr_dir, TEST_DATA_PATH "/existing-files");
@@ -222,5 +499,15 @@ TEST(selection_is_marked)
 	assert_false(lwin.dir_entry[2].selected);
 }
 
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -7,7 +7,6 @@
 #include "../../src/compat/os.h"
 #include "../../src/compat/fs_limits.h"
 #include "../../src/ui/ui.h"
-#include "../../src/utils/dynarray.h"
 #include "../../src/utils/fs.h"
 #include "../../src/utils/str.h"
 #include "../../src/filelist.h"
@@ -43,11 +42,7 @@ SETUP()
 
 TEARDOWN()
 {
-	int i;
-
-	for(i = 0; i < view->list_rows; i++)
-		free(view->dir_entry[i].name);
-	dynarray_free(view->dir_entry);
+	free_dir_entries(view, &view->dir_entry, &view->list_rows);
 
 	filter_dispose(&view->auto_filter);
 	filter_dispose(&view->manual_filter);
@@ -29,6 +29,7 @@ static void column_line_print(const void *data, int column_id, const char buf[],
 static int remove_selected(FileView *view, const dir_entry_t *entry, void *arg);
 static void validate_tree(const FileView *view);
 static void validate_parents(const dir_entry_t *entries, int nchildren);
+static int using_inotify(void);
 
 SETUP()
 {
@@ -295,6 +296,30 @@ TEST(tree_is_reloaded_automatically_with_file_updates)
 	update_string(&cfg.ruler_format, NULL);
 }
 
+TEST(nested_directory_change_is_detected_by_watcher, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/nested-dir", 0700));
+	create_file(SANDBOX_PATH "/nested-dir/a");
+
+	assert_success(flist_load_tree(&lwin, SANDBOX_PATH));
+	assert_int_equal(2, lwin.list_rows);
+	assert_true(lwin.watch_tree);
+
+	check_if_filelist_have_changed(&lwin);
+	(void)ui_view_query_scheduled_event(&lwin);
+
+	/* No need for timestamp of the directory to change. */
+	create_file(SANDBOX_PATH "/nested-dir/b");
+	check_if_filelist_have_changed(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(3, lwin.list_rows);
+	validate_tree(&lwin);
+
+	assert_success(remove(SANDBOX_PATH "/nested-dir/a"));
+	assert_success(remove(SANDBOX_PATH "/nested-dir/b"));
+	assert_success(rmdir(SANDBOX_PATH "/nested-dir"));
+}
+
 TEST(nested_directory_change_detection)
 {
 	struct stat st;
@@ -834,5 +859,15 @@ validate_parents(const dir_entry_t *entries, int nchildren)
 	}
 }
 
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
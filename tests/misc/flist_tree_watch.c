@@ -0,0 +1,122 @@
+#include <stic.h>
+
+#include <unistd.h> /* rmdir() */
+
+#include <stdio.h> /* remove() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fswatch.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+
+#include "utils.h"
+
+static int using_inotify(void);
+
+SETUP()
+{
+	update_string(&cfg.fuse_home, "no");
+	update_string(&cfg.slow_fs_list, "");
+
+	view_setup(&lwin);
+
+	curr_view = &lwin;
+	other_view = &lwin;
+}
+
+TEARDOWN()
+{
+	update_string(&cfg.slow_fs_list, NULL);
+	update_string(&cfg.fuse_home, NULL);
+
+	view_teardown(&lwin);
+}
+
+TEST(only_changed_directories_are_listed_again, IF(using_inotify))
+{
+	int error;
+
+	assert_success(os_mkdir(SANDBOX_PATH "/dir1", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/dir2", 0700));
+	create_file(SANDBOX_PATH "/dir1/a");
+	create_file(SANDBOX_PATH "/dir2/b");
+
+	assert_success(flist_load_tree(&lwin, SANDBOX_PATH));
+	assert_int_equal(4, lwin.list_rows);
+
+	check_if_filelist_have_changed(&lwin);
+	(void)ui_view_query_scheduled_event(&lwin);
+
+	/* Make the watcher lose changes of the second directory. */
+	create_file(SANDBOX_PATH "/dir2/c");
+	assert_true(fswatch_changed(lwin.watch, &error));
+	assert_false(error);
+
+	create_file(SANDBOX_PATH "/dir1/d");
+	check_if_filelist_have_changed(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+
+	assert_int_equal(5, lwin.list_rows);
+	assert_string_equal("dir1", lwin.dir_entry[0].name);
+	assert_int_equal(2, lwin.dir_entry[0].child_count);
+	assert_string_equal("a", lwin.dir_entry[1].name);
+	assert_string_equal("d", lwin.dir_entry[2].name);
+	assert_int_equal(2, lwin.dir_entry[2].child_pos);
+	assert_string_equal("dir2", lwin.dir_entry[3].name);
+	assert_int_equal(1, lwin.dir_entry[3].child_count);
+	assert_string_equal("b", lwin.dir_entry[4].name);
+
+	assert_success(remove(SANDBOX_PATH "/dir1/a"));
+	assert_success(remove(SANDBOX_PATH "/dir1/d"));
+	assert_success(remove(SANDBOX_PATH "/dir2/b"));
+	assert_success(remove(SANDBOX_PATH "/dir2/c"));
+	assert_success(rmdir(SANDBOX_PATH "/dir1"));
+	assert_success(rmdir(SANDBOX_PATH "/dir2"));
+}
+
+TEST(new_directories_are_watched_after_update, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+
+	assert_success(flist_load_tree(&lwin, SANDBOX_PATH));
+	assert_int_equal(2, lwin.list_rows);
+
+	check_if_filelist_have_changed(&lwin);
+	(void)ui_view_query_scheduled_event(&lwin);
+
+	assert_success(os_mkdir(SANDBOX_PATH "/dir/sub", 0700));
+	check_if_filelist_have_changed(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(3, lwin.list_rows);
+
+	create_file(SANDBOX_PATH "/dir/sub/file");
+	check_if_filelist_have_changed(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(3, lwin.list_rows);
+	assert_string_equal("file", lwin.dir_entry[2].name);
+	assert_int_equal(1, lwin.dir_entry[2].child_pos);
+
+	assert_success(remove(SANDBOX_PATH "/dir/sub/file"));
+	assert_success(rmdir(SANDBOX_PATH "/dir/sub"));
+	check_if_filelist_have_changed(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("..", lwin.dir_entry[1].name);
+
+	assert_success(rmdir(SANDBOX_PATH "/dir"));
+}
+
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
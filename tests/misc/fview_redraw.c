@@ -0,0 +1,239 @@
+#include <stic.h>
+
+#include <unistd.h> /* symlink() */
+
+#include <stdio.h> /* remove() snprintf() */
+#include <string.h> /* strcpy() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/color_scheme.h"
+#include "../../src/ui/colors.h"
+#include "../../src/ui/column_view.h"
+#include "../../src/ui/fileview.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/matchers.h"
+#include "../../src/utils/str.h"
+#include "../../src/sort.h"
+#include "../../src/status.h"
+
+#include "utils.h"
+
+static void add_files_to_view(FileView *view, int count);
+
+SETUP()
+{
+	const column_info_t column_info = {
+		.column_id = SK_BY_NAME, .full_width = 0UL, .text_width = 0UL,
+		.align = AT_LEFT,        .sizing = ST_AUTO, .cropping = CT_NONE,
+	};
+
+	fview_init();
+
+	view_setup(&lwin);
+	view_setup(&rwin);
+	curr_view = &lwin;
+	other_view = &rwin;
+
+	lwin.columns = columns_create();
+	columns_add_column(lwin.columns, column_info);
+
+	lwin.window_rows = 9;
+	lwin.window_width = 40;
+	lwin.window_cells = lwin.window_rows + 1;
+	lwin.top_line = 0;
+	lwin.curr_line = 0;
+
+	add_files_to_view(&lwin, 5);
+	fview_invalidate(&lwin);
+
+	curr_stats.load_stage = 2;
+}
+
+TEARDOWN()
+{
+	curr_stats.load_stage = 0;
+
+	columns_free(lwin.columns);
+	lwin.columns = NULL;
+
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+}
+
+TEST(first_redraw_paints_all_cells)
+{
+	const size_t before = fview_repainted_cells(&lwin);
+	draw_dir_list(&lwin);
+	assert_int_equal(5, fview_repainted_cells(&lwin) - before);
+}
+
+TEST(unchanged_list_is_not_repainted)
+{
+	size_t before;
+
+	draw_dir_list(&lwin);
+
+	before = fview_repainted_cells(&lwin);
+	draw_dir_list(&lwin);
+	assert_int_equal(0, fview_repainted_cells(&lwin) - before);
+}
+
+TEST(only_changed_rows_are_repainted)
+{
+	size_t before;
+
+	draw_dir_list(&lwin);
+
+	lwin.dir_entry[3].selected = 1;
+	lwin.selected_files = 1;
+
+	before = fview_repainted_cells(&lwin);
+	draw_dir_list(&lwin);
+	assert_int_equal(1, fview_repainted_cells(&lwin) - before);
+}
+
+TEST(cursor_movement_repaints_two_rows)
+{
+	size_t before;
+
+	draw_dir_list(&lwin);
+
+	lwin.list_pos = 2;
+
+	before = fview_repainted_cells(&lwin);
+	draw_dir_list(&lwin);
+	assert_int_equal(2, fview_repainted_cells(&lwin) - before);
+}
+
+TEST(invalidation_repaints_everything)
+{
+	size_t before;
+
+	draw_dir_list(&lwin);
+
+	fview_invalidate(&lwin);
+
+	before = fview_repainted_cells(&lwin);
+	draw_dir_list(&lwin);
+	assert_int_equal(5, fview_repainted_cells(&lwin) - before);
+}
+
+TEST(erasing_window_repaints_everything)
+{
+	size_t before;
+
+	draw_dir_list(&lwin);
+
+	ui_view_erase(&lwin);
+
+	before = fview_repainted_cells(&lwin);
+	draw_dir_list(&lwin);
+	assert_int_equal(5, fview_repainted_cells(&lwin) - before);
+}
+
+TEST(resizing_window_repaints_everything)
+{
+	size_t before;
+
+	draw_dir_list(&lwin);
+
+	lwin.window_width = 30;
+
+	before = fview_repainted_cells(&lwin);
+	draw_dir_list(&lwin);
+	assert_int_equal(5, fview_repainted_cells(&lwin) - before);
+}
+
+TEST(freed_frame_is_recreated_on_redraw)
+{
+	draw_dir_list(&lwin);
+
+	fview_view_free_frame(&lwin);
+	assert_int_equal(0, fview_repainted_cells(&lwin));
+
+	draw_dir_list(&lwin);
+	assert_int_equal(5, fview_repainted_cells(&lwin));
+}
+
+TEST(link_state_is_not_queried_on_every_redraw, IF(not_windows))
+{
+	dir_entry_t *const entry = &lwin.dir_entry[1];
+
+	update_string(&cfg.slow_fs_list, "");
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	replace_string(&entry->name, "link");
+	entry->type = FT_LINK;
+
+	assert_success(symlink("target", SANDBOX_PATH "/link"));
+
+	draw_dir_list(&lwin);
+	assert_true(entry->link_checked);
+	assert_true(entry->broken_link);
+
+	create_file(SANDBOX_PATH "/target");
+
+	draw_dir_list(&lwin);
+	assert_true(entry->broken_link);
+
+	entry->link_checked = 0;
+	draw_dir_list(&lwin);
+	assert_true(entry->link_checked);
+	assert_false(entry->broken_link);
+	assert_true(entry->local_link);
+
+	assert_success(remove(SANDBOX_PATH "/target"));
+	assert_success(remove(SANDBOX_PATH "/link"));
+	update_string(&cfg.slow_fs_list, NULL);
+}
+
+TEST(replacing_color_scheme_resets_cached_highlights)
+{
+	char *error;
+	col_scheme_t cs = {};
+	const col_attr_t hi = { .fg = 1, .bg = -1, .attr = 0 };
+
+	cs_reset(&cfg.cs);
+	curr_stats.cs = &cfg.cs;
+	assert_success(cs_add_file_hi(matchers_alloc("{*.none}", 0, 1, "", &error),
+				&hi));
+
+	draw_dir_list(&lwin);
+	assert_true(cs_file_hi_is_cached(&cfg.cs, lwin.dir_entry[0].hi_num));
+
+	curr_stats.cs = &cs;
+	assert_success(cs_add_file_hi(matchers_alloc("{file*}", 0, 1, "", &error),
+				&hi));
+	cs_assign(&cfg.cs, &cs);
+	curr_stats.cs = &cfg.cs;
+
+	draw_dir_list(&lwin);
+	assert_int_equal(0, lwin.dir_entry[0].hi_num);
+
+	cs_reset(&cs);
+	cs_reset(&cfg.cs);
+}
+
+static void
+add_files_to_view(FileView *view, int count)
+{
+	int i;
+
+	view->list_rows = count;
+	view->list_pos = 0;
+	view->dir_entry = dynarray_cextend(NULL,
+			view->list_rows*sizeof(*view->dir_entry));
+
+	for(i = 0; i < count; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "file%d", i);
+
+		view->dir_entry[i].name = strdup(name);
+		view->dir_entry[i].origin = &view->curr_dir[0];
+		view->dir_entry[i].hi_num = -1;
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -623,5 +623,23 @@ TEST(values_in_sizefmt_are_deduplicated)
 			vle_tb_get_data(vle_err));
 }
 
+TEST(iothreads_accepts_only_values_in_range)
+{
+	assert_success(exec_commands("set iothreads=3", &lwin, CIT_COMMAND));
+	assert_int_equal(3, cfg.io_threads);
+
+	assert_failure(exec_commands("set iothreads=-1", &lwin, CIT_COMMAND));
+	assert_int_equal(3, cfg.io_threads);
+
+	assert_failure(exec_commands("set iothreads=100000", &lwin, CIT_COMMAND));
+	assert_int_equal(3, cfg.io_threads);
+
+	assert_success(exec_commands("set iothreads=16", &lwin, CIT_COMMAND));
+	assert_int_equal(16, cfg.io_threads);
+
+	assert_success(exec_commands("set iothreads=0", &lwin, CIT_COMMAND));
+	assert_int_equal(0, cfg.io_threads);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
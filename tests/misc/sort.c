@@ -3,7 +3,8 @@
 #include <unistd.h> /* chdir() unlink() */
 
 #include <locale.h> /* LC_ALL setlocale() */
-#include <string.h> /* memset() strcpy() */
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* memset() strcmp() strcpy() */
 
 #include "../../src/cfg/config.h"
 #include "../../src/ui/ui.h"
@@ -431,5 +432,41 @@ TEST(groups_sorting_works)
 	assert_string_equal("11-todo-publish", lwin.dir_entry[6].name);
 }
 
+TEST(sorting_of_large_lists_is_stable)
+{
+	int i;
+
+	view_teardown(&lwin);
+
+	lwin.list_rows = 10000;
+	lwin.dir_entry = dynarray_cextend(NULL,
+			lwin.list_rows*sizeof(*lwin.dir_entry));
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%05d", lwin.list_rows - 1 - i);
+		lwin.dir_entry[i].name = strdup(name);
+		lwin.dir_entry[i].type = FT_REG;
+		lwin.dir_entry[i].size = i%3;
+	}
+
+	lwin.sort[0] = SK_BY_SIZE;
+	lwin.sort[1] = -SK_BY_NAME;
+	memset(&lwin.sort[2], SK_NONE, sizeof(lwin.sort) - 2);
+
+	sort_view(&lwin);
+
+	for(i = 1; i < lwin.list_rows; ++i)
+	{
+		const dir_entry_t *const prev = &lwin.dir_entry[i - 1];
+		const dir_entry_t *const curr = &lwin.dir_entry[i];
+		assert_true(prev->size <= curr->size);
+		if(prev->size == curr->size)
+		{
+			assert_true(strcmp(prev->name, curr->name) > 0);
+		}
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -10,6 +10,7 @@
 #include "../../src/cfg/config.h"
 #include "../../src/compat/os.h"
 #include "../../src/engine/options.h"
+#include "../../src/ui/fileview.h"
 #include "../../src/ui/ui.h"
 #include "../../src/utils/dynarray.h"
 #include "../../src/utils/fswatch.h"
@@ -159,6 +160,9 @@ view_teardown(FileView *view)
 
 	fswatch_free(view->watch);
 	view->watch = NULL;
+	view->watch_tree = 0;
+
+	fview_view_free_frame(view);
 }
 
 void
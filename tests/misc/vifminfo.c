@@ -39,6 +39,7 @@ TEST(view_sorting_is_read_from_vifminfo)
 	opt_handlers_teardown();
 
 	assert_success(remove(SANDBOX_PATH "/vifminfo"));
+	cfg.config_dir[0] = '\0';
 }
 
 TEST(filetypes_are_deduplicated)
@@ -73,6 +74,7 @@ TEST(filetypes_are_deduplicated)
 	assert_true(first.st_size == second.st_size);
 
 	assert_success(remove(SANDBOX_PATH "/vifminfo"));
+	cfg.config_dir[0] = '\0';
 	reset_cmds();
 }
 
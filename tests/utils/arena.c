@@ -0,0 +1,97 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memset() strcmp() */
+
+#include "../../src/utils/arena.h"
+
+TEST(strings_are_copied)
+{
+	arena_t *const arena = arena_create();
+	char *const a = arena_strdup(arena, "a");
+	char *const b = arena_strdup(arena, "bb");
+
+	assert_string_equal("a", a);
+	assert_string_equal("bb", b);
+	assert_true(a != b);
+
+	arena_release(a);
+	arena_release(b);
+	arena_free(arena);
+}
+
+TEST(strings_outlive_arena)
+{
+	arena_t *const arena = arena_create();
+	char *const a = arena_strdup(arena, "a");
+	char *const b = arena_strdup(arena, "b");
+	arena_free(arena);
+
+	arena_release(a);
+	assert_string_equal("b", b);
+	arena_release(b);
+}
+
+TEST(referenced_string_is_kept)
+{
+	arena_t *const arena = arena_create();
+	char *const a = arena_strdup(arena, "a");
+	arena_free(arena);
+
+	arena_ref(a);
+	arena_release(a);
+	assert_string_equal("a", a);
+	arena_release(a);
+}
+
+TEST(many_strings_are_allocated)
+{
+	int i;
+	char *strs[10000];
+	arena_t *const arena = arena_create();
+
+	for(i = 0; i < (int)(sizeof(strs)/sizeof(strs[0])); ++i)
+	{
+		strs[i] = arena_strdup(arena, "some-file-name.ext");
+		assert_non_null(strs[i]);
+	}
+
+	for(i = 0; i < (int)(sizeof(strs)/sizeof(strs[0])); ++i)
+	{
+		assert_string_equal("some-file-name.ext", strs[i]);
+		arena_release(strs[i]);
+	}
+
+	arena_free(arena);
+}
+
+TEST(very_long_string_is_allocated)
+{
+	const size_t len = 100*1024;
+	char *const str = malloc(len + 1);
+	arena_t *const arena = arena_create();
+	char *copy, *short_copy;
+
+	memset(str, 'x', len);
+	str[len] = '\0';
+
+	copy = arena_strdup(arena, str);
+	assert_true(strcmp(str, copy) == 0);
+	short_copy = arena_strdup(arena, "a");
+	assert_string_equal("a", short_copy);
+
+	arena_release(copy);
+	arena_release(short_copy);
+	arena_free(arena);
+	free(str);
+}
+
+TEST(null_is_handled)
+{
+	arena_release(NULL);
+	arena_free(NULL);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -1,6 +1,9 @@
 #include <stic.h>
 
+#include <sys/stat.h> /* stat */
+
 #include <stdio.h> /* remove() snprintf() */
+#include <time.h> /* time_t time() */
 
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
@@ -8,9 +11,12 @@
 #include "../../src/utils/fswatch.h"
 #include "../../src/utils/path.h"
 
+static time_t fake_time(time_t *t);
 static int using_inotify(void);
 
 static char sandbox[PATH_MAX];
+/* Value returned by fake_time(). */
+static time_t fake_now;
 
 SETUP_ONCE()
 {
@@ -121,6 +127,51 @@ TEST(to_many_events_causes_banning_of_same_events, IF(using_inotify))
 	fswatch_free(watch);
 }
 
+TEST(changes_during_ban_are_reported_after_it, IF(using_inotify))
+{
+	fswatch_t *watch;
+	const fswatch_event_t *events;
+	int error;
+	int count;
+	int i;
+
+	fake_now = time(NULL);
+	fswatch_set_clock(&fake_time);
+
+	assert_non_null(watch = fswatch_create(sandbox));
+
+	os_mkdir(SANDBOX_PATH "/testdir", 0700);
+
+	for(i = 0; i < 100; ++i)
+	{
+		os_chmod(SANDBOX_PATH "/testdir", 0777);
+		os_chmod(SANDBOX_PATH "/testdir", 0000);
+		(void)fswatch_changed(watch, &error);
+	}
+
+	os_chmod(SANDBOX_PATH "/testdir", 0777);
+	assert_false(fswatch_changed(watch, &error));
+	assert_false(error);
+
+	/* Ban lasts for several seconds. */
+	fake_now += 6;
+
+	assert_true(fswatch_changed(watch, &error));
+	assert_false(error);
+	assert_non_null(events = fswatch_get_events(watch, &count));
+	assert_int_equal(1, count);
+	assert_string_equal("testdir", events[0].name);
+	assert_int_equal(FSWE_CHANGED, events[0].kind);
+
+	assert_false(fswatch_changed(watch, &error));
+	assert_false(error);
+
+	fswatch_free(watch);
+	fswatch_set_clock(&time);
+
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+}
+
 TEST(file_recreation_removes_ban, IF(using_inotify))
 {
 	fswatch_t *watch;
@@ -155,6 +206,155 @@ TEST(file_recreation_removes_ban, IF(using_inotify))
 	assert_success(remove(SANDBOX_PATH "/testdir"));
 }
 
+TEST(changes_of_files_are_reported, IF(using_inotify))
+{
+	fswatch_t *watch;
+	const fswatch_event_t *events;
+	int error;
+	int count;
+
+	assert_non_null(watch = fswatch_create(sandbox));
+
+	assert_success(os_mkdir(SANDBOX_PATH "/testdir", 0700));
+	assert_true(fswatch_changed(watch, &error));
+	assert_false(error);
+
+	assert_non_null(events = fswatch_get_events(watch, &count));
+	assert_int_equal(1, count);
+	assert_string_equal("testdir", events[0].name);
+	assert_int_equal(FSWE_CREATED, events[0].kind);
+
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+	assert_true(fswatch_changed(watch, &error));
+	assert_false(error);
+
+	assert_non_null(events = fswatch_get_events(watch, &count));
+	assert_int_equal(1, count);
+	assert_string_equal("testdir", events[0].name);
+	assert_int_equal(FSWE_DELETED, events[0].kind);
+
+	fswatch_free(watch);
+}
+
+TEST(events_of_the_same_file_are_merged, IF(using_inotify))
+{
+	fswatch_t *watch;
+	const fswatch_event_t *events;
+	int error;
+	int count;
+
+	assert_non_null(watch = fswatch_create(sandbox));
+
+	assert_success(os_mkdir(SANDBOX_PATH "/testdir", 0700));
+	assert_success(os_chmod(SANDBOX_PATH "/testdir", 0777));
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+	assert_true(fswatch_changed(watch, &error));
+	assert_false(error);
+
+	assert_non_null(events = fswatch_get_events(watch, &count));
+	assert_int_equal(1, count);
+	assert_string_equal("testdir", events[0].name);
+	assert_int_equal(FSWE_CREATED, events[0].kind);
+
+	fswatch_free(watch);
+}
+
+TEST(changes_of_directory_itself_make_events_unavailable, IF(using_inotify))
+{
+	fswatch_t *watch;
+	struct stat st;
+	int error;
+	int count;
+
+	assert_success(os_stat(SANDBOX_PATH, &st));
+	assert_non_null(watch = fswatch_create(sandbox));
+
+	assert_success(os_chmod(SANDBOX_PATH, 0777));
+	assert_true(fswatch_changed(watch, &error));
+	assert_false(error);
+	assert_null(fswatch_get_events(watch, &count));
+
+	fswatch_free(watch);
+	assert_success(os_chmod(SANDBOX_PATH, st.st_mode & 07777));
+}
+
+TEST(changes_in_added_directories_are_detected, IF(using_inotify))
+{
+	fswatch_t *watch;
+	int error;
+	int count;
+
+	assert_success(os_mkdir(SANDBOX_PATH "/testdir", 0700));
+
+	assert_non_null(watch = fswatch_create(sandbox));
+	assert_success(fswatch_add(watch, SANDBOX_PATH "/testdir"));
+
+	assert_success(os_mkdir(SANDBOX_PATH "/testdir/nested", 0700));
+	assert_true(fswatch_changed(watch, &error));
+	assert_false(error);
+	/* Changes in subdirectories aren't described in detail. */
+	assert_null(fswatch_get_events(watch, &count));
+
+	assert_false(fswatch_changed(watch, &error));
+	assert_false(error);
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/testdir/nested"));
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+}
+
+TEST(changed_directories_are_reported, IF(using_inotify))
+{
+	fswatch_t *watch;
+	int error;
+	int count;
+	const char *const *dirs;
+
+	assert_success(os_mkdir(SANDBOX_PATH "/dir1", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/dir2", 0700));
+
+	assert_non_null(watch = fswatch_create(sandbox));
+	assert_success(fswatch_add(watch, SANDBOX_PATH "/dir1"));
+	assert_success(fswatch_add(watch, SANDBOX_PATH "/dir2"));
+
+	assert_success(os_mkdir(SANDBOX_PATH "/dir2/a", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/dir2/b", 0700));
+	assert_true(fswatch_changed(watch, &error));
+	assert_false(error);
+
+	assert_non_null(dirs = fswatch_get_dirs(watch, &count));
+	assert_int_equal(1, count);
+	assert_string_equal(SANDBOX_PATH "/dir2", dirs[0]);
+
+	assert_success(os_mkdir(SANDBOX_PATH "/c", 0700));
+	assert_true(fswatch_changed(watch, &error));
+	assert_false(error);
+
+	assert_non_null(dirs = fswatch_get_dirs(watch, &count));
+	assert_int_equal(1, count);
+	assert_string_equal(sandbox, dirs[0]);
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/c"));
+	assert_success(remove(SANDBOX_PATH "/dir2/a"));
+	assert_success(remove(SANDBOX_PATH "/dir2/b"));
+	assert_success(remove(SANDBOX_PATH "/dir1"));
+	assert_success(remove(SANDBOX_PATH "/dir2"));
+}
+
+/* Replacement of time() that returns value of fake_now.  Returns the value. */
+static time_t
+fake_time(time_t *t)
+{
+	if(t != NULL)
+	{
+		*t = fake_now;
+	}
+	return fake_now;
+}
+
 static int
 using_inotify(void)
 {
@@ -0,0 +1,157 @@
+#include <stic.h>
+
+#include <regex.h> /* regcomp() regexec() regfree() */
+
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() */
+
+#include "../../src/utils/globs.h"
+#include "../../src/utils/macros.h"
+
+static void check_names(const char globs[]);
+static void check_same_as_regex(const char globs[], const char *names[],
+		int count);
+
+/* Names that are matched against globs in tests. */
+static const char *test_names[] = {
+	"", "a", "A", ".", "..", ".a", "a.", "file.c", "FILE.C", "file.cc", ".file.c",
+	"file.c.bak", "archive.tar.gz", "archive.TAR.GZ", "tar.gz", ".tar.gz",
+	"README", "readme.md", "ReadMe.txt", "Makefile", "makefile.am", "vimrc",
+	".vimrc", "a.vimrc", "x{y}z", "a+b", "a|b", "(a)", "^a$", "a.b.c.d",
+	"file.ext", "file.exT", "file.ext/", "dir/file.ext", "ab", "abc", "abcd",
+};
+
+TEST(unsupported_globs_are_not_compiled)
+{
+	assert_null(globs_compile("*.[ch]"));
+	assert_null(globs_compile("*.c,a\\*"));
+	assert_null(globs_compile("*.\xd1\x84"));
+}
+
+TEST(freeing_null_globs_is_ok)
+{
+	globs_free(NULL);
+}
+
+TEST(extensions_are_matched_like_regex)
+{
+	check_names("*.c");
+	check_names("*.c,*.tar.gz,*.ext");
+	check_names("*.");
+	check_names("*.vimrc,*.C");
+}
+
+TEST(literals_prefixes_and_suffixes_are_matched_like_regex)
+{
+	check_names("readme,makefile");
+	check_names("readme*,.*");
+	check_names("*rc,*");
+	check_names("x{y}z,a+b,a|b,(a),^a$");
+}
+
+TEST(wildcards_are_matched_like_regex)
+{
+	check_names("?");
+	check_names("??,?*");
+	check_names("*.tar.*,*.*.*");
+	check_names("a*c,a?c,*b*,**");
+	check_names("*/*,?ake*,*.e?t");
+	check_names(",,*.c,,");
+}
+
+TEST(question_mark_matches_whole_character)
+{
+	globs_t *const globs = globs_compile("?.txt,a?b");
+	assert_non_null(globs);
+
+	assert_true(globs_matches(globs, "\xd1\x84.txt"));
+	assert_true(globs_matches(globs, "a\xe2\x82\xac" "b"));
+	assert_false(globs_matches(globs, "a\xe2\x82\xac\xe2\x82\xac" "b"));
+
+	globs_free(globs);
+}
+
+TEST(large_configuration_is_matched_like_regex)
+{
+	static const char *exts[] = {
+		"jpg", "jpeg", "png", "gif", "bmp", "svg", "mp3", "flac", "ogg", "wav",
+		"avi", "mkv", "mp4", "webm", "pdf", "djvu", "ps", "txt", "md", "c", "h",
+		"cpp", "hpp", "py", "sh", "tar", "gz", "bz2", "xz", "zip", "7z", "rar",
+		"deb", "rpm", "iso", "html", "css", "js", "json", "xml",
+	};
+	static const char *bases[] = {
+		"file", "IMG_0001", "Makefile", ".hidden", "archive.tar", "readme",
+		"a", "x.y", "notes-2016",
+	};
+
+	char rules[300][128];
+	const char *list[ARRAY_LEN(bases)*ARRAY_LEN(exts)*2];
+	char names_buf[ARRAY_LEN(list)][64];
+	size_t i;
+	int count = 0;
+
+	for(i = 0U; i < ARRAY_LEN(rules); ++i)
+	{
+		const char *const a = exts[i%ARRAY_LEN(exts)];
+		const char *const b = exts[(i*7U + 3U)%ARRAY_LEN(exts)];
+		switch(i%6U)
+		{
+			case 0: snprintf(rules[i], sizeof(rules[i]), "*.%s", a); break;
+			case 1: snprintf(rules[i], sizeof(rules[i]), "*.%s,*.%s", a, b); break;
+			case 2: snprintf(rules[i], sizeof(rules[i]), "*.%s.%s", a, b); break;
+			case 3: snprintf(rules[i], sizeof(rules[i]), "%s*,*%s", a, b); break;
+			case 4: snprintf(rules[i], sizeof(rules[i]), "*.%s.*,?%s", a, b); break;
+			case 5: snprintf(rules[i], sizeof(rules[i]), "f*.%s,*-*.%s", a, b); break;
+		}
+	}
+
+	for(i = 0U; i < ARRAY_LEN(list); ++i)
+	{
+		const char *const base = bases[(i/2U)%ARRAY_LEN(bases)];
+		const char *const ext = exts[(i/2U)/ARRAY_LEN(bases)];
+		snprintf(names_buf[i], sizeof(names_buf[i]), (i%2U == 0U) ? "%s.%s" :
+				"%s.%s.BAK", base, ext);
+		list[count++] = names_buf[i];
+	}
+
+	for(i = 0U; i < ARRAY_LEN(rules); ++i)
+	{
+		check_same_as_regex(rules[i], list, count);
+	}
+}
+
+/* Checks globs against test_names, see check_same_as_regex(). */
+static void
+check_names(const char globs[])
+{
+	check_same_as_regex(globs, test_names, ARRAY_LEN(test_names));
+}
+
+/* Checks that compiled globs produce the same results as regular expression
+ * they are translated into. */
+static void
+check_same_as_regex(const char globs[], const char *names[], int count)
+{
+	int i;
+	regex_t re;
+	char *const regex = globs_to_regex(globs);
+	globs_t *const compiled = globs_compile(globs);
+
+	assert_non_null(regex);
+	assert_non_null(compiled);
+	assert_success(regcomp(&re, regex, REG_EXTENDED | REG_ICASE));
+
+	for(i = 0; i < count; ++i)
+	{
+		const int expected = (regexec(&re, names[i], 0, NULL, 0) == 0);
+		assert_int_equal(expected, globs_matches(compiled, names[i]));
+	}
+
+	regfree(&re);
+	globs_free(compiled);
+	free(regex);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
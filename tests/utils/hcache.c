@@ -0,0 +1,180 @@
+#include <stic.h>
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() remove() */
+
+#include "../../src/utils/hcache.h"
+
+#define CACHE SANDBOX_PATH "/cache"
+
+static const hcache_key_t key = { 1, 2, 3, 4, 5 };
+
+TEARDOWN()
+{
+	(void)remove(CACHE);
+}
+
+TEST(null_cache_is_handled)
+{
+	hcache_value_t value = { 1, 2, 1, 1 };
+
+	assert_failure(hcache_get(NULL, &key, &value));
+	hcache_put(NULL, &key, &value);
+	assert_success(hcache_close(NULL));
+}
+
+TEST(missing_file_means_empty_cache)
+{
+	hcache_value_t value;
+	hcache_t *const cache = hcache_open(CACHE, 0);
+
+	assert_non_null(cache);
+	assert_failure(hcache_get(cache, &key, &value));
+	assert_success(hcache_close(cache));
+
+	/* Nothing to save. */
+	assert_failure(remove(CACHE));
+}
+
+TEST(values_are_merged)
+{
+	hcache_value_t sample = { .sample = 10, .has_sample = 1 };
+	hcache_value_t full = { .full = 20, .has_full = 1 };
+	hcache_value_t value;
+	hcache_t *const cache = hcache_open(CACHE, 0);
+
+	hcache_put(cache, &key, &sample);
+	hcache_put(cache, &key, &full);
+
+	assert_success(hcache_get(cache, &key, &value));
+	assert_true(value.has_sample);
+	assert_true(value.has_full);
+	assert_int_equal(10, value.sample);
+	assert_int_equal(20, value.full);
+
+	assert_success(hcache_close(cache));
+}
+
+TEST(values_are_persisted)
+{
+	int i;
+	hcache_value_t value = { .sample = 10, .full = 20, .has_full = 1 };
+	hcache_t *cache = hcache_open(CACHE, 0);
+
+	for(i = 0; i < 100; ++i)
+	{
+		hcache_key_t k = key;
+		k.ino = 100 - i;
+		value.full = 100 - i;
+		hcache_put(cache, &k, &value);
+	}
+	assert_success(hcache_close(cache));
+
+	cache = hcache_open(CACHE, 0);
+	for(i = 0; i < 100; ++i)
+	{
+		hcache_key_t k = key;
+		k.ino = i + 1;
+		assert_success(hcache_get(cache, &k, &value));
+		assert_false(value.has_sample);
+		assert_true(value.has_full);
+		assert_int_equal(i + 1, value.full);
+	}
+	assert_success(hcache_close(cache));
+}
+
+TEST(outdated_record_is_dropped)
+{
+	hcache_key_t changed = key;
+	hcache_value_t value = { .sample = 10, .has_sample = 1 };
+	hcache_t *cache = hcache_open(CACHE, 0);
+	hcache_put(cache, &key, &value);
+	assert_success(hcache_close(cache));
+
+	changed.mtime = 100;
+
+	cache = hcache_open(CACHE, 0);
+	assert_failure(hcache_get(cache, &changed, &value));
+	assert_success(hcache_close(cache));
+
+	cache = hcache_open(CACHE, 0);
+	assert_failure(hcache_get(cache, &key, &value));
+	assert_failure(hcache_get(cache, &changed, &value));
+	assert_success(hcache_close(cache));
+}
+
+TEST(records_are_updated)
+{
+	hcache_value_t value = { .sample = 10, .has_sample = 1 };
+	hcache_t *cache = hcache_open(CACHE, 0);
+	hcache_put(cache, &key, &value);
+	assert_success(hcache_close(cache));
+
+	value.sample = 20;
+
+	cache = hcache_open(CACHE, 0);
+	hcache_put(cache, &key, &value);
+	assert_success(hcache_close(cache));
+
+	cache = hcache_open(CACHE, 0);
+	assert_success(hcache_get(cache, &key, &value));
+	assert_int_equal(20, value.sample);
+	assert_success(hcache_close(cache));
+}
+
+TEST(file_with_different_tag_is_ignored)
+{
+	hcache_value_t value = { .sample = 10, .has_sample = 1 };
+	hcache_t *cache = hcache_open(CACHE, 1);
+	hcache_put(cache, &key, &value);
+	assert_success(hcache_close(cache));
+
+	cache = hcache_open(CACHE, 2);
+	assert_failure(hcache_get(cache, &key, &value));
+	assert_success(hcache_close(cache));
+}
+
+TEST(broken_file_is_ignored)
+{
+	hcache_value_t value = { .sample = 10, .has_sample = 1 };
+	hcache_t *cache;
+	FILE *const fp = fopen(CACHE, "w");
+	fputs("this isn't a cache file, but it's long enough to look like one", fp);
+	fclose(fp);
+
+	cache = hcache_open(CACHE, 0);
+	assert_failure(hcache_get(cache, &key, &value));
+	hcache_put(cache, &key, &value);
+	assert_success(hcache_close(cache));
+
+	cache = hcache_open(CACHE, 0);
+	assert_success(hcache_get(cache, &key, &value));
+	assert_success(hcache_close(cache));
+}
+
+TEST(key_reflects_changes_of_file)
+{
+	hcache_key_t a, b;
+	FILE *fp = fopen(CACHE, "w");
+	fclose(fp);
+
+	assert_success(hcache_key_from_file(CACHE, &a));
+	assert_int_equal(0, a.size);
+
+	fp = fopen(CACHE, "a");
+	fputs("text", fp);
+	fclose(fp);
+
+	assert_success(hcache_key_from_file(CACHE, &b));
+	assert_int_equal(4, b.size);
+	assert_true(a.dev == b.dev);
+	assert_true(a.ino == b.ino);
+}
+
+TEST(key_of_missing_file_is_not_formed)
+{
+	hcache_key_t k;
+	assert_failure(hcache_key_from_file(CACHE, &k));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,164 @@
+#include <stic.h>
+
+#include <stddef.h> /* size_t */
+#include <string.h> /* memset() */
+#include <unistd.h> /* usleep() */
+
+#include "../../src/utils/parallel.h"
+
+static void mark_range(size_t from, size_t to, void *arg);
+static void mark_subtree(par_queue_t *queue, void *task, void *arg);
+static void mark_slowly(par_queue_t *queue, void *task, void *arg);
+static int never_cancel(void *arg);
+static int always_cancel(void *arg);
+
+static int marks[1000];
+
+SETUP()
+{
+	memset(marks, 0, sizeof(marks));
+}
+
+TEST(number_of_threads_is_positive)
+{
+	assert_true(par_get_nthreads() > 0);
+}
+
+TEST(empty_range_is_ok)
+{
+	par_for(0U, 10U, 0, &mark_range, marks);
+}
+
+TEST(every_item_is_processed_once_on_single_thread)
+{
+	int i;
+
+	par_for(sizeof(marks)/sizeof(marks[0]), 7U, 1, &mark_range, marks);
+
+	for(i = 0; i < (int)(sizeof(marks)/sizeof(marks[0])); ++i)
+	{
+		assert_int_equal(1, marks[i]);
+	}
+}
+
+TEST(every_item_is_processed_once_on_multiple_threads)
+{
+	int i;
+
+	par_for(sizeof(marks)/sizeof(marks[0]), 7U, 4, &mark_range, marks);
+
+	for(i = 0; i < (int)(sizeof(marks)/sizeof(marks[0])); ++i)
+	{
+		assert_int_equal(1, marks[i]);
+	}
+}
+
+TEST(zero_chunk_size_is_handled)
+{
+	int i;
+
+	par_for(10U, 0U, 0, &mark_range, marks);
+
+	for(i = 0; i < 10; ++i)
+	{
+		assert_int_equal(1, marks[i]);
+	}
+	assert_int_equal(0, marks[10]);
+}
+
+TEST(every_task_is_processed_once_on_single_thread)
+{
+	int i;
+
+	assert_int_equal(0, par_run(&marks[0], 1, &mark_subtree, NULL, marks));
+
+	for(i = 0; i < (int)(sizeof(marks)/sizeof(marks[0])); ++i)
+	{
+		assert_int_equal(1, marks[i]);
+	}
+}
+
+TEST(every_task_is_processed_once_on_multiple_threads)
+{
+	int i;
+
+	assert_int_equal(0,
+			par_run(&marks[0], 4, &mark_subtree, &never_cancel, marks));
+
+	for(i = 0; i < (int)(sizeof(marks)/sizeof(marks[0])); ++i)
+	{
+		assert_int_equal(1, marks[i]);
+	}
+}
+
+TEST(processing_of_tasks_can_be_cancelled)
+{
+	assert_true(par_run(&marks[0], 1, &mark_slowly, &always_cancel, marks) != 0);
+	assert_int_equal(0, marks[sizeof(marks)/sizeof(marks[0]) - 1]);
+}
+
+/* par_for() callback that increments elements of an integer array. */
+static void
+mark_range(size_t from, size_t to, void *arg)
+{
+	int *const marks = arg;
+	while(from < to)
+	{
+		++marks[from++];
+	}
+}
+
+/* par_run() callback that marks element of an array and queues its children in
+ * a binary tree built on top of the array. */
+static void
+mark_subtree(par_queue_t *queue, void *task, void *arg)
+{
+	int *const items = arg;
+	const size_t i = (int *)task - items;
+	const size_t n = sizeof(marks)/sizeof(marks[0]);
+
+	++items[i];
+
+	if(2*i + 1 < n)
+	{
+		assert_success(par_push(queue, &items[2*i + 1]));
+	}
+	if(2*i + 2 < n)
+	{
+		assert_success(par_push(queue, &items[2*i + 2]));
+	}
+}
+
+/* par_run() callback that marks element of an array and queues the next one
+ * after a delay. */
+static void
+mark_slowly(par_queue_t *queue, void *task, void *arg)
+{
+	int *const items = arg;
+	const size_t i = (int *)task - items;
+
+	usleep(50000);
+	++items[i];
+
+	if(i + 1 < sizeof(marks)/sizeof(marks[0]))
+	{
+		(void)par_push(queue, &items[i + 1]);
+	}
+}
+
+/* par_run() callback that never requests cancellation. */
+static int
+never_cancel(void *arg)
+{
+	return 0;
+}
+
+/* par_run() callback that always requests cancellation. */
+static int
+always_cancel(void *arg)
+{
+	return 1;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
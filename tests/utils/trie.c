@@ -1,6 +1,7 @@
 #include <stic.h>
 
 #include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* free() */
 #include <string.h> /* strdup() */
 
@@ -164,5 +165,51 @@ TEST(trie_cloning_works)
 	trie_free(trie);
 }
 
+TEST(cloned_trie_keeps_data)
+{
+	void *data;
+	trie_t *const trie = trie_create();
+	trie_t *clone;
+
+	assert_int_equal(0, trie_set(trie, "str", trie));
+
+	clone = trie_clone(trie);
+	trie_free(trie);
+
+	assert_success(trie_get(clone, "str", &data));
+	assert_true(data == trie);
+
+	trie_free(clone);
+}
+
+/* This also serves as a benchmark of insertion and lookup. */
+TEST(million_of_paths)
+{
+	int i;
+	char path[64];
+	void *data;
+	trie_t *const trie = trie_create();
+
+	for(i = 0; i < 1000000; ++i)
+	{
+		snprintf(path, sizeof(path), "/home/user/dir%03d/sub%02d/file%06d.c",
+				i%1000, i%37, i);
+		assert_int_equal(0, trie_set(trie, path, (void *)(size_t)i));
+	}
+
+	for(i = 0; i < 1000000; ++i)
+	{
+		snprintf(path, sizeof(path), "/home/user/dir%03d/sub%02d/file%06d.c",
+				i%1000, i%37, i);
+		assert_success(trie_get(trie, path, &data));
+		assert_true((size_t)data == (size_t)i);
+	}
+
+	assert_failure(trie_get(trie, "/home/user/dir000/sub00/file000001.c",
+				&data));
+
+	trie_free(trie);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */